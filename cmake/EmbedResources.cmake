@@ -0,0 +1,51 @@
+# Script mode: cmake -DOUTPUT=<file.cpp> -DFILES=<a|b|...> -P EmbedResources.cmake
+# Writes a table of Utils::EmbeddedResources for the files, keyed by file name
+
+string(REPLACE "|" ";" FILES "${FILES}")
+
+string(REPEAT "0x[0-9a-f][0-9a-f]," 16 LINE_PATTERN)
+
+set(ARRAYS "")
+set(ENTRIES "")
+set(INDEX 0)
+
+foreach(FILE ${FILES})
+    get_filename_component(NAME ${FILE} NAME)
+
+    file(READ ${FILE} HEX_CONTENTS HEX)
+    string(LENGTH "${HEX_CONTENTS}" HEX_LENGTH)
+    math(EXPR SIZE "${HEX_LENGTH} / 2")
+
+    # 16 bytes per line, terminated with zero to use the contents as C string
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," BYTES "${HEX_CONTENTS}")
+    string(REGEX REPLACE "(${LINE_PATTERN})" "\\1\n    " BYTES "${BYTES}")
+
+    string(APPEND ARRAYS "// ${NAME}\nconst unsigned char Resource${INDEX}[] = {\n    ${BYTES}0x00\n};\n\n")
+    string(APPEND ENTRIES "    {\"${NAME}\", reinterpret_cast<const char*>(Resource${INDEX}), ${SIZE}},\n")
+
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+set(CONTENTS "// Generated by EmbedResources.cmake, do not edit
+
+#include <cstddef>
+#include <string>
+#include \"EmbeddedResources.h\"
+
+namespace {
+
+${ARRAYS}} // namespace
+
+const Utils::EmbeddedResources::Resource Utils::EmbeddedResources::ResourceTable[] = {
+${ENTRIES}    {nullptr, nullptr, 0}
+};
+")
+
+# Keep the timestamp if nothing has changed to avoid recompilation
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} OLD_CONTENTS)
+endif ()
+
+if (NOT "${OLD_CONTENTS}" STREQUAL "${CONTENTS}")
+    file(WRITE ${OUTPUT} "${CONTENTS}")
+endif ()
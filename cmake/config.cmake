@@ -43,9 +43,11 @@ macro(make_executable)
     install(
         TARGETS ${PROJECT}
         DESTINATION ${CMAKE_INSTALL_PREFIX})
-    install(
-        DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}/data"
-        DESTINATION ${CMAKE_INSTALL_PREFIX})
+    if (EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/data")
+        install(
+            DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}/data"
+            DESTINATION ${CMAKE_INSTALL_PREFIX})
+    endif ()
 endmacro()
 
 macro(make_library)
@@ -70,3 +72,21 @@ function(add_all_subdirectories)
         endif ()
     endforeach ()
 endfunction()
+
+# Compile files into the target, they are available via Utils::EmbeddedResources
+function(embed_resources TARGET)
+    set(OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}Resources.cpp)
+    string(REPLACE ";" "|" FILES "${ARGN}")
+
+    add_custom_command(
+        OUTPUT ${OUTPUT}
+        COMMAND ${CMAKE_COMMAND} -DOUTPUT=${OUTPUT} -DFILES=${FILES}
+            -P ${CMAKE_SOURCE_DIR}/cmake/EmbedResources.cmake
+        DEPENDS ${ARGN} ${CMAKE_SOURCE_DIR}/cmake/EmbedResources.cmake
+        COMMENT "Embedding resources into ${TARGET}"
+        VERBATIM)
+
+    target_sources(${TARGET} PRIVATE ${OUTPUT})
+    target_include_directories(${TARGET} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR})
+    source_group("Generated Files" FILES ${OUTPUT})
+endfunction()
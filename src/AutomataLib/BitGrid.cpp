@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+
+
+namespace CellularAutomata {
+
+BitGrid::BitGrid(int width, int height) {
+    Resize(width, height);
+}
+
+void BitGrid::Resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    wordsPerRow_ = (static_cast<size_t>(width) + WordBits - 1) / WordBits;
+
+    words_.assign(wordsPerRow_ * height_, 0);
+}
+
+void BitGrid::Clear() {
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+int BitGrid::GetWidth() const {
+    return width_;
+}
+
+int BitGrid::GetHeight() const {
+    return height_;
+}
+
+size_t BitGrid::GetWordsPerRow() const {
+    return wordsPerRow_;
+}
+
+bool BitGrid::Get(int x, int y) const {
+    const Word* row = GetRow(y);
+    return (row[x / WordBits] >> (x % WordBits)) & 1;
+}
+
+void BitGrid::Set(int x, int y, bool alive) {
+    Word* row = GetRow(y);
+    Word mask = Word(1) << (x % WordBits);
+    if (alive) {
+        row[x / WordBits] |= mask;
+    }
+    else {
+        row[x / WordBits] &= ~mask;
+    }
+}
+
+void BitGrid::SetRange(int x0, int x1, int y) {
+    if (x0 >= x1) {
+        return;
+    }
+
+    Word* row = GetRow(y);
+
+    int firstWord = x0 / WordBits;
+    int lastWord = (x1 - 1) / WordBits;
+
+    Word firstMask = ~Word(0) << (x0 % WordBits);
+    Word lastMask = ~Word(0) >> (WordBits - 1 - (x1 - 1) % WordBits);
+
+    if (firstWord == lastWord) {
+        row[firstWord] |= firstMask & lastMask;
+        return;
+    }
+
+    row[firstWord] |= firstMask;
+    for (int i = firstWord + 1; i < lastWord; i++) {
+        row[i] = ~Word(0);
+    }
+    row[lastWord] |= lastMask;
+}
+
+void BitGrid::OrBits(int64_t x, int y, Word bits, int count) {
+    if (x < 0) {
+        if (x <= -count) {
+            return;
+        }
+        bits >>= -x;
+        count += static_cast<int>(x);
+        x = 0;
+    }
+    if (x >= width_) {
+        return;
+    }
+    count = static_cast<int>(std::min<int64_t>(count, width_ - x));
+    if (count < WordBits) {
+        bits &= (Word(1) << count) - 1;
+    }
+
+    Word* row = GetRow(y);
+    int shift = static_cast<int>(x % WordBits);
+    row[x / WordBits] |= bits << shift;
+    if (shift + count > WordBits) {
+        row[x / WordBits + 1] |= bits >> (WordBits - shift);
+    }
+}
+
+BitGrid::Word* BitGrid::GetRow(int y) {
+    return words_.data() + wordsPerRow_ * y;
+}
+
+const BitGrid::Word* BitGrid::GetRow(int y) const {
+    return words_.data() + wordsPerRow_ * y;
+}
+
+BitGrid::Word* BitGrid::GetData() {
+    return words_.data();
+}
+
+const BitGrid::Word* BitGrid::GetData() const {
+    return words_.data();
+}
+
+size_t BitGrid::GetDataSize() const {
+    return words_.size();
+}
+
+void BitGrid::Unpack(uint8_t* dst, uint8_t value) const {
+    for (int y = 0; y < height_; y++) {
+        const Word* row = GetRow(y);
+        for (int x = 0; x < width_; x++) {
+            *dst++ = ((row[x / WordBits] >> (x % WordBits)) & 1) ? value : 0;
+        }
+    }
+}
+
+void BitGrid::Pack(const uint8_t* src) {
+    Clear();
+    for (int y = 0; y < height_; y++) {
+        Word* row = GetRow(y);
+        for (int x = 0; x < width_; x++) {
+            if (*src++) {
+                row[x / WordBits] |= Word(1) << (x % WordBits);
+            }
+        }
+    }
+}
+
+size_t BitGrid::GetPopulation() const {
+    size_t population = 0;
+    for (Word w : words_) {
+        population += std::bitset<WordBits>(w).count();
+    }
+    return population;
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,82 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Memory of the grid words, large grids follow the policy of GridMemory.h
+    void* AllocateGridMemory(size_t bytes);
+    void FreeGridMemory(void* data, size_t bytes);
+
+    template <typename T>
+    struct GridAllocator {
+        using value_type = T;
+
+        GridAllocator() = default;
+        template <typename U>
+        GridAllocator(const GridAllocator<U>&) {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(AllocateGridMemory(count * sizeof(T)));
+        }
+        void deallocate(T* data, size_t count) {
+            FreeGridMemory(data, count * sizeof(T));
+        }
+
+        template <typename U>
+        bool operator==(const GridAllocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const GridAllocator<U>&) const { return false; }
+    };
+
+    // Grid of cells packed into 64-bit words, bit i of word j of a row is the cell x = 64 * j + i.
+    // Rows are padded to whole words, padding bits are always zero.
+    // Row 0 is the bottom one, as in OpenGL textures.
+    class BitGrid {
+    public:
+        using Word = uint64_t;
+        static constexpr int WordBits = 64;
+
+    public:
+        BitGrid() = default;
+        BitGrid(int width, int height);
+
+        // Contents are cleared
+        void Resize(int width, int height);
+        void Clear();
+
+        int GetWidth() const;
+        int GetHeight() const;
+        size_t GetWordsPerRow() const;
+
+        bool Get(int x, int y) const;
+        void Set(int x, int y, bool alive);
+
+        // Set cells [x0, x1) of the row alive
+        void SetRange(int x0, int x1, int y);
+
+        // Set cells [x, x + count) of the row alive where bits [0, count) are set.
+        // Up to 64 cells, cells outside of the grid are skipped.
+        void OrBits(int64_t x, int y, Word bits, int count);
+
+        Word* GetRow(int y);
+        const Word* GetRow(int y) const;
+
+        Word* GetData();
+        const Word* GetData() const;
+        size_t GetDataSize() const;
+
+        // Unpack into one byte per cell, row by row, alive cells are set to the value
+        void Unpack(uint8_t* dst, uint8_t value) const;
+
+        // Pack one byte per cell, row by row, non-zero cells are alive
+        void Pack(const uint8_t* src);
+
+        size_t GetPopulation() const;
+
+    private:
+        int width_{ 0 };
+        int height_{ 0 };
+        size_t wordsPerRow_{ 0 };
+        std::vector<Word, GridAllocator<Word>> words_;
+    };
+
+}
@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "LifeKernel.h"
+#include "BlockEngine.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::BlockEngine;
+using CellularAutomata::GenerationStats;
+
+// Smaller grids are stepped faster than the threads are started
+constexpr size_t ParallelBlockMinWords = 16 * 1024;
+
+constexpr BitGrid::Word BlockColumnFirst = 0x0101010101010101ull;
+constexpr BitGrid::Word BlockColumnLast = 0x8080808080808080ull;
+
+// Each cell of the block gets the cell at y + 1, the top row comes from the bottom row of the block above
+inline BitGrid::Word GetBlockAbove(BitGrid::Word block, BitGrid::Word above) {
+    return (block >> BlockEngine::BlockSize) | (above << (BitGrid::WordBits - BlockEngine::BlockSize));
+}
+
+// Each cell of the block gets the cell at y - 1
+inline BitGrid::Word GetBlockBelow(BitGrid::Word block, BitGrid::Word below) {
+    return (block << BlockEngine::BlockSize) | (below >> (BitGrid::WordBits - BlockEngine::BlockSize));
+}
+
+// Each cell of the block gets the cell at x - 1, the first column comes from the last one of the block on the west
+inline BitGrid::Word GetBlockWest(BitGrid::Word block, BitGrid::Word west) {
+    return ((block << 1) & ~BlockColumnFirst) | ((west >> (BlockEngine::BlockSize - 1)) & BlockColumnFirst);
+}
+
+// Each cell of the block gets the cell at x + 1
+inline BitGrid::Word GetBlockEast(BitGrid::Word block, BitGrid::Word east) {
+    return ((block >> 1) & ~BlockColumnLast) | ((east << (BlockEngine::BlockSize - 1)) & BlockColumnLast);
+}
+
+// Cells of a block and the cells below and above each of them
+struct BlockColumn {
+    BitGrid::Word below;
+    BitGrid::Word middle;
+    BitGrid::Word above;
+};
+
+inline BlockColumn GetBlockColumn(const BitGrid::Word* belowRow, const BitGrid::Word* middleRow,
+        const BitGrid::Word* aboveRow, size_t x) {
+    return BlockColumn{
+        GetBlockBelow(middleRow[x], belowRow[x]), middleRow[x], GetBlockAbove(middleRow[x], aboveRow[x])
+    };
+}
+
+
+namespace CellularAutomata {
+
+bool BlockEngine::IsSupportedSize(int width, int height) {
+    return width >= 0 && height >= 0 && width % BlockSize == 0 && height % BlockSize == 0;
+}
+
+bool BlockEngine::Resize(int width, int height) {
+    if (!IsSupportedSize(width, height)) {
+        LOGE << "Block grid sides must be multiples of " << BlockSize << ", not " << width << "x" << height;
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    blocksX_ = static_cast<size_t>(width / BlockSize);
+    blocksY_ = static_cast<size_t>(height / BlockSize);
+
+    current_.assign(blocksX_ * blocksY_, 0);
+    next_.assign(blocksX_ * blocksY_, 0);
+    generation_ = 0;
+    stats_ = GenerationStats();
+    return true;
+}
+
+void BlockEngine::SetRules(const AutomatonRules& rules) {
+    rules_ = rules;
+}
+
+const AutomatonRules& BlockEngine::GetRules() const {
+    return rules_;
+}
+
+bool BlockEngine::Load(const BitGrid& grid, uint64_t generation) {
+    if (!Resize(grid.GetWidth(), grid.GetHeight())) {
+        return false;
+    }
+    generation_ = generation;
+
+    // A word of the row holds a row of eight blocks, one byte each
+    for (int y = 0; y < height_; y++) {
+        const Word* row = grid.GetRow(y);
+        Word* blocks = current_.data() + (y / BlockSize) * blocksX_;
+        const int rowShift = (y % BlockSize) * BlockSize;
+        for (size_t x = 0; x < blocksX_; x++) {
+            const Word cells = (row[x / BlockSize] >> (x % BlockSize * BlockSize)) & 0xff;
+            blocks[x] |= cells << rowShift;
+        }
+    }
+
+    stats_.population = grid.GetPopulation();
+    for (size_t i = 0; i < current_.size(); i++) {
+        if (current_[i]) {
+            stats_.hash += HashCellWord(current_[i], i);
+        }
+    }
+    return true;
+}
+
+void BlockEngine::Store(BitGrid& grid) const {
+    grid.Resize(width_, height_);
+    for (int y = 0; y < height_; y++) {
+        Word* row = grid.GetRow(y);
+        const Word* blocks = current_.data() + (y / BlockSize) * blocksX_;
+        const int rowShift = (y % BlockSize) * BlockSize;
+        for (size_t x = 0; x < blocksX_; x++) {
+            row[x / BlockSize] |= ((blocks[x] >> rowShift) & 0xff) << (x % BlockSize * BlockSize);
+        }
+    }
+}
+
+int BlockEngine::GetWidth() const {
+    return width_;
+}
+
+int BlockEngine::GetHeight() const {
+    return height_;
+}
+
+void BlockEngine::Step(unsigned threads) {
+    if (blocksX_ == 0 || blocksY_ == 0) {
+        return;
+    }
+
+    if (threads == 0) {
+        threads = (current_.size() >= ParallelBlockMinWords) ? GetWorkerCount() : 1;
+    }
+
+    // Each range of block rows counts its own cells
+    std::vector<GenerationStats> partial(std::max(threads, 1u));
+    std::atomic<size_t> nextSlot{ 0 };
+    ParallelFor(blocksY_, [&](size_t begin, size_t end) {
+        partial[nextSlot++] = StepBlockRows(begin, end);
+    }, threads);
+
+    stats_ = GenerationStats();
+    for (const auto& p : partial) {
+        stats_.population += p.population;
+        stats_.births += p.births;
+        stats_.deaths += p.deaths;
+        stats_.hash += p.hash;
+    }
+
+    std::swap(current_, next_);
+    generation_++;
+}
+
+uint64_t BlockEngine::GetGeneration() const {
+    return generation_;
+}
+
+const GenerationStats& BlockEngine::GetStats() const {
+    return stats_;
+}
+
+GenerationStats BlockEngine::StepBlockRows(size_t begin, size_t end) {
+    GenerationStats stats;
+    for (size_t by = begin; by < end; by++) {
+        const Word* below = current_.data() + (by + blocksY_ - 1) % blocksY_ * blocksX_;
+        const Word* middle = current_.data() + by * blocksX_;
+        const Word* above = current_.data() + (by + 1) % blocksY_ * blocksX_;
+        Word* out = next_.data() + by * blocksX_;
+
+        // The columns slide east along the row, the last block wraps around to the first one
+        BlockColumn west = GetBlockColumn(below, middle, above, blocksX_ - 1);
+        BlockColumn center = GetBlockColumn(below, middle, above, 0);
+        for (size_t x = 0; x < blocksX_; x++) {
+            const BlockColumn east = GetBlockColumn(below, middle, above, (x + 1 < blocksX_) ? x + 1 : 0);
+
+            const Word neighbours[8] = {
+                GetBlockWest(center.below, west.below), center.below, GetBlockEast(center.below, east.below),
+                GetBlockWest(center.middle, west.middle), GetBlockEast(center.middle, east.middle),
+                GetBlockWest(center.above, west.above), center.above, GetBlockEast(center.above, east.above),
+            };
+            const NeighbourCount count = CountNeighbours(neighbours);
+
+            const Word alive = center.middle;
+            const Word cell = (alive & MatchCounts(rules_.survive, count)) | (~alive & MatchCounts(rules_.birth, count));
+            out[x] = cell;
+
+            stats.population += std::bitset<64>(cell).count();
+            stats.births += std::bitset<64>(cell & ~alive).count();
+            stats.deaths += std::bitset<64>(alive & ~cell).count();
+            if (cell) {
+                stats.hash += HashCellWord(cell, by * blocksX_ + x);
+            }
+
+            west = center;
+            center = east;
+        }
+    }
+    return stats;
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,62 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Life-like automaton on a torus stepped on the CPU, like LifeEngine, with the cells kept in 8x8 blocks
+    // of one word each. Byte r of a block is its row r and bit c of the byte its column c, blocks are stored
+    // row by row of blocks. Vertical neighbours are then mostly in the same word, only the blocks above
+    // and below add their edge rows, rather than each row of cells reading whole rows above and below it.
+    // Sides have to be multiples of 8. The hash of the stats is taken over the blocks, it differs
+    // from the one of LifeEngine for the same cells.
+    class BlockEngine {
+    public:
+        static constexpr int BlockSize = 8;
+
+    public:
+        BlockEngine() = default;
+
+        static bool IsSupportedSize(int width, int height);
+
+        // Cells are cleared. False if the size isn't supported.
+        bool Resize(int width, int height);
+
+        void SetRules(const AutomatonRules& rules);
+        const AutomatonRules& GetRules() const;
+
+        // Population and hash are computed once here, later they come from the steps.
+        // False if the size isn't supported.
+        bool Load(const BitGrid& grid, uint64_t generation);
+
+        void Store(BitGrid& grid) const;
+
+        int GetWidth() const;
+        int GetHeight() const;
+
+        // Advance by one generation, rows of blocks are split between worker threads for large grids.
+        // Zero threads selects the count automatically.
+        void Step(unsigned threads = 0);
+
+        uint64_t GetGeneration() const;
+        const GenerationStats& GetStats() const;
+
+    private:
+        using Word = BitGrid::Word;
+        using Cells = std::vector<Word, GridAllocator<Word>>;
+
+        GenerationStats StepBlockRows(size_t begin, size_t end);
+
+    private:
+        int width_{ 0 };
+        int height_{ 0 };
+        size_t blocksX_{ 0 };
+        size_t blocksY_{ 0 };
+
+        Cells current_;
+        Cells next_;
+
+        AutomatonRules rules_{ 0, 8, 12 }; // B3/S23
+        uint64_t generation_{ 0 };
+        GenerationStats stats_;
+    };
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Snapshots, recordings and streamed grids store their header fields and cell words as they are
+    // in memory, so the files are little endian. Every platform we build for is, builds for others stop here.
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "File formats need a little endian platform");
+#endif
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace CellularAutomata {
+    struct AutomatonRules {
+        int id;
+        int birth;
+        int survive;
+    };
+
+    enum class FirstGenerationType {
+        Empty = 0,
+        UniformRandom = 1,
+        RadialRandom = 2,
+        Pattern = 3, // Loaded from a pattern file
+    };
+
+    // Counters of a generation maintained by the CPU engines while stepping
+    struct GenerationStats {
+        uint64_t population{ 0 };
+        uint64_t births{ 0 };  // Cells born since the previous generation
+        uint64_t deaths{ 0 };  // Cells died since the previous generation
+        uint64_t hash{ 0 };    // Hash of the cells, equal cells give equal hashes
+    };
+
+    struct FirstGenerationParams {
+        FirstGenerationType type;
+        uint32_t seed;
+        float density; // Fraction of alive cells or rings
+    };
+}
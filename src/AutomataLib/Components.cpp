@@ -0,0 +1,387 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "Components.h"
+
+using CellularAutomata::BitGrid;
+
+// Smaller grids are labelled on the calling thread
+constexpr size_t ParallelLabelMinWords = 16 * 1024;
+
+// Flags of the roots, the group meets itself across the edges at another offset
+constexpr uint32_t WrapsX = 1;
+constexpr uint32_t WrapsY = 2;
+
+// Index of the lowest set bit
+int GetLowestBit(BitGrid::Word w) {
+    return static_cast<int>(std::bitset<BitGrid::WordBits>((w & (0 - w)) - 1).count());
+}
+
+// First and last cells of the runs of alive cells in a word, carry bits are the neighbours in the row
+BitGrid::Word GetRunStarts(BitGrid::Word w, BitGrid::Word previous) {
+    return w & ~((w << 1) | (previous >> (BitGrid::WordBits - 1)));
+}
+
+BitGrid::Word GetRunEnds(BitGrid::Word w, BitGrid::Word next) {
+    return w & ~((w >> 1) | (next << (BitGrid::WordBits - 1)));
+}
+
+int WrapCoordinate(int v, int size) {
+    return ((v % size) + size) % size;
+}
+
+namespace CellularAutomata {
+
+size_t ComponentLabeller::Label(const BitGrid& grid, unsigned threads, bool wrap) {
+    width_ = grid.GetWidth();
+    height_ = grid.GetHeight();
+    wrap_ = wrap;
+    components_.clear();
+    if (width_ == 0 || height_ == 0) {
+        runs_.clear();
+        rowRuns_.assign(static_cast<size_t>(height_) + 1, 0);
+        return 0;
+    }
+
+    if (threads == 0) {
+        threads = (grid.GetDataSize() >= ParallelLabelMinWords) ? GetWorkerCount() : 1;
+    }
+    const int bands = static_cast<int>(std::min<size_t>(std::max(threads, 1u), static_cast<size_t>(height_)));
+    bandRows_.resize(static_cast<size_t>(bands) + 1);
+    for (int b = 0; b <= bands; b++) {
+        bandRows_[b] = static_cast<int>(static_cast<int64_t>(height_) * b / bands);
+    }
+
+    FindRuns(grid, threads);
+
+    // Sets stay within the bands, so bands don't touch each other's runs
+    ParallelFor(static_cast<size_t>(bands), [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            for (int y = bandRows_[b]; y < bandRows_[b + 1]; y++) {
+                const uint32_t first = rowRuns_[y];
+                const uint32_t last = rowRuns_[y + 1];
+                if (wrap_ && first < last && runs_[first].x0 == 0 && runs_[last - 1].x1 == width_) {
+                    Unite(first, last - 1, -width_, 0);
+                }
+                if (y > bandRows_[b]) {
+                    UniteRows(y, y - 1, 0);
+                }
+            }
+        }
+    }, threads);
+
+    // First rows of the bands, the first band meets the last row across the edge
+    for (int b = 0; b < bands; b++) {
+        const int y = bandRows_[b];
+        if (y == 0 && !wrap_) {
+            continue;
+        }
+        UniteRows(y, (y > 0) ? y - 1 : height_ - 1, (y > 0) ? 0 : -height_);
+    }
+
+    CollectComponents(threads);
+
+    return components_.size();
+}
+
+const std::vector<Component>& ComponentLabeller::GetComponents() const {
+    return components_;
+}
+
+void ComponentLabeller::GetLabels(std::vector<uint32_t>& labels) const {
+    labels.assign(static_cast<size_t>(width_) * height_, 0);
+    for (int y = 0; y < height_; y++) {
+        uint32_t* row = labels.data() + static_cast<size_t>(y) * width_;
+        for (uint32_t i = rowRuns_[y]; i < rowRuns_[y + 1]; i++) {
+            std::fill(row + runs_[i].x0, row + runs_[i].x1, labels_[nodes_[i].parent] + 1);
+        }
+    }
+}
+
+uint32_t ComponentLabeller::FindRoot(uint32_t i) {
+    uint32_t root = nodes_[i].parent;
+    if (nodes_[root].parent == root) {
+        return root;
+    }
+
+    int dx = nodes_[i].dx;
+    int dy = nodes_[i].dy;
+    while (nodes_[root].parent != root) {
+        dx += nodes_[root].dx;
+        dy += nodes_[root].dy;
+        root = nodes_[root].parent;
+    }
+
+    // Path compression, every run on the way gets its offset to the root
+    while (i != root) {
+        Node& node = nodes_[i];
+        const uint32_t next = node.parent;
+        const int nextDx = dx - node.dx;
+        const int nextDy = dy - node.dy;
+        node.parent = root;
+        node.dx = dx;
+        node.dy = dy;
+        i = next;
+        dx = nextDx;
+        dy = nextDy;
+    }
+    return root;
+}
+
+void ComponentLabeller::Unite(uint32_t a, uint32_t b, int dx, int dy) {
+    const uint32_t rootA = FindRoot(a);
+    const uint32_t rootB = FindRoot(b);
+
+    // Offsets of a and b to their roots, the roots have zero offsets
+    const int ax = nodes_[a].dx;
+    const int ay = nodes_[a].dy;
+    const int bx = nodes_[b].dx;
+    const int by = nodes_[b].dy;
+
+    if (rootA == rootB) {
+        // Already joined, at another offset only if the group goes around the torus
+        nodes_[rootA].wraps |= ((dx + ax != bx) ? WrapsX : 0) | ((dy + ay != by) ? WrapsY : 0);
+    }
+    else if (rootA < rootB) {
+        // The smaller index stays the root, so parents never follow their runs and roots are the first runs.
+        // The flags of the absorbed root move to the remaining one.
+        const uint32_t wraps = nodes_[rootB].wraps;
+        nodes_[rootB] = Node{ rootA, dx + ax - bx, dy + ay - by, 0 };
+        nodes_[rootA].wraps |= wraps;
+    }
+    else {
+        const uint32_t wraps = nodes_[rootA].wraps;
+        nodes_[rootA] = Node{ rootB, bx - dx - ax, by - dy - ay, 0 };
+        nodes_[rootB].wraps |= wraps;
+    }
+}
+
+void ComponentLabeller::UniteRows(int a, int b, int dy) {
+    const uint32_t firstA = rowRuns_[a];
+    const uint32_t lastA = rowRuns_[a + 1];
+    const uint32_t firstB = rowRuns_[b];
+    const uint32_t lastB = rowRuns_[b + 1];
+    if (firstA == lastA || firstB == lastB) {
+        return;
+    }
+
+    // Runs touch when they overlap after one of them is widened by a cell on each side
+    uint32_t i = firstA;
+    uint32_t j = firstB;
+    while (i < lastA && j < lastB) {
+        if (runs_[j].x0 <= runs_[i].x1 && runs_[i].x0 <= runs_[j].x1) {
+            Unite(i, j, 0, dy);
+        }
+        if (runs_[i].x1 < runs_[j].x1) {
+            i++;
+        }
+        else {
+            j++;
+        }
+    }
+
+    // Corners across the left and right edges
+    if (!wrap_) {
+        return;
+    }
+    if (runs_[firstA].x0 == 0 && runs_[lastB - 1].x1 == width_) {
+        Unite(firstA, lastB - 1, -width_, dy);
+    }
+    if (runs_[lastA - 1].x1 == width_ && runs_[firstB].x0 == 0) {
+        Unite(lastA - 1, firstB, width_, dy);
+    }
+}
+
+void ComponentLabeller::FindRuns(const BitGrid& grid, unsigned threads) {
+    const size_t words = grid.GetWordsPerRow();
+    const size_t bands = bandRows_.size() - 1;
+
+    rowRuns_.resize(static_cast<size_t>(height_) + 1);
+    ParallelFor(bands, [&](size_t begin, size_t end) {
+        for (int y = bandRows_[begin]; y < bandRows_[end]; y++) {
+            const BitGrid::Word* row = grid.GetRow(y);
+            uint32_t count = 0;
+            BitGrid::Word previous = 0;
+            for (size_t j = 0; j < words; j++) {
+                count += static_cast<uint32_t>(std::bitset<BitGrid::WordBits>(GetRunStarts(row[j], previous)).count());
+                previous = row[j];
+            }
+            rowRuns_[y] = count;
+        }
+    }, threads);
+
+    uint32_t total = 0;
+    for (int y = 0; y <= height_; y++) {
+        const uint32_t count = (y < height_) ? rowRuns_[y] : 0;
+        rowRuns_[y] = total;
+        total += count;
+    }
+    runs_.resize(total);
+    nodes_.resize(total);
+
+    ParallelFor(bands, [&](size_t begin, size_t end) {
+        for (int y = bandRows_[begin]; y < bandRows_[end]; y++) {
+            const BitGrid::Word* row = grid.GetRow(y);
+            Run* run = runs_.data() + rowRuns_[y];
+            for (uint32_t i = rowRuns_[y]; i < rowRuns_[y + 1]; i++) {
+                nodes_[i] = Node{ i, 0, 0, 0 };
+            }
+            bool open = false;
+            for (size_t j = 0; j < words; j++) {
+                const int x = static_cast<int>(j) * BitGrid::WordBits;
+                BitGrid::Word starts = GetRunStarts(row[j], (j > 0) ? row[j - 1] : 0);
+                BitGrid::Word ends = GetRunEnds(row[j], (j + 1 < words) ? row[j + 1] : 0);
+
+                // Starts and ends alternate along the row, a run may end words after it starts
+                while (true) {
+                    if (!open) {
+                        if (!starts) {
+                            break;
+                        }
+                        run->x0 = x + GetLowestBit(starts);
+                        starts &= starts - 1;
+                        open = true;
+                    }
+                    if (!ends) {
+                        break;
+                    }
+                    run->x1 = x + GetLowestBit(ends) + 1;
+                    ends &= ends - 1;
+                    run++;
+                    open = false;
+                }
+            }
+        }
+    }, threads);
+}
+
+void ComponentLabeller::CollectComponents(unsigned threads) {
+    const size_t bands = bandRows_.size() - 1;
+    std::vector<uint32_t> bandRuns(bands + 1);
+    for (size_t b = 0; b <= bands; b++) {
+        bandRuns[b] = rowRuns_[bandRows_[b]];
+    }
+
+    // Runs point to the first run of their set within the band, which has the root
+    // or a run of an earlier band as the parent since parents are never after their runs.
+    // A single band has no runs of earlier bands, the roots are found in one pass below.
+    std::vector<std::vector<uint32_t>> external(bands);
+    ParallelFor((bands > 1) ? bands : 0, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            for (uint32_t i = bandRuns[b]; i < bandRuns[b + 1]; i++) {
+                Node& node = nodes_[i];
+                if (node.parent < bandRuns[b]) {
+                    external[b].push_back(i);
+                    continue;
+                }
+                const Node& parent = nodes_[node.parent];
+                if (node.parent != i && parent.parent != node.parent && parent.parent >= bandRuns[b]) {
+                    node.dx += parent.dx;
+                    node.dy += parent.dy;
+                    node.parent = parent.parent;
+                }
+            }
+        }
+    }, threads);
+
+    for (const auto& runs : external) {
+        for (uint32_t i : runs) {
+            FindRoot(i);
+        }
+    }
+
+    // Now every run is a root, the child of a root, or the child of a child of a root.
+    // Roots come before the other runs of their groups and get their labels within the band.
+    labels_.resize(runs_.size());
+    bandBounds_.resize(bands);
+    std::vector<std::unordered_map<uint32_t, Bounds>> foreign(bands);
+    ParallelFor(bands, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            auto& bounds = bandBounds_[b];
+            bounds.clear();
+            for (int y = bandRows_[b]; y < bandRows_[b + 1]; y++) {
+                for (uint32_t i = rowRuns_[y]; i < rowRuns_[y + 1]; i++) {
+                    Node& node = nodes_[i];
+                    if (node.parent == i) {
+                        labels_[i] = static_cast<uint32_t>(bounds.size());
+                        bounds.push_back(Bounds{ std::numeric_limits<int>::max(), std::numeric_limits<int>::min(),
+                            std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), 0, i });
+                    }
+                    else {
+                        const Node& parent = nodes_[node.parent];
+                        if (parent.parent != node.parent) {
+                            node.dx += parent.dx;
+                            node.dy += parent.dy;
+                            node.parent = parent.parent;
+                        }
+                    }
+
+                    const Run& run = runs_[i];
+                    if (node.parent >= bandRuns[b]) {
+                        bounds[labels_[node.parent]].Add(run.x0 + node.dx, run.x1 + node.dx, y + node.dy);
+                    }
+                    else {
+                        auto it = foreign[b].find(node.parent);
+                        if (it == foreign[b].end()) {
+                            it = foreign[b].emplace(node.parent, Bounds{ std::numeric_limits<int>::max(),
+                                std::numeric_limits<int>::min(), std::numeric_limits<int>::max(),
+                                std::numeric_limits<int>::min(), 0, node.parent }).first;
+                        }
+                        it->second.Add(run.x0 + node.dx, run.x1 + node.dx, y + node.dy);
+                    }
+                }
+            }
+        }
+    }, threads);
+
+    std::vector<uint32_t> firstLabels(bands + 1, 0);
+    for (size_t b = 0; b < bands; b++) {
+        firstLabels[b + 1] = firstLabels[b] + static_cast<uint32_t>(bandBounds_[b].size());
+    }
+
+    // Parts of groups with the roots in earlier bands
+    for (const auto& f : foreign) {
+        for (const auto& [root, part] : f) {
+            const size_t band = std::upper_bound(bandRuns.begin(), bandRuns.end(), root) - bandRuns.begin() - 1;
+            Bounds& bounds = bandBounds_[band][labels_[root]];
+            bounds.minX = std::min(bounds.minX, part.minX);
+            bounds.maxX = std::max(bounds.maxX, part.maxX);
+            bounds.minY = std::min(bounds.minY, part.minY);
+            bounds.maxY = std::max(bounds.maxY, part.maxY);
+            bounds.size += part.size;
+        }
+    }
+
+    components_.resize(firstLabels[bands]);
+    ParallelFor(bands, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            for (const Bounds& bounds : bandBounds_[b]) {
+                labels_[bounds.root] += firstLabels[b];
+
+                Component& c = components_[labels_[bounds.root]];
+                c.size = bounds.size;
+                c.width = bounds.maxX - bounds.minX;
+                c.height = bounds.maxY - bounds.minY;
+                c.x = WrapCoordinate(bounds.minX, width_);
+                c.y = WrapCoordinate(bounds.minY, height_);
+                if ((nodes_[bounds.root].wraps & WrapsX) || c.width >= width_) {
+                    c.x = 0;
+                    c.width = width_;
+                }
+                if ((nodes_[bounds.root].wraps & WrapsY) || c.height >= height_) {
+                    c.y = 0;
+                    c.height = height_;
+                }
+            }
+        }
+    }, threads);
+}
+
+size_t LabelComponents(const BitGrid& grid, std::vector<uint32_t>& labels) {
+    ComponentLabeller labeller;
+    const size_t count = labeller.Label(grid, 1);
+    labeller.GetLabels(labels);
+    return count;
+}
+
+} // namespace CellularAutomata
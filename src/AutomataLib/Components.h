@@ -0,0 +1,90 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    struct Component {
+        // Bounding box with the corner wrapped into the grid. Boxes of groups across the edges
+        // extend past them, groups that wrap around the whole torus get its full width or height.
+        int x{ 0 };
+        int y{ 0 };
+        int width{ 0 };
+        int height{ 0 };
+        uint64_t size{ 0 }; // Alive cells
+    };
+
+    // Labels connected groups of alive cells, cells touching by a side or a corner are connected.
+    // The grid is a torus by default, so groups continue across the edges.
+    // Horizontal runs of alive cells are taken from the words of the rows and joined with union-find.
+    // Bands of rows are joined in parallel, then the rows between the bands are joined on one thread.
+    // Sets keep their offsets to the roots, so groups across the edges get contiguous boxes.
+    class ComponentLabeller {
+    public:
+        // Zero threads selects the count automatically. Returns the count of the groups.
+        // Without wrap the edges bound the grid, as for a window cut from a larger plane.
+        size_t Label(const BitGrid& grid, unsigned threads = 0, bool wrap = true);
+
+        // In the order of their first cell, row by row
+        const std::vector<Component>& GetComponents() const;
+
+        // Labels are one per cell, row by row, 0 for dead cells and 1..count for the groups
+        void GetLabels(std::vector<uint32_t>& labels) const;
+
+    private:
+        struct Run {
+            int x0;
+            int x1; // Past the last cell
+        };
+
+        uint32_t FindRoot(uint32_t i);
+        // Cells of run b moved by the offset touch the cells of run a
+        void Unite(uint32_t a, uint32_t b, int dx, int dy);
+        // Row b is next to row a after it is moved by dy
+        void UniteRows(int a, int b, int dy);
+
+        void FindRuns(const BitGrid& grid, unsigned threads);
+        void CollectComponents(unsigned threads);
+
+    private:
+        int width_{ 0 };
+        int height_{ 0 };
+        bool wrap_{ true };
+        std::vector<int> bandRows_;
+
+        // Union-find node of a run, one cache line has four of them
+        struct Node {
+            uint32_t parent;
+            int dx;             // Offset to the parent, after FindRoot to the root
+            int dy;
+            uint32_t wraps;     // Of the roots, the group closes on itself around the torus
+        };
+
+        struct Bounds {
+            int minX;
+            int maxX;
+            int minY;
+            int maxY;
+            uint64_t size;
+            uint32_t root;
+
+            void Add(int x0, int x1, int y) {
+                minX = std::min(minX, x0);
+                maxX = std::max(maxX, x1);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y + 1);
+                size += static_cast<uint64_t>(x1 - x0);
+            }
+        };
+
+        std::vector<Run> runs_;
+        std::vector<uint32_t> rowRuns_; // First run of each row and the count of the runs at the end
+        std::vector<Node> nodes_;
+        std::vector<uint32_t> labels_;  // Of the roots
+        std::vector<std::vector<Bounds>> bandBounds_; // Groups with the roots in each band, in the frames of the roots
+
+        std::vector<Component> components_;
+    };
+
+    // One-shot labelling on the calling thread, see ComponentLabeller
+    size_t LabelComponents(const BitGrid& grid, std::vector<uint32_t>& labels);
+
+}
@@ -0,0 +1,182 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "RandomGenerator.h"
+#include "LifeKernel.h"
+#include "EnsembleEngine.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::GenerationStats;
+
+// Universes stepped by a worker at once, small batches are not worth the threads
+constexpr size_t ParallelEnsembleMinCount = 256;
+
+// B3/S23
+constexpr uint16_t DefaultBirthMask = 8;
+constexpr uint16_t DefaultSurviveMask = 12;
+
+inline BitGrid::Word RotateLeft(BitGrid::Word w) {
+    return (w << 1) | (w >> (BitGrid::WordBits - 1));
+}
+
+inline BitGrid::Word RotateRight(BitGrid::Word w) {
+    return (w >> 1) | (w << (BitGrid::WordBits - 1));
+}
+
+void StepUniverses(const BitGrid::Word* current, BitGrid::Word* next, size_t count,
+        const uint16_t* birth, const uint16_t* survive, GenerationStats* stats, size_t begin, size_t end) {
+    constexpr int size = CellularAutomata::EnsembleEngine::UniverseSize;
+
+    for (size_t u = begin; u < end; u++) {
+        stats[u] = GenerationStats();
+    }
+
+    for (int y = 0; y < size; y++) {
+        const BitGrid::Word* below = current + static_cast<size_t>((y + size - 1) % size) * count;
+        const BitGrid::Word* middle = current + static_cast<size_t>(y) * count;
+        const BitGrid::Word* above = current + static_cast<size_t>((y + 1) % size) * count;
+        BitGrid::Word* out = next + static_cast<size_t>(y) * count;
+
+        // Same operations for every universe, only the rules differ
+        for (size_t u = begin; u < end; u++) {
+            const BitGrid::Word neighbours[8] = {
+                RotateLeft(below[u]), below[u], RotateRight(below[u]),
+                RotateLeft(middle[u]), RotateRight(middle[u]),
+                RotateLeft(above[u]), above[u], RotateRight(above[u]),
+            };
+            CellularAutomata::NeighbourCount c = CellularAutomata::CountNeighbours(neighbours);
+
+            out[u] = CellularAutomata::ApplyRulesBranchless(birth[u], survive[u], middle[u], c);
+        }
+
+        for (size_t u = begin; u < end; u++) {
+            const BitGrid::Word alive = middle[u];
+            const BitGrid::Word cell = out[u];
+            stats[u].population += std::bitset<64>(cell).count();
+            stats[u].births += std::bitset<64>(cell & ~alive).count();
+            stats[u].deaths += std::bitset<64>(alive & ~cell).count();
+            if (cell) {
+                stats[u].hash += CellularAutomata::HashCellWord(cell, static_cast<size_t>(y));
+            }
+        }
+    }
+}
+
+
+namespace CellularAutomata {
+
+void EnsembleEngine::Resize(size_t count) {
+    count_ = count;
+    current_.assign(count * UniverseSize, 0);
+    next_.assign(count * UniverseSize, 0);
+
+    birth_.resize(count, DefaultBirthMask);
+    survive_.resize(count, DefaultSurviveMask);
+
+    generation_ = 0;
+    stats_.assign(count, GenerationStats());
+}
+
+size_t EnsembleEngine::GetCount() const {
+    return count_;
+}
+
+void EnsembleEngine::SetRules(const AutomatonRules& rules) {
+    std::fill(birth_.begin(), birth_.end(), static_cast<uint16_t>(rules.birth));
+    std::fill(survive_.begin(), survive_.end(), static_cast<uint16_t>(rules.survive));
+}
+
+void EnsembleEngine::SetRules(size_t universe, const AutomatonRules& rules) {
+    birth_[universe] = static_cast<uint16_t>(rules.birth);
+    survive_[universe] = static_cast<uint16_t>(rules.survive);
+}
+
+AutomatonRules EnsembleEngine::GetRules(size_t universe) const {
+    return AutomatonRules{ 0, birth_[universe], survive_[universe] };
+}
+
+void EnsembleEngine::Randomize(uint32_t seed, float density, unsigned threads) {
+    const uint32_t threshold = GetDensityThreshold(density);
+
+    // Same cells as GenerateFirstGeneration of a 64x64 grid
+    ParallelFor(count_, [&](size_t begin, size_t end) {
+        for (size_t u = begin; u < end; u++) {
+            const uint32_t key = seed + static_cast<uint32_t>(u);
+            for (int y = 0; y < UniverseSize; y++) {
+                BitGrid::Word row = 0;
+                for (int x = 0; x < UniverseSize; x++) {
+                    if (Philox2x32(static_cast<uint32_t>(x), static_cast<uint32_t>(y), key)[0] < threshold) {
+                        row |= BitGrid::Word(1) << x;
+                    }
+                }
+                current_[static_cast<size_t>(y) * count_ + u] = row;
+            }
+            CountStats(u);
+        }
+    }, threads);
+
+    generation_ = 0;
+}
+
+void EnsembleEngine::Load(size_t universe, const BitGrid& grid) {
+    for (int y = 0; y < UniverseSize; y++) {
+        current_[static_cast<size_t>(y) * count_ + universe] = grid.GetRow(y)[0];
+    }
+    CountStats(universe);
+}
+
+void EnsembleEngine::Store(size_t universe, BitGrid& grid) const {
+    grid.Resize(UniverseSize, UniverseSize);
+    for (int y = 0; y < UniverseSize; y++) {
+        grid.GetRow(y)[0] = current_[static_cast<size_t>(y) * count_ + universe];
+    }
+}
+
+BitGrid::Word EnsembleEngine::GetRow(size_t universe, int y) const {
+    return current_[static_cast<size_t>(y) * count_ + universe];
+}
+
+void EnsembleEngine::Step(unsigned threads) {
+    if (count_ == 0) {
+        return;
+    }
+
+    if (threads == 0) {
+        threads = (count_ >= ParallelEnsembleMinCount) ? GetWorkerCount() : 1;
+    }
+
+    ParallelFor(count_, [&](size_t begin, size_t end) {
+        StepUniverses(current_.data(), next_.data(), count_, birth_.data(), survive_.data(), stats_.data(),
+            begin, end);
+    }, threads);
+
+    std::swap(current_, next_);
+    generation_++;
+}
+
+uint64_t EnsembleEngine::GetGeneration() const {
+    return generation_;
+}
+
+const GenerationStats& EnsembleEngine::GetStats(size_t universe) const {
+    return stats_[universe];
+}
+
+const std::vector<GenerationStats>& EnsembleEngine::GetStats() const {
+    return stats_;
+}
+
+void EnsembleEngine::CountStats(size_t universe) {
+    GenerationStats& stats = stats_[universe];
+    stats = GenerationStats();
+    for (int y = 0; y < UniverseSize; y++) {
+        const BitGrid::Word row = current_[static_cast<size_t>(y) * count_ + universe];
+        stats.population += std::bitset<64>(row).count();
+        if (row) {
+            stats.hash += HashCellWord(row, static_cast<size_t>(y));
+        }
+    }
+}
+
+} // namespace CellularAutomata
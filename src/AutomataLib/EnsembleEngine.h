@@ -0,0 +1,60 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Many independent 64x64 torus universes stepped together on the CPU.
+    // Row y of every universe is stored next to row y of the following one, so the inner loop
+    // runs over universes with the same instructions and is vectorized by the compiler.
+    // Each universe has its own rules, seed and counters.
+    class EnsembleEngine {
+    public:
+        static constexpr int UniverseSize = BitGrid::WordBits;
+
+    public:
+        EnsembleEngine() = default;
+
+        // Cells and counters are cleared, rules are kept for the existing universes
+        void Resize(size_t count);
+        size_t GetCount() const;
+
+        void SetRules(const AutomatonRules& rules);
+        void SetRules(size_t universe, const AutomatonRules& rules);
+        AutomatonRules GetRules(size_t universe) const;
+
+        // Universe u gets the cells of a 64x64 model generated with the seed + u,
+        // population and hash are counted here once
+        void Randomize(uint32_t seed, float density, unsigned threads = 0);
+
+        // Grids are 64x64
+        void Load(size_t universe, const BitGrid& grid);
+        void Store(size_t universe, BitGrid& grid) const;
+
+        // Word of row y of the universe, bit x is the cell x
+        BitGrid::Word GetRow(size_t universe, int y) const;
+
+        // Advance every universe by one generation, ranges of universes are split between worker threads.
+        // Zero threads selects the count automatically.
+        void Step(unsigned threads = 0);
+
+        uint64_t GetGeneration() const;
+
+        // Hash matches the one of LifeEngine for the same 64x64 cells
+        const GenerationStats& GetStats(size_t universe) const;
+        const std::vector<GenerationStats>& GetStats() const;
+
+    private:
+        void CountStats(size_t universe);
+
+    private:
+        size_t count_{ 0 };
+        std::vector<BitGrid::Word> current_; // [y * count_ + universe]
+        std::vector<BitGrid::Word> next_;
+
+        std::vector<uint16_t> birth_;
+        std::vector<uint16_t> survive_;
+
+        uint64_t generation_{ 0 };
+        std::vector<GenerationStats> stats_;
+    };
+
+}
@@ -0,0 +1,322 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "ByteOrder.h"
+#include "MappedFile.h"
+#include "ZeroRuns.h"
+#include "GenerationStream.h"
+
+constexpr char StreamMagic[4] = { 'G', 'O', 'L', 'R' };
+constexpr uint32_t StreamVersion = 1;
+
+constexpr uint32_t KeyframeRecord = 0;
+constexpr uint32_t DeltaRecord = 1;
+
+// Fields are little endian, see ByteOrder.h
+struct StreamHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t keyframeInterval;
+    uint32_t reserved;
+};
+
+struct RecordHeader {
+    uint64_t generation;
+    uint32_t type;
+    uint32_t size; // Of the payload
+};
+
+struct IndexEntry {
+    uint64_t generation;
+    uint64_t offset; // Of the keyframe record in the stream
+};
+
+static_assert(sizeof(StreamHeader) == 24 && sizeof(RecordHeader) == 16 && sizeof(IndexEntry) == 16,
+    "Stream structures must have no padding");
+
+std::filesystem::path GetIndexPath(const std::filesystem::path& path) {
+    auto indexPath = path;
+    indexPath += ".idx";
+    return indexPath;
+}
+
+IndexEntry GetIndexEntry(const CellularAutomata::MappedFile& index, size_t i) {
+    IndexEntry entry;
+    std::memcpy(&entry, index.GetData() + i * sizeof(entry), sizeof(entry));
+    return entry;
+}
+
+
+namespace CellularAutomata {
+
+GenerationRecorder::~GenerationRecorder() {
+    Close();
+}
+
+bool GenerationRecorder::Open(const std::filesystem::path& path, int width, int height, uint32_t keyframeInterval) {
+    Close();
+
+    data_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    index_.open(GetIndexPath(path), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!data_ || !index_) {
+        LOGE << "Unable to create recording " << path.string();
+        Close();
+        return false;
+    }
+
+    keyframeInterval_ = std::max(keyframeInterval, 1u);
+    previous_.Resize(width, height);
+    delta_.resize(previous_.GetDataSize());
+    frames_ = 0;
+
+    StreamHeader header{};
+    std::memcpy(header.magic, StreamMagic, sizeof(header.magic));
+    header.version = StreamVersion;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.keyframeInterval = keyframeInterval_;
+
+    data_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset_ = sizeof(header);
+    return true;
+}
+
+void GenerationRecorder::Close() {
+    if (data_.is_open()) {
+        data_.close();
+    }
+    if (index_.is_open()) {
+        index_.close();
+    }
+}
+
+bool GenerationRecorder::IsOpen() const {
+    return data_.is_open();
+}
+
+bool GenerationRecorder::Append(uint64_t generation, const BitGrid& grid) {
+    if (grid.GetWidth() != previous_.GetWidth() || grid.GetHeight() != previous_.GetHeight()) {
+        LOGE << "Recorded grid size changed";
+        return false;
+    }
+    if (frames_ > 0 && generation <= lastGeneration_) {
+        LOGE << "Recorded generations must increase, " << generation << " after " << lastGeneration_;
+        return false;
+    }
+
+    const BitGrid::Word* words = grid.GetData();
+    const size_t count = grid.GetDataSize();
+    const bool isKeyframe = (frames_ % keyframeInterval_) == 0;
+
+    buffer_.resize(sizeof(RecordHeader));
+    if (isKeyframe) {
+        EncodeZeroRuns(words, count, buffer_);
+    }
+    else {
+        const BitGrid::Word* previous = previous_.GetData();
+        for (size_t i = 0; i < count; i++) {
+            delta_[i] = words[i] ^ previous[i];
+        }
+        EncodeZeroRuns(delta_.data(), count, buffer_);
+    }
+
+    RecordHeader record{ generation, isKeyframe ? KeyframeRecord : DeltaRecord,
+        static_cast<uint32_t>(buffer_.size() - sizeof(RecordHeader)) };
+    std::memcpy(buffer_.data(), &record, sizeof(record));
+
+    if (!data_.write(buffer_.data(), buffer_.size())) {
+        LOGE << "Unable to write recording";
+        Close();
+        return false;
+    }
+
+    // Index only lists complete keyframes, so an interrupted recording stays seekable
+    if (isKeyframe) {
+        data_.flush();
+        IndexEntry entry{ generation, offset_ };
+        index_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        index_.flush();
+    }
+
+    std::copy(words, words + count, previous_.GetData());
+    offset_ += buffer_.size();
+    lastGeneration_ = generation;
+    frames_++;
+    return true;
+}
+
+uint64_t GenerationRecorder::GetFrameCount() const {
+    return frames_;
+}
+
+uint64_t GenerationRecorder::GetBytesWritten() const {
+    return offset_ + (frames_ + keyframeInterval_ - 1) / keyframeInterval_ * sizeof(IndexEntry);
+}
+
+struct GenerationPlayer::Record {
+    RecordHeader header;
+    const char* payload;
+};
+
+bool GenerationPlayer::Open(const std::filesystem::path& path) {
+    Close();
+
+    if (!data_.Open(path) || !index_.Open(GetIndexPath(path))) {
+        Close();
+        return false;
+    }
+
+    StreamHeader header;
+    if (data_.GetSize() < sizeof(header)) {
+        LOGE << "Recording is truncated";
+        Close();
+        return false;
+    }
+    std::memcpy(&header, data_.GetData(), sizeof(header));
+    if (std::memcmp(header.magic, StreamMagic, sizeof(header.magic)) != 0 || header.version != StreamVersion) {
+        LOGE << "Not a recording or unsupported version";
+        Close();
+        return false;
+    }
+    if (header.width == 0 || header.height == 0 ||
+            header.width > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+            header.height > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+        LOGE << "Recording has invalid size " << header.width << "x" << header.height;
+        Close();
+        return false;
+    }
+
+    width_ = static_cast<int>(header.width);
+    height_ = static_cast<int>(header.height);
+
+    keyframeCount_ = index_.GetSize() / sizeof(IndexEntry);
+    if (keyframeCount_ == 0) {
+        LOGE << "Recording has no keyframes";
+        Close();
+        return false;
+    }
+
+    // Frames after the last keyframe aren't indexed
+    Record record;
+    uint64_t offset = GetIndexEntry(index_, keyframeCount_ - 1).offset;
+    while (ReadRecord(offset, record)) {
+        lastGeneration_ = record.header.generation;
+        offset += sizeof(RecordHeader) + record.header.size;
+    }
+
+    position_ = GetIndexEntry(index_, 0).offset;
+    generation_ = GetIndexEntry(index_, 0).generation;
+    return true;
+}
+
+void GenerationPlayer::Close() {
+    data_.Close();
+    index_.Close();
+    width_ = height_ = 0;
+    keyframeCount_ = 0;
+    lastGeneration_ = 0;
+    position_ = 0;
+    generation_ = 0;
+}
+
+bool GenerationPlayer::IsOpen() const {
+    return keyframeCount_ > 0;
+}
+
+int GenerationPlayer::GetWidth() const {
+    return width_;
+}
+
+int GenerationPlayer::GetHeight() const {
+    return height_;
+}
+
+uint64_t GenerationPlayer::GetFirstGeneration() const {
+    return IsOpen() ? GetIndexEntry(index_, 0).generation : 0;
+}
+
+uint64_t GenerationPlayer::GetLastGeneration() const {
+    return lastGeneration_;
+}
+
+uint64_t GenerationPlayer::GetGeneration() const {
+    return generation_;
+}
+
+bool GenerationPlayer::ReadRecord(uint64_t offset, Record& record) const {
+    if (offset + sizeof(RecordHeader) > data_.GetSize()) {
+        return false;
+    }
+    std::memcpy(&record.header, data_.GetData() + offset, sizeof(RecordHeader));
+    if (offset + sizeof(RecordHeader) + record.header.size > data_.GetSize()) {
+        return false;
+    }
+    record.payload = data_.GetData() + offset + sizeof(RecordHeader);
+    return true;
+}
+
+bool GenerationPlayer::ApplyRecord(const Record& record, BitGrid& grid) {
+    if (grid.GetWidth() != width_ || grid.GetHeight() != height_) {
+        grid.Resize(width_, height_);
+    }
+
+    bool isValid = (record.header.type == KeyframeRecord) ?
+        DecodeZeroRuns(record.payload, record.header.size, grid.GetData(), grid.GetDataSize()) :
+        ApplyZeroRunsXor(record.payload, record.header.size, grid.GetData(), grid.GetDataSize());
+    if (!isValid) {
+        LOGE << "Recorded frame of generation " << record.header.generation << " is malformed";
+        return false;
+    }
+
+    generation_ = record.header.generation;
+    return true;
+}
+
+bool GenerationPlayer::Seek(uint64_t generation, BitGrid& grid) {
+    if (!IsOpen()) {
+        return false;
+    }
+
+    // Last keyframe at or before the generation
+    size_t first = 0, count = keyframeCount_;
+    while (count > 1) {
+        size_t half = count / 2;
+        if (GetIndexEntry(index_, first + half).generation <= generation) {
+            first += half;
+            count -= half;
+        }
+        else {
+            count = half;
+        }
+    }
+
+    Record record;
+    uint64_t offset = GetIndexEntry(index_, first).offset;
+    if (!ReadRecord(offset, record) || record.header.type != KeyframeRecord || !ApplyRecord(record, grid)) {
+        return false;
+    }
+    offset += sizeof(RecordHeader) + record.header.size;
+
+    // Deltas up to the generation
+    while (ReadRecord(offset, record) && record.header.type == DeltaRecord && record.header.generation <= generation) {
+        if (!ApplyRecord(record, grid)) {
+            return false;
+        }
+        offset += sizeof(RecordHeader) + record.header.size;
+    }
+
+    position_ = offset;
+    return true;
+}
+
+bool GenerationPlayer::Next(BitGrid& grid) {
+    Record record;
+    if (!IsOpen() || !ReadRecord(position_, record) || !ApplyRecord(record, grid)) {
+        return false;
+    }
+    position_ += sizeof(RecordHeader) + record.header.size;
+    return true;
+}
+
+} // namespace CellularAutomata
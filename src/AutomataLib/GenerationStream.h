@@ -0,0 +1,85 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Recorded run is a stream of frames, every keyframeInterval-th frame holds the whole grid
+    // and the others the XOR with the previous frame. Both are compressed by ZeroRuns.
+    // Keyframes are listed in the index file <path>.idx, so any generation is reached
+    // by a binary search and at most keyframeInterval - 1 deltas.
+    class GenerationRecorder {
+    public:
+        static constexpr uint32_t DefaultKeyframeInterval = 256;
+
+    public:
+        GenerationRecorder() = default;
+        ~GenerationRecorder();
+
+        GenerationRecorder(GenerationRecorder const&) = delete;
+        GenerationRecorder& operator=(GenerationRecorder const&) = delete;
+
+        bool Open(const std::filesystem::path& path, int width, int height,
+            uint32_t keyframeInterval = DefaultKeyframeInterval);
+        void Close();
+        bool IsOpen() const;
+
+        // Generations must increase from frame to frame
+        bool Append(uint64_t generation, const BitGrid& grid);
+
+        uint64_t GetFrameCount() const;
+        uint64_t GetBytesWritten() const;
+
+    private:
+        std::ofstream data_;
+        std::ofstream index_;
+        uint32_t keyframeInterval_{ DefaultKeyframeInterval };
+
+        BitGrid previous_;
+        std::vector<uint64_t> delta_;
+        std::vector<char> buffer_;
+
+        uint64_t frames_{ 0 };
+        uint64_t offset_{ 0 };
+        uint64_t lastGeneration_{ 0 };
+    };
+
+    // Plays the recorded run back, both files are memory mapped
+    class GenerationPlayer {
+    public:
+        bool Open(const std::filesystem::path& path);
+        void Close();
+        bool IsOpen() const;
+
+        int GetWidth() const;
+        int GetHeight() const;
+        uint64_t GetFirstGeneration() const;
+        uint64_t GetLastGeneration() const;
+
+        // Generation of the frame in the grid
+        uint64_t GetGeneration() const;
+
+        // Latest frame at or before the generation, the first frame for earlier generations
+        bool Seek(uint64_t generation, BitGrid& grid);
+
+        // Frame after the one in the grid, false at the end of the stream
+        bool Next(BitGrid& grid);
+
+    private:
+        struct Record;
+        bool ReadRecord(uint64_t offset, Record& record) const;
+        bool ApplyRecord(const Record& record, BitGrid& grid);
+
+    private:
+        MappedFile data_;
+        MappedFile index_;
+
+        int width_{ 0 };
+        int height_{ 0 };
+
+        size_t keyframeCount_{ 0 };
+        uint64_t lastGeneration_{ 0 };
+
+        uint64_t position_{ 0 }; // Offset of the next record
+        uint64_t generation_{ 0 };
+    };
+
+}
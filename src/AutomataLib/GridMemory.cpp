@@ -0,0 +1,220 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "GridMemory.h"
+
+#ifdef __linux__
+# include <sched.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+using CellularAutomata::HugePages;
+
+constexpr size_t HugePageBytes = 2 * 1024 * 1024;
+
+// Policy of mbind from <linux/mempolicy.h>, pages go to other nodes when the preferred one is full
+constexpr int MemoryPolicyPreferred = 1;
+
+CellularAutomata::GridMemoryPolicy CurrentGridPolicy;
+
+size_t RoundToHugePages(size_t bytes) {
+    return (bytes + HugePageBytes - 1) / HugePageBytes * HugePageBytes;
+}
+
+#ifdef __linux__
+
+const std::filesystem::path NumaNodeDir = "/sys/devices/system/node";
+
+constexpr unsigned NodeMaskWordBits = 8 * sizeof(unsigned long);
+
+// CPUs of a node from a list such as "0-15,32-47"
+std::vector<int> ReadNumaNodeCpus(unsigned node) {
+    std::ifstream in(NumaNodeDir / ("node" + std::to_string(node)) / "cpulist");
+    std::string list;
+    std::getline(in, list);
+
+    std::vector<int> cpus;
+    std::istringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        const size_t dash = range.find('-');
+        const int first = std::atoi(range.c_str());
+        const int last = (dash == std::string::npos) ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Read once, threads are bound to the nodes on every parallel step
+const std::vector<std::vector<int>>& GetNumaNodeCpus() {
+    static const std::vector<std::vector<int>> cpus = [] {
+        std::vector<std::vector<int>> nodes;
+        while (std::filesystem::exists(NumaNodeDir / ("node" + std::to_string(nodes.size())))) {
+            nodes.push_back(ReadNumaNodeCpus(static_cast<unsigned>(nodes.size())));
+        }
+        return nodes;
+    }();
+    return cpus;
+}
+
+// Fresh anonymous pages aligned to a huge page, so that the kernel may back all of them with huge pages
+void* MapGridPages(size_t bytes, HugePages hugePages) {
+    if (hugePages == HugePages::Explicit) {
+        void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED) {
+            return data;
+        }
+
+        static std::atomic<bool> warned{ false };
+        if (!warned.exchange(true)) {
+            LOGW << "No reserved huge pages left for a grid of " << bytes << " bytes, using transparent huge pages";
+        }
+    }
+
+    const size_t mapped = bytes + HugePageBytes;
+    char* raw = static_cast<char*>(mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+
+    char* data = raw + (HugePageBytes - reinterpret_cast<uintptr_t>(raw) % HugePageBytes) % HugePageBytes;
+    if (data > raw) {
+        munmap(raw, data - raw);
+    }
+    if (raw + mapped > data + bytes) {
+        munmap(data + bytes, raw + mapped - (data + bytes));
+    }
+
+    if (hugePages != HugePages::Off) {
+        madvise(data, bytes, MADV_HUGEPAGE);
+    }
+    return data;
+}
+
+// Part k of the pages is placed on node k when first touched, whichever thread touches it.
+// Parts are whole huge pages: mbind can't split a hugetlb mapping elsewhere, and a part boundary
+// inside a transparent huge page would break it into small pages.
+void BindGridToNumaNodes(void* data, size_t bytes, unsigned nodes) {
+    char* bytesData = static_cast<char*>(data);
+    const size_t hugePages = bytes / HugePageBytes;
+
+    for (unsigned node = 0; node < nodes; node++) {
+        const size_t begin = hugePages * node / nodes * HugePageBytes;
+        const size_t end = (node + 1 == nodes) ? bytes : hugePages * (node + 1) / nodes * HugePageBytes;
+        if (begin == end) {
+            continue;
+        }
+
+        // Mask of as many words as the nodes take. The kernel reads one bit less than maxnode.
+        std::vector<unsigned long> mask((nodes + NodeMaskWordBits - 1) / NodeMaskWordBits, 0);
+        mask[node / NodeMaskWordBits] = 1ul << (node % NodeMaskWordBits);
+        if (syscall(SYS_mbind, bytesData + begin, end - begin, MemoryPolicyPreferred, mask.data(),
+                mask.size() * NodeMaskWordBits + 1, 0) != 0) {
+            LOGW << "Unable to bind grid memory to NUMA node " << node;
+        }
+    }
+}
+
+#endif
+
+
+namespace CellularAutomata {
+
+void* AllocateGridMemory(size_t bytes) {
+#ifdef __linux__
+    if (bytes >= LargeGridBytes) {
+        const size_t size = RoundToHugePages(bytes);
+        void* data = MapGridPages(size, CurrentGridPolicy.hugePages);
+        if (!data) {
+            throw std::bad_alloc();
+        }
+
+        const unsigned nodes = GetNumaNodeCount();
+        if (CurrentGridPolicy.numaBands && nodes > 1) {
+            BindGridToNumaNodes(data, size, nodes);
+        }
+        return data;
+    }
+#endif
+    return ::operator new(bytes);
+}
+
+void FreeGridMemory(void* data, size_t bytes) {
+#ifdef __linux__
+    if (bytes >= LargeGridBytes) {
+        munmap(data, RoundToHugePages(bytes));
+        return;
+    }
+#endif
+    ::operator delete(data);
+}
+
+void SetGridMemoryPolicy(const GridMemoryPolicy& policy) {
+    CurrentGridPolicy = policy;
+}
+
+GridMemoryPolicy GetGridMemoryPolicy() {
+    return CurrentGridPolicy;
+}
+
+unsigned GetNumaNodeCount() {
+#ifdef __linux__
+    return std::max(static_cast<unsigned>(GetNumaNodeCpus().size()), 1u);
+#else
+    return 1;
+#endif
+}
+
+unsigned GetNumaNodeOfRange(size_t range, size_t ranges) {
+    return static_cast<unsigned>(range * GetNumaNodeCount() / std::max<size_t>(ranges, 1));
+}
+
+#ifdef __linux__
+
+NumaNodeBinding::NumaNodeBinding(unsigned node) {
+    cpu_set_t saved;
+    CPU_ZERO(&saved);
+    if (sched_getaffinity(0, sizeof(saved), &saved) != 0) {
+        return;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    const auto& nodes = GetNumaNodeCpus();
+    if (node < nodes.size()) {
+        for (int cpu : nodes[node]) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &saved)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+    }
+
+    // Nodes without allowed CPUs leave the thread where it is
+    if (CPU_COUNT(&cpus) > 0 && sched_setaffinity(0, sizeof(cpus), &cpus) == 0) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&saved);
+        savedMask_.assign(bytes, bytes + sizeof(saved));
+    }
+}
+
+NumaNodeBinding::~NumaNodeBinding() {
+    if (!savedMask_.empty()) {
+        cpu_set_t saved;
+        std::memcpy(&saved, savedMask_.data(), sizeof(saved));
+        sched_setaffinity(0, sizeof(saved), &saved);
+    }
+}
+
+#else
+
+NumaNodeBinding::NumaNodeBinding(unsigned /*node*/) {
+}
+
+NumaNodeBinding::~NumaNodeBinding() {
+}
+
+#endif
+
+} // namespace CellularAutomata
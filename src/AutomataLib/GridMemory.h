@@ -0,0 +1,45 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    enum class HugePages {
+        Off = 0,         // Pages as the system gives them to the heap
+        Transparent = 1, // Regular pages the kernel is asked to merge into 2 MB pages
+        Explicit = 2,    // 2 MB pages reserved by the administrator, transparent ones when none are left
+    };
+
+    // How grids of at least LargeGridBytes are allocated, smaller ones always come from the heap.
+    // Set it before the grids are created, a grid keeps the memory it was given.
+    struct GridMemoryPolicy {
+        HugePages hugePages{ HugePages::Off };
+
+        // Large grids are split into a contiguous part per NUMA node, and the worker that steps a range
+        // of rows runs on the node that holds them. Linux only.
+        bool numaBands{ false };
+    };
+
+    constexpr size_t LargeGridBytes = 4 * 1024 * 1024;
+
+    void SetGridMemoryPolicy(const GridMemoryPolicy& policy);
+    GridMemoryPolicy GetGridMemoryPolicy();
+
+    // One node where the system doesn't tell
+    unsigned GetNumaNodeCount();
+
+    // Node of the range of ParallelFor workers, the same split as the one of the grid memory
+    unsigned GetNumaNodeOfRange(size_t range, size_t ranges);
+
+    // Keeps the calling thread on the CPUs of the node until destroyed
+    class NumaNodeBinding {
+    public:
+        explicit NumaNodeBinding(unsigned node);
+        ~NumaNodeBinding();
+
+        NumaNodeBinding(NumaNodeBinding const&) = delete;
+        NumaNodeBinding& operator=(NumaNodeBinding const&) = delete;
+
+    private:
+        std::vector<uint8_t> savedMask_;
+    };
+
+}
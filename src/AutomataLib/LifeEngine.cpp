@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "LifeKernel.h"
+#include "LifeEngine.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::GenerationStats;
+using CellularAutomata::HashCellWord;
+
+// Smaller grids are stepped faster than the threads are started
+constexpr size_t ParallelStepMinWords = 16 * 1024;
+
+uint64_t HashCells(const BitGrid& grid) {
+    const BitGrid::Word* data = grid.GetData();
+    uint64_t hash = 0;
+    for (size_t i = 0; i < grid.GetDataSize(); i++) {
+        if (data[i]) {
+            hash += HashCellWord(data[i], i);
+        }
+    }
+    return hash;
+}
+
+GenerationStats StepRows(const BitGrid& current, BitGrid& next, const CellularAutomata::AutomatonRules& rules,
+        size_t yBegin, size_t yEnd) {
+    const int width = current.GetWidth();
+    const int height = current.GetHeight();
+    const size_t words = current.GetWordsPerRow();
+
+    GenerationStats stats;
+    for (size_t y = yBegin; y < yEnd; y++) {
+        const int row = static_cast<int>(y);
+        CellularAutomata::StepRow(current.GetRow((row + height - 1) % height), current.GetRow(row),
+            current.GetRow((row + 1) % height), next.GetRow(row), words, width, rules, y * words, stats);
+    }
+    return stats;
+}
+
+
+namespace CellularAutomata {
+
+void LifeEngine::Resize(int width, int height) {
+    current_.Resize(width, height);
+    next_.Resize(width, height);
+    generation_ = 0;
+    stats_ = GenerationStats();
+}
+
+void LifeEngine::SetRules(const AutomatonRules& rules) {
+    rules_ = rules;
+}
+
+const AutomatonRules& LifeEngine::GetRules() const {
+    return rules_;
+}
+
+void LifeEngine::Load(const BitGrid& grid, uint64_t generation) {
+    current_ = grid;
+    next_.Resize(grid.GetWidth(), grid.GetHeight());
+    generation_ = generation;
+
+    stats_ = GenerationStats();
+    stats_.population = current_.GetPopulation();
+    stats_.hash = HashCells(current_);
+}
+
+const BitGrid& LifeEngine::GetGrid() const {
+    return current_;
+}
+
+BitGrid& LifeEngine::EditGrid() {
+    return current_;
+}
+
+void LifeEngine::Step(unsigned threads) {
+    const size_t height = static_cast<size_t>(current_.GetHeight());
+    if (height == 0) {
+        return;
+    }
+
+    if (threads == 0) {
+        threads = (current_.GetDataSize() >= ParallelStepMinWords) ? GetWorkerCount() : 1;
+    }
+
+    // Each range of rows counts its own cells
+    std::vector<GenerationStats> partial(std::max(threads, 1u));
+    std::atomic<size_t> nextSlot{ 0 };
+    ParallelFor(height, [&](size_t begin, size_t end) {
+        partial[nextSlot++] = StepRows(current_, next_, rules_, begin, end);
+    }, threads);
+
+    stats_ = GenerationStats();
+    for (const auto& p : partial) {
+        stats_.population += p.population;
+        stats_.births += p.births;
+        stats_.deaths += p.deaths;
+        stats_.hash += p.hash;
+    }
+
+    std::swap(current_, next_);
+    generation_++;
+}
+
+void LifeEngine::FastForward(uint64_t generation, uint64_t period, unsigned threads) {
+    if (generation <= generation_ || period == 0) {
+        return;
+    }
+
+    // Only the phase of the cycle has to be stepped
+    for (uint64_t i = (generation - generation_) % period; i > 0; i--) {
+        Step(threads);
+    }
+    generation_ = generation;
+}
+
+uint64_t LifeEngine::GetGeneration() const {
+    return generation_;
+}
+
+const GenerationStats& LifeEngine::GetStats() const {
+    return stats_;
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,46 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Life-like automaton on a bit-packed torus stepped on the CPU.
+    // Neighbours of 64 cells are summed at once with bitwise adders, and the counters
+    // of the generation are taken with popcounts of the words the step writes anyway.
+    class LifeEngine {
+    public:
+        LifeEngine() = default;
+
+        // Cells are cleared
+        void Resize(int width, int height);
+
+        void SetRules(const AutomatonRules& rules);
+        const AutomatonRules& GetRules() const;
+
+        // Population and hash are computed once here, later they come from the steps
+        void Load(const BitGrid& grid, uint64_t generation);
+
+        const BitGrid& GetGrid() const;
+
+        // Cells may be changed between the steps, the stats are then stale until the next step
+        BitGrid& EditGrid();
+
+        // Advance by one generation, rows are split between worker threads for large grids.
+        // Zero threads selects the count automatically.
+        void Step(unsigned threads = 0);
+
+        // Jump to the generation when the cells repeat with the period, only the remainder is stepped.
+        // Births and deaths are then counted from the last stepped generation.
+        void FastForward(uint64_t generation, uint64_t period, unsigned threads = 0);
+
+        uint64_t GetGeneration() const;
+        const GenerationStats& GetStats() const;
+
+    private:
+        BitGrid current_;
+        BitGrid next_;
+
+        AutomatonRules rules_{ 0, 8, 12 }; // B3/S23
+        uint64_t generation_{ 0 };
+        GenerationStats stats_;
+    };
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Bitwise building blocks of the CPU engines, each bit of a word is an independent cell
+
+    struct FullAdder {
+        BitGrid::Word sum;
+        BitGrid::Word carry;
+    };
+
+    inline FullAdder AddBits(BitGrid::Word a, BitGrid::Word b, BitGrid::Word c) {
+        BitGrid::Word ab = a ^ b;
+        return FullAdder{ ab ^ c, (a & b) | (c & ab) };
+    }
+
+    // Bit-sliced neighbour counts, count = b0 + 2 * b1 + 4 * b2 + 8 * b3
+    struct NeighbourCount {
+        BitGrid::Word b0, b1, b2, b3;
+    };
+
+    inline NeighbourCount CountNeighbours(const BitGrid::Word n[8]) {
+        FullAdder a = AddBits(n[0], n[1], n[2]);
+        FullAdder b = AddBits(n[3], n[4], n[5]);
+        FullAdder c = AddBits(n[6], n[7], 0);
+
+        FullAdder ones = AddBits(a.sum, b.sum, c.sum);
+        FullAdder twos = AddBits(a.carry, b.carry, c.carry);
+
+        // Twos of the ones carry and the twos sum
+        BitGrid::Word b1 = twos.sum ^ ones.carry;
+        BitGrid::Word fours = twos.sum & ones.carry;
+
+        return NeighbourCount{ ones.sum, b1, twos.carry ^ fours, twos.carry & fours };
+    }
+
+    // Cells whose neighbour count is in the mask, bit k of the mask stands for k neighbours
+    inline BitGrid::Word MatchCounts(int mask, const NeighbourCount& c) {
+        BitGrid::Word result = 0;
+        for (int k = 0; k <= 8; k++) {
+            if (mask & (1 << k)) {
+                result |= ((k & 1) ? c.b0 : ~c.b0) & ((k & 2) ? c.b1 : ~c.b1) &
+                    ((k & 4) ? c.b2 : ~c.b2) & ((k & 8) ? c.b3 : ~c.b3);
+            }
+        }
+        return result;
+    }
+
+    // Next state of the cells without branches on the rules, for loops where every word has its own rules.
+    // Each count is compared once for both masks.
+    inline BitGrid::Word ApplyRulesBranchless(int birth, int survive, BitGrid::Word alive, const NeighbourCount& c) {
+        BitGrid::Word result = 0;
+        for (int k = 0; k <= 8; k++) {
+            BitGrid::Word born = BitGrid::Word(0) - static_cast<BitGrid::Word>((birth >> k) & 1);
+            BitGrid::Word survives = BitGrid::Word(0) - static_cast<BitGrid::Word>((survive >> k) & 1);
+            BitGrid::Word match = ((k & 1) ? c.b0 : ~c.b0) & ((k & 2) ? c.b1 : ~c.b1) &
+                ((k & 4) ? c.b2 : ~c.b2) & ((k & 8) ? c.b3 : ~c.b3);
+            result |= match & ((alive & survives) | (~alive & born));
+        }
+        return result;
+    }
+
+    // Cells of a row shifted by one towards higher and lower x, wrapping around the row
+    struct ShiftedRow {
+        const BitGrid::Word* words;
+        size_t count;
+        int lastBit;                    // Bit of the last cell in the last word
+        BitGrid::Word firstCell;        // Cell 0 of the row
+        BitGrid::Word lastCell;         // Cell width - 1 of the row
+
+        ShiftedRow(const BitGrid::Word* row, size_t wordCount, int width)
+            : words(row)
+            , count(wordCount)
+            , lastBit((width - 1) % BitGrid::WordBits)
+            , firstCell(row[0] & 1)
+            , lastCell((row[wordCount - 1] >> lastBit) & 1) {
+        }
+
+        // Neighbours from x - 1
+        BitGrid::Word West(size_t j) const {
+            BitGrid::Word carry = (j == 0) ? lastCell : words[j - 1] >> (BitGrid::WordBits - 1);
+            return (words[j] << 1) | carry;
+        }
+
+        // Neighbours from x + 1
+        BitGrid::Word East(size_t j) const {
+            if (j + 1 == count) {
+                return (words[j] >> 1) | (firstCell << lastBit);
+            }
+            return (words[j] >> 1) | (words[j + 1] << (BitGrid::WordBits - 1));
+        }
+    };
+
+    // Hash of a non-empty word at the index in the grid. Words are hashed independently and the hashes
+    // are added, so that ranges of rows stepped by different threads are combined in any order.
+    inline uint64_t HashCellWord(BitGrid::Word cells, size_t index) {
+        uint64_t h = cells + index * 0x9e3779b97f4a7c15ull;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    }
+
+    // Next state of a row of a torus of the width from the rows below, at and above it.
+    // The counters of the row are added to the stats, firstIndex is the index of its first word in the grid.
+    inline void StepRow(const BitGrid::Word* belowRow, const BitGrid::Word* middleRow, const BitGrid::Word* aboveRow,
+            BitGrid::Word* out, size_t words, int width, const AutomatonRules& rules, size_t firstIndex,
+            GenerationStats& stats) {
+        // Padding bits of the last word stay zero
+        const int tailBits = width % BitGrid::WordBits;
+        const BitGrid::Word lastMask = tailBits ? (BitGrid::Word(1) << tailBits) - 1 : ~BitGrid::Word(0);
+
+        ShiftedRow below(belowRow, words, width);
+        ShiftedRow middle(middleRow, words, width);
+        ShiftedRow above(aboveRow, words, width);
+
+        for (size_t j = 0; j < words; j++) {
+            const BitGrid::Word neighbours[8] = {
+                below.West(j), below.words[j], below.East(j),
+                middle.West(j), middle.East(j),
+                above.West(j), above.words[j], above.East(j),
+            };
+            NeighbourCount count = CountNeighbours(neighbours);
+
+            const BitGrid::Word alive = middle.words[j];
+            BitGrid::Word cell = (alive & MatchCounts(rules.survive, count)) |
+                (~alive & MatchCounts(rules.birth, count));
+            if (j + 1 == words) {
+                cell &= lastMask;
+            }
+            out[j] = cell;
+
+            stats.population += std::bitset<64>(cell).count();
+            stats.births += std::bitset<64>(cell & ~alive).count();
+            stats.deaths += std::bitset<64>(alive & ~cell).count();
+            if (cell) {
+                stats.hash += HashCellWord(cell, firstIndex + j);
+            }
+        }
+    }
+
+}
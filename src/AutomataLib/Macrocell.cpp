@@ -0,0 +1,223 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "MappedFile.h"
+#include "PatternLoader.h"
+#include "NodeStore.h"
+#include "Macrocell.h"
+
+using CellularAutomata::NodeStore;
+using CellularAutomata::PatternInfo;
+
+const char* MacrocellLineEnd(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol ? eol : end;
+}
+
+// Parse a decimal number followed by blanks
+const char* ParseMacrocellNumber(const char* p, const char* end, int64_t& value) {
+    if (p == end || !std::isdigit(static_cast<unsigned char>(*p))) {
+        return nullptr;
+    }
+
+    value = 0;
+    while (p < end && std::isdigit(static_cast<unsigned char>(*p))) {
+        value = value * 10 + (*p++ - '0');
+        if (value > std::numeric_limits<uint32_t>::max()) {
+            return nullptr;
+        }
+    }
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+// 8x8 leaf: '.' dead cell, '*' alive cell, '$' end of the row
+bool ParseMacrocellLeaf(const char* p, const char* end, uint64_t& bits) {
+    bits = 0;
+    int row = 0;
+    int x = 0;
+    for (; p < end && *p != '\r'; p++) {
+        if (*p == '$') {
+            row++;
+            x = 0;
+            continue;
+        }
+        if ((*p != '.' && *p != '*') || row >= NodeStore::LeafSize || x >= NodeStore::LeafSize) {
+            return false;
+        }
+        if (*p == '*') {
+            bits |= uint64_t(1) << (NodeStore::LeafSize * row + x);
+        }
+        x++;
+    }
+    return true;
+}
+
+void WriteMacrocellLeaf(std::string& out, uint64_t bits) {
+    for (int row = 0; row < NodeStore::LeafSize && (bits >> (NodeStore::LeafSize * row)) != 0; row++) {
+        uint64_t rowBits = (bits >> (NodeStore::LeafSize * row)) & 0xff;
+        for (int x = 0; rowBits >> x; x++) {
+            out += ((rowBits >> x) & 1) ? '*' : '.';
+        }
+        out += '$';
+    }
+    if (bits == 0) {
+        out += '$';
+    }
+    out += '\n';
+}
+
+// Write children before parents, empty nodes are written as 0
+size_t WriteMacrocellNode(std::string& out, const NodeStore& store, NodeStore::NodeId id,
+        std::unordered_map<NodeStore::NodeId, size_t>& written, bool isRoot) {
+    const NodeStore::Node& node = store.GetNode(id);
+    if (node.population == 0 && !isRoot) {
+        return 0;
+    }
+
+    auto it = written.find(id);
+    if (it != written.end()) {
+        return it->second;
+    }
+
+    if (node.level == NodeStore::LeafLevel) {
+        WriteMacrocellLeaf(out, node.bits);
+    }
+    else {
+        size_t nw = WriteMacrocellNode(out, store, node.nw, written, false);
+        size_t ne = WriteMacrocellNode(out, store, node.ne, written, false);
+        size_t sw = WriteMacrocellNode(out, store, node.sw, written, false);
+        size_t se = WriteMacrocellNode(out, store, node.se, written, false);
+        out += std::to_string(node.level) + ' ' + std::to_string(nw) + ' ' + std::to_string(ne) + ' ' +
+            std::to_string(sw) + ' ' + std::to_string(se) + '\n';
+    }
+
+    size_t index = written.size() + 1;
+    written.emplace(id, index);
+    return index;
+}
+
+
+namespace CellularAutomata {
+
+bool LoadMacrocell(const std::filesystem::path& path, NodeStore& store, NodeStore::NodeId& root,
+        PatternInfo& info) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    return DecodeMacrocell(file.GetData(), file.GetSize(), store, root, info);
+}
+
+bool DecodeMacrocell(const char* data, size_t size, NodeStore& store, NodeStore::NodeId& root,
+        PatternInfo& info) {
+    info = PatternInfo();
+    info.format = PatternFormat::Macrocell;
+    info.bytes = size;
+
+    const char* p = data;
+    const char* end = data + size;
+
+    static const char Header[] = "[M2]";
+    if (size < sizeof(Header) - 1 || std::memcmp(data, Header, sizeof(Header) - 1) != 0) {
+        LOGE << "Macrocell header is missing";
+        return false;
+    }
+
+    // Node i of the file is nodes[i - 1]
+    std::vector<NodeStore::NodeId> nodes;
+    int lineNumber = 0;
+
+    for (p = MacrocellLineEnd(p, end); p < end; ) {
+        p++;
+        lineNumber++;
+        const char* eol = MacrocellLineEnd(p, end);
+
+        if (p == eol || *p == '\r') {
+            // Blank line
+        }
+        else if (*p == '#') {
+            if (eol - p > 2 && p[1] == 'R') {
+                std::string rule(p + 2, eol);
+                auto first = rule.find_first_not_of(" \t\r");
+                auto last = rule.find_last_not_of(" \t\r");
+                info.rule = (first == std::string::npos) ? std::string() : rule.substr(first, last - first + 1);
+            }
+        }
+        else if (*p == '.' || *p == '*' || *p == '$') {
+            uint64_t bits = 0;
+            if (!ParseMacrocellLeaf(p, eol, bits)) {
+                LOGE << "Macrocell leaf on line " << lineNumber + 1 << " is malformed";
+                return false;
+            }
+            nodes.push_back(store.MakeLeaf(bits));
+        }
+        else {
+            int64_t fields[5]{};
+            const char* q = p;
+            for (int64_t& field : fields) {
+                q = q ? ParseMacrocellNumber(q, eol, field) : nullptr;
+            }
+            if (!q || q != eol) {
+                LOGE << "Macrocell node on line " << lineNumber + 1 << " is malformed";
+                return false;
+            }
+
+            const int64_t level = fields[0];
+            if (level <= NodeStore::LeafLevel || level > NodeStore::MaxLevel) {
+                LOGE << "Macrocell node on line " << lineNumber + 1 << " has unsupported level " << level
+                    << ", only two-state patterns are supported";
+                return false;
+            }
+
+            NodeStore::NodeId children[4]{};
+            for (int i = 0; i < 4; i++) {
+                const int64_t index = fields[i + 1];
+                if (index > static_cast<int64_t>(nodes.size())) {
+                    LOGE << "Macrocell node on line " << lineNumber + 1 << " refers to undefined node " << index;
+                    return false;
+                }
+                children[i] = (index == 0) ? store.GetEmpty(static_cast<int>(level - 1)) : nodes[index - 1];
+                if (store.GetNode(children[i]).level != level - 1) {
+                    LOGE << "Macrocell node on line " << lineNumber + 1 << " has children of a wrong level";
+                    return false;
+                }
+            }
+            nodes.push_back(store.MakeNode(children[0], children[1], children[2], children[3]));
+        }
+
+        p = eol;
+    }
+
+    if (nodes.empty()) {
+        LOGE << "Macrocell pattern has no nodes";
+        return false;
+    }
+
+    // The last node is the root
+    root = nodes.back();
+    info.width = info.height = int64_t(1) << store.GetNode(root).level;
+    return true;
+}
+
+bool SaveMacrocell(const std::filesystem::path& path, const NodeStore& store, NodeStore::NodeId root,
+        const std::string& rule) {
+    std::string out = "[M2] (GameOfLifeGpu)\n";
+    if (!rule.empty()) {
+        out += "#R " + rule + '\n';
+    }
+
+    std::unordered_map<NodeStore::NodeId, size_t> written;
+    WriteMacrocellNode(out, store, root, written, true);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(out.data(), out.size())) {
+        LOGE << "Failed to write " << path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Macrocell format of Golly, *.mc. The file lists the nodes of the canonical quadtree
+    // bottom up, so a pattern of any size is loaded in time proportional to its distinct nodes.
+    // Only two-state patterns are supported.
+
+    bool LoadMacrocell(const std::filesystem::path& path, NodeStore& store, NodeStore::NodeId& root,
+        PatternInfo& info);
+
+    // Same for the pattern in memory
+    bool DecodeMacrocell(const char* data, size_t size, NodeStore& store, NodeStore::NodeId& root,
+        PatternInfo& info);
+
+    // Rule is omitted if empty
+    bool SaveMacrocell(const std::filesystem::path& path, const NodeStore& store, NodeStore::NodeId root,
+        const std::string& rule);
+
+}
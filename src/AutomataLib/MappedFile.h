@@ -0,0 +1,31 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Read-only memory mapping of a whole file
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        bool Open(const std::filesystem::path& path);
+        void Close();
+
+        // Data of an empty file is nullptr
+        const char* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        const char* data_{ nullptr };
+        size_t size_{ 0 };
+
+#ifdef _WIN32
+        void* file_{ nullptr };
+        void* mapping_{ nullptr };
+#endif
+    };
+
+}
@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "PatternLoader.h"
+#include "NodeStore.h"
+
+uint64_t SaturatedAdd(uint64_t a, uint64_t b) {
+    uint64_t sum = a + b;
+    return (sum < a) ? std::numeric_limits<uint64_t>::max() : sum;
+}
+
+uint64_t MixHash(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+
+namespace CellularAutomata {
+
+NodeStore::NodeStore() {
+    Clear();
+}
+
+void NodeStore::Clear() {
+    nodes_.clear();
+    index_.clear();
+    empty_.assign(MaxLevel + 1, 0);
+
+    empty_[LeafLevel] = MakeLeaf(0);
+}
+
+size_t NodeStore::NodeKeyHash::operator()(const NodeKey& key) const {
+    uint64_t h = static_cast<uint64_t>(key.level);
+    h = MixHash(h, key.nw);
+    h = MixHash(h, key.ne);
+    h = MixHash(h, key.sw);
+    h = MixHash(h, key.se);
+    h = MixHash(h, key.bits);
+    return static_cast<size_t>(h);
+}
+
+NodeStore::NodeId NodeStore::Intern(const NodeKey& key, uint64_t population) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        return it->second;
+    }
+
+    NodeId id = static_cast<NodeId>(nodes_.size());
+    nodes_.push_back(Node{ key.level, key.nw, key.ne, key.sw, key.se, key.bits, population });
+    index_.emplace(key, id);
+    return id;
+}
+
+NodeStore::NodeId NodeStore::MakeLeaf(uint64_t bits) {
+    return Intern(NodeKey{ LeafLevel, 0, 0, 0, 0, bits }, std::bitset<64>(bits).count());
+}
+
+NodeStore::NodeId NodeStore::MakeNode(NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    const int level = nodes_[nw].level + 1;
+
+    uint64_t population = SaturatedAdd(
+        SaturatedAdd(nodes_[nw].population, nodes_[ne].population),
+        SaturatedAdd(nodes_[sw].population, nodes_[se].population));
+
+    return Intern(NodeKey{ level, nw, ne, sw, se, 0 }, population);
+}
+
+NodeStore::NodeId NodeStore::GetEmpty(int level) {
+    level = std::clamp(level, LeafLevel, MaxLevel);
+    if (level > LeafLevel && nodes_[empty_[level]].level != level) {
+        NodeId child = GetEmpty(level - 1);
+        empty_[level] = MakeNode(child, child, child, child);
+    }
+    return empty_[level];
+}
+
+const NodeStore::Node& NodeStore::GetNode(NodeId id) const {
+    return nodes_[id];
+}
+
+size_t NodeStore::GetNodeCount() const {
+    return nodes_.size();
+}
+
+NodeStore::NodeId NodeStore::FromGrid(const BitGrid& grid) {
+    int level = LeafLevel;
+    while ((int64_t(1) << level) < std::max(grid.GetWidth(), grid.GetHeight())) {
+        level++;
+    }
+    return BuildFromGrid(grid, level, 0, 0);
+}
+
+NodeStore::NodeId NodeStore::BuildFromGrid(const BitGrid& grid, int level, int64_t px, int64_t row) {
+    if (px >= grid.GetWidth() || row >= grid.GetHeight()) {
+        return GetEmpty(level);
+    }
+
+    if (level == LeafLevel) {
+        // Leaves are aligned to bytes of the grid words
+        uint64_t bits = 0;
+        for (int r = 0; r < LeafSize && row + r < grid.GetHeight(); r++) {
+            int y = grid.GetHeight() - 1 - static_cast<int>(row + r);
+            BitGrid::Word word = grid.GetRow(y)[px / BitGrid::WordBits];
+            uint64_t rowBits = (word >> (px % BitGrid::WordBits)) & 0xff;
+            bits |= rowBits << (LeafSize * r);
+        }
+        return MakeLeaf(bits);
+    }
+
+    int64_t half = int64_t(1) << (level - 1);
+    return MakeNode(
+        BuildFromGrid(grid, level - 1, px, row),
+        BuildFromGrid(grid, level - 1, px + half, row),
+        BuildFromGrid(grid, level - 1, px, row + half),
+        BuildFromGrid(grid, level - 1, px + half, row + half));
+}
+
+void NodeStore::Rasterize(NodeId id, BitGrid& grid, const PatternPlacement& placement) const {
+    RasterizeNode(id, grid, placement.x0, placement.yTop);
+}
+
+void NodeStore::RasterizeNode(NodeId id, BitGrid& grid, int64_t x, int64_t yTop) const {
+    const Node& node = nodes_[id];
+    if (node.population == 0) {
+        return;
+    }
+
+    // Skip nodes outside of the grid
+    int64_t size = int64_t(1) << node.level;
+    if (x >= grid.GetWidth() || x + size <= 0 || yTop < 0 || yTop - size >= grid.GetHeight() - 1) {
+        return;
+    }
+
+    if (node.level == LeafLevel) {
+        for (int r = 0; r < LeafSize; r++) {
+            int64_t y = yTop - r;
+            uint64_t rowBits = (node.bits >> (LeafSize * r)) & 0xff;
+            if (rowBits != 0 && y >= 0 && y < grid.GetHeight()) {
+                grid.OrBits(x, static_cast<int>(y), rowBits, LeafSize);
+            }
+        }
+        return;
+    }
+
+    int64_t half = size / 2;
+    RasterizeNode(node.nw, grid, x, yTop);
+    RasterizeNode(node.ne, grid, x + half, yTop);
+    RasterizeNode(node.sw, grid, x, yTop - half);
+    RasterizeNode(node.se, grid, x + half, yTop - half);
+}
+
+} // namespace CellularAutomata
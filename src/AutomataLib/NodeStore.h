@@ -0,0 +1,69 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Canonical quadtree of cells as used by HashLife. Equal subtrees are stored once,
+    // so regular patterns of astronomic size take few nodes.
+    // Node of level k covers 2^k x 2^k cells, leaves are 8x8 blocks of level 3.
+    class NodeStore {
+    public:
+        using NodeId = uint32_t;
+
+        static constexpr int LeafLevel = 3;
+        static constexpr int LeafSize = 8;
+        static constexpr int MaxLevel = 62;
+
+        struct Node {
+            int level;
+            NodeId nw, ne, sw, se; // Children of non-leaf nodes
+            uint64_t bits;         // Cells of a leaf, bit 8 * row + column, row 0 is the top one
+            uint64_t population;   // Saturated at the maximum of uint64_t
+        };
+
+    public:
+        NodeStore();
+
+        void Clear();
+
+        NodeId MakeLeaf(uint64_t bits);
+        NodeId MakeNode(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+        NodeId GetEmpty(int level);
+
+        const Node& GetNode(NodeId id) const;
+        size_t GetNodeCount() const;
+
+        // Quadtree of the grid, the top row of the grid is the top row of the node
+        NodeId FromGrid(const BitGrid& grid);
+
+        // Set the alive cells of the node in the grid. The top left cell of the node is
+        // placed at the grid position of the placement, cells outside of the grid are skipped.
+        void Rasterize(NodeId id, BitGrid& grid, const PatternPlacement& placement) const;
+
+    private:
+        struct NodeKey {
+            int level;
+            NodeId nw, ne, sw, se;
+            uint64_t bits;
+
+            bool operator==(const NodeKey& other) const {
+                return level == other.level && nw == other.nw && ne == other.ne &&
+                    sw == other.sw && se == other.se && bits == other.bits;
+            }
+        };
+
+        struct NodeKeyHash {
+            size_t operator()(const NodeKey& key) const;
+        };
+
+        NodeId Intern(const NodeKey& key, uint64_t population);
+
+        NodeId BuildFromGrid(const BitGrid& grid, int level, int64_t px, int64_t row);
+        void RasterizeNode(NodeId id, BitGrid& grid, int64_t x, int64_t y) const;
+
+    private:
+        std::vector<Node> nodes_;
+        std::unordered_map<NodeKey, NodeId, NodeKeyHash> index_;
+        std::vector<NodeId> empty_; // Empty node of every level
+    };
+
+}
@@ -0,0 +1,231 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "LifeKernel.h"
+#include "PaddedEngine.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::GenerationStats;
+
+// Smaller grids are stepped faster than the threads are started
+constexpr size_t ParallelPaddedMinWords = 16 * 1024;
+
+// Cells [x, x + count) of the row in the low bits, up to 64 cells inside the row.
+// The word after the last one may be read, its bits are dropped.
+BitGrid::Word ReadRowCells(const BitGrid::Word* row, int64_t x, int count) {
+    const int64_t j = x / BitGrid::WordBits;
+    const int shift = static_cast<int>(x % BitGrid::WordBits);
+    BitGrid::Word cells = row[j] >> shift;
+    if (shift > 0 && shift + count > BitGrid::WordBits) {
+        cells |= row[j + 1] << (BitGrid::WordBits - shift);
+    }
+    return count < BitGrid::WordBits ? cells & ((BitGrid::Word(1) << count) - 1) : cells;
+}
+
+// 64 cells of the row from x on, wrapping around the row of the width
+BitGrid::Word GetWrappedCells(const BitGrid::Word* row, int width, int64_t x) {
+    int64_t cx = (x % width + width) % width;
+    BitGrid::Word cells = 0;
+    for (int filled = 0; filled < BitGrid::WordBits; cx = 0) {
+        const int count = static_cast<int>(std::min<int64_t>(BitGrid::WordBits - filled, width - cx));
+        cells |= ReadRowCells(row, cx, count) << filled;
+        filled += count;
+    }
+    return cells;
+}
+
+// Ghost words of a row, and the padding bits of its last word when the width isn't a multiple of 64.
+// The padding bits then continue the row with its first cells, only the cells of the row are read.
+void RefreshGhostWords(BitGrid::Word* row, size_t words, int width) {
+    if (width % BitGrid::WordBits == 0) {
+        row[-1] = row[words - 1];
+        row[words] = row[0];
+        return;
+    }
+
+    const int64_t last = static_cast<int64_t>(words - 1) * BitGrid::WordBits;
+    row[-1] = GetWrappedCells(row, width, -BitGrid::WordBits);
+    row[words] = GetWrappedCells(row, width, last + BitGrid::WordBits);
+    row[words - 1] = GetWrappedCells(row, width, last);
+}
+
+// Neighbours from x - 1 and x + 1 of the word, the words before and after it are always there
+inline BitGrid::Word GetPaddedWest(const BitGrid::Word* w) {
+    return (w[0] << 1) | (w[-1] >> (BitGrid::WordBits - 1));
+}
+
+inline BitGrid::Word GetPaddedEast(const BitGrid::Word* w) {
+    return (w[0] >> 1) | (w[1] << (BitGrid::WordBits - 1));
+}
+
+inline BitGrid::Word StepPaddedWord(const BitGrid::Word* below, const BitGrid::Word* middle, const BitGrid::Word* above,
+        const CellularAutomata::AutomatonRules& rules) {
+    const BitGrid::Word neighbours[8] = {
+        GetPaddedWest(below), below[0], GetPaddedEast(below),
+        GetPaddedWest(middle), GetPaddedEast(middle),
+        GetPaddedWest(above), above[0], GetPaddedEast(above),
+    };
+    const CellularAutomata::NeighbourCount count = CellularAutomata::CountNeighbours(neighbours);
+
+    const BitGrid::Word alive = middle[0];
+    return (alive & CellularAutomata::MatchCounts(rules.survive, count)) |
+        (~alive & CellularAutomata::MatchCounts(rules.birth, count));
+}
+
+inline void AddPaddedStats(BitGrid::Word cell, BitGrid::Word alive, size_t index, GenerationStats& stats) {
+    stats.population += std::bitset<64>(cell).count();
+    stats.births += std::bitset<64>(cell & ~alive).count();
+    stats.deaths += std::bitset<64>(alive & ~cell).count();
+    if (cell) {
+        stats.hash += CellularAutomata::HashCellWord(cell, index);
+    }
+}
+
+// Next state of a padded row and its ghost words, the stats and hashes are the ones of StepRow
+void StepPaddedRow(const BitGrid::Word* below, const BitGrid::Word* middle, const BitGrid::Word* above,
+        BitGrid::Word* out, size_t words, int width, const CellularAutomata::AutomatonRules& rules, size_t firstIndex,
+        GenerationStats& stats) {
+    const size_t last = words - 1;
+    for (size_t j = 0; j < last; j++) {
+        const BitGrid::Word cell = StepPaddedWord(below + j, middle + j, above + j, rules);
+        AddPaddedStats(cell, middle[j], firstIndex + j, stats);
+        out[j] = cell;
+    }
+
+    // Padding bits of the last word are cleared out of the loop
+    const int tailBits = width % BitGrid::WordBits;
+    const BitGrid::Word lastMask = tailBits ? (BitGrid::Word(1) << tailBits) - 1 : ~BitGrid::Word(0);
+    const BitGrid::Word cell = StepPaddedWord(below + last, middle + last, above + last, rules) & lastMask;
+    AddPaddedStats(cell, middle[last] & lastMask, firstIndex + last, stats);
+    out[last] = cell;
+
+    RefreshGhostWords(out, words, width);
+}
+
+
+namespace CellularAutomata {
+
+void PaddedEngine::Resize(int width, int height) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    words_ = (static_cast<size_t>(width_) + BitGrid::WordBits - 1) / BitGrid::WordBits;
+    stride_ = words_ + 2;
+
+    current_.assign(stride_ * (height_ + 2), 0);
+    next_.assign(stride_ * (height_ + 2), 0);
+    generation_ = 0;
+    stats_ = GenerationStats();
+}
+
+void PaddedEngine::SetRules(const AutomatonRules& rules) {
+    rules_ = rules;
+}
+
+const AutomatonRules& PaddedEngine::GetRules() const {
+    return rules_;
+}
+
+void PaddedEngine::Load(const BitGrid& grid, uint64_t generation) {
+    Resize(grid.GetWidth(), grid.GetHeight());
+    generation_ = generation;
+
+    stats_.population = grid.GetPopulation();
+    for (int y = 0; y < height_; y++) {
+        const BitGrid::Word* src = grid.GetRow(y);
+        Word* dst = Row(current_, y);
+        for (size_t j = 0; j < words_; j++) {
+            dst[j] = src[j];
+            if (src[j]) {
+                stats_.hash += HashCellWord(src[j], y * words_ + j);
+            }
+        }
+        if (words_ > 0) {
+            RefreshGhostWords(dst, words_, width_);
+        }
+    }
+    RefreshGhostRows(current_);
+}
+
+void PaddedEngine::Store(BitGrid& grid) const {
+    grid.Resize(width_, height_);
+    if (words_ == 0) {
+        return;
+    }
+
+    const int tailBits = width_ % BitGrid::WordBits;
+    const Word lastMask = tailBits ? (Word(1) << tailBits) - 1 : ~Word(0);
+    for (int y = 0; y < height_; y++) {
+        const Word* src = Row(current_, y);
+        Word* dst = grid.GetRow(y);
+        std::copy(src, src + words_, dst);
+        dst[words_ - 1] &= lastMask;
+    }
+}
+
+int PaddedEngine::GetWidth() const {
+    return width_;
+}
+
+int PaddedEngine::GetHeight() const {
+    return height_;
+}
+
+void PaddedEngine::Step(unsigned threads) {
+    if (height_ == 0 || words_ == 0) {
+        return;
+    }
+
+    if (threads == 0) {
+        threads = (words_ * height_ >= ParallelPaddedMinWords) ? GetWorkerCount() : 1;
+    }
+
+    // Each range of rows counts its own cells, the ghost rows are read but only written below
+    std::vector<GenerationStats> partial(std::max(threads, 1u));
+    std::atomic<size_t> nextSlot{ 0 };
+    ParallelFor(static_cast<size_t>(height_), [&](size_t begin, size_t end) {
+        GenerationStats stats;
+        for (size_t y = begin; y < end; y++) {
+            const int row = static_cast<int>(y);
+            StepPaddedRow(Row(current_, row - 1), Row(current_, row), Row(current_, row + 1), Row(next_, row),
+                words_, width_, rules_, y * words_, stats);
+        }
+        partial[nextSlot++] = stats;
+    }, threads);
+    RefreshGhostRows(next_);
+
+    stats_ = GenerationStats();
+    for (const auto& p : partial) {
+        stats_.population += p.population;
+        stats_.births += p.births;
+        stats_.deaths += p.deaths;
+        stats_.hash += p.hash;
+    }
+
+    std::swap(current_, next_);
+    generation_++;
+}
+
+uint64_t PaddedEngine::GetGeneration() const {
+    return generation_;
+}
+
+const GenerationStats& PaddedEngine::GetStats() const {
+    return stats_;
+}
+
+BitGrid::Word* PaddedEngine::Row(Cells& cells, int y) const {
+    return cells.data() + static_cast<size_t>(y + 1) * stride_ + 1;
+}
+
+const BitGrid::Word* PaddedEngine::Row(const Cells& cells, int y) const {
+    return cells.data() + static_cast<size_t>(y + 1) * stride_ + 1;
+}
+
+// Whole rows with their ghost words, the bottom ghost row is the top row of the torus and the other way around
+void PaddedEngine::RefreshGhostRows(Cells& cells) const {
+    std::memcpy(Row(cells, -1) - 1, Row(cells, height_ - 1) - 1, stride_ * sizeof(Word));
+    std::memcpy(Row(cells, height_) - 1, Row(cells, 0) - 1, stride_ * sizeof(Word));
+}
+
+} // namespace CellularAutomata
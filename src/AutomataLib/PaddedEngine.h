@@ -0,0 +1,60 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Life-like automaton on a bit-packed torus stepped on the CPU, like LifeEngine, with rows
+    // padded by a ghost word on each side and a ghost row above and below the grid.
+    // The ghost cells hold the cells of the other side of the torus, so every word of the grid
+    // is stepped with the same shifts and no branches on the wrap around.
+    // Ghost words are refreshed by the thread that steps their row, ghost rows are copied once per step.
+    class PaddedEngine {
+    public:
+        PaddedEngine() = default;
+
+        // Cells are cleared
+        void Resize(int width, int height);
+
+        void SetRules(const AutomatonRules& rules);
+        const AutomatonRules& GetRules() const;
+
+        // Population and hash are computed once here, later they come from the steps
+        void Load(const BitGrid& grid, uint64_t generation);
+
+        // Cells without the ghosts
+        void Store(BitGrid& grid) const;
+
+        int GetWidth() const;
+        int GetHeight() const;
+
+        // Advance by one generation, rows are split between worker threads for large grids.
+        // Zero threads selects the count automatically.
+        void Step(unsigned threads = 0);
+
+        uint64_t GetGeneration() const;
+        const GenerationStats& GetStats() const;
+
+    private:
+        using Word = BitGrid::Word;
+        using Cells = std::vector<Word, GridAllocator<Word>>;
+
+        // Word 0 of row y, rows -1 and height and words -1 and words are the ghosts
+        Word* Row(Cells& cells, int y) const;
+        const Word* Row(const Cells& cells, int y) const;
+
+        void RefreshGhostRows(Cells& cells) const;
+
+    private:
+        int width_{ 0 };
+        int height_{ 0 };
+        size_t words_{ 0 };     // Words of the cells of a row
+        size_t stride_{ 0 };    // Words of a row with its ghost words
+
+        Cells current_;
+        Cells next_;
+
+        AutomatonRules rules_{ 0, 8, 12 }; // B3/S23
+        uint64_t generation_{ 0 };
+        GenerationStats stats_;
+    };
+
+}
@@ -0,0 +1,60 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "GridMemory.h"
+#include "Parallel.h"
+
+
+namespace CellularAutomata {
+
+unsigned GetWorkerCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return (count > 0) ? count : 1;
+}
+
+void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn, unsigned threads) {
+    if (threads == 0) {
+        threads = GetWorkerCount();
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+    if (threads <= 1) {
+        if (count > 0) {
+            fn(0, count);
+        }
+        return;
+    }
+
+    // Ranges follow the split of the grid memory over the nodes
+    const bool numaBands = GetGridMemoryPolicy().numaBands && GetNumaNodeCount() > 1;
+    auto run = [&fn, numaBands, threads](unsigned range, size_t begin, size_t end) {
+        if (numaBands) {
+            NumaNodeBinding binding(GetNumaNodeOfRange(range, threads));
+            fn(begin, end);
+        }
+        else {
+            fn(begin, end);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    // The calling thread takes the last range
+    size_t begin = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        size_t end = count * (i + 1) / threads;
+        if (i + 1 < threads) {
+            workers.emplace_back(run, i, begin, end);
+        }
+        else {
+            run(i, begin, end);
+        }
+        begin = end;
+    }
+
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Number of worker threads used by default
+    unsigned GetWorkerCount();
+
+    // Split [0, count) into contiguous ranges and process them on worker threads.
+    // Zero threads means GetWorkerCount(). Returns when all ranges are done.
+    void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn, unsigned threads = 0);
+
+}
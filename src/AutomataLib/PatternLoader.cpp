@@ -0,0 +1,374 @@
+#include "stdafx.h"
+#include "BitGrid.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "PatternLoader.h"
+#include "NodeStore.h"
+#include "Macrocell.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::PatternInfo;
+using CellularAutomata::PatternPlacement;
+
+// Longer runs are clipped by the grid anyway
+constexpr int64_t MaxRunLength = int64_t(1) << 48;
+
+// Smaller patterns are decoded faster than the threads are started
+constexpr size_t ParallelDecodeMinSize = 4 * 1024 * 1024;
+
+bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char* SkipLine(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol ? eol + 1 : end;
+}
+
+std::string Trim(const std::string& str) {
+    auto first = str.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    auto last = str.find_last_not_of(" \t\r\n");
+    return str.substr(first, last - first + 1);
+}
+
+void SetClippedRun(BitGrid& grid, const PatternPlacement& placement, int64_t px, int64_t row, int64_t length) {
+    int64_t y = placement.yTop - row;
+    if (y < 0 || y >= grid.GetHeight()) {
+        return;
+    }
+
+    int64_t x0 = std::max<int64_t>(placement.x0 + px, 0);
+    int64_t x1 = std::min<int64_t>(placement.x0 + px + length, grid.GetWidth());
+    if (x0 < x1) {
+        grid.SetRange(static_cast<int>(x0), static_cast<int>(x1), static_cast<int>(y));
+    }
+}
+
+// Parse comments and the "x = m, y = n, rule = abc" line, return the start of the encoded cells
+const char* ParseRleHeader(const char* p, const char* end, PatternInfo& info) {
+    while (p < end) {
+        if (IsBlank(*p)) {
+            p++;
+        }
+        else if (*p == '#') {
+            p = SkipLine(p, end);
+        }
+        else if (*p == 'x') {
+            break;
+        }
+        else {
+            LOGE << "RLE header is missing";
+            return nullptr;
+        }
+    }
+
+    const char* eol = SkipLine(p, end);
+    std::stringstream header(std::string(p, eol));
+
+    std::string item;
+    while (std::getline(header, item, ',')) {
+        auto eq = item.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = Trim(item.substr(0, eq));
+        std::string value = Trim(item.substr(eq + 1));
+        if (key == "x") {
+            info.width = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if (key == "y") {
+            info.height = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if (key == "rule") {
+            info.rule = value;
+        }
+    }
+
+    if (info.width <= 0 || info.height <= 0) {
+        LOGE << "RLE header has no pattern size";
+        return nullptr;
+    }
+
+    return eol;
+}
+
+// Position in the pattern while walking the encoded cells
+struct RleCursor {
+    int64_t row{ 0 };
+    int64_t x{ 0 };
+    bool ended{ false }; // '!' was reached
+};
+
+struct RleRun {
+    int64_t x;
+    int64_t row;
+    int64_t length;
+};
+
+// Walk the encoded cells and call emitRun(x, row, length) for every run of alive cells.
+// Stops at the end of the pattern or when the row passes lastRow.
+template <typename EmitRun>
+void WalkRle(const char* p, const char* end, RleCursor& cursor, int64_t lastRow, EmitRun&& emitRun) {
+    int64_t run = 0;
+
+    for (; p < end; p++) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            run = std::min(run * 10 + (c - '0'), MaxRunLength);
+            continue;
+        }
+        if (IsBlank(c)) {
+            continue;
+        }
+
+        int64_t n = (run > 0) ? run : 1;
+        run = 0;
+
+        if (c == 'b' || c == '.') {
+            cursor.x += n;
+        }
+        else if (c == '$') {
+            cursor.row += n;
+            cursor.x = 0;
+            if (cursor.row > lastRow) {
+                return;
+            }
+        }
+        else if (c == '!') {
+            cursor.ended = true;
+            return;
+        }
+        else if (c == '#') {
+            p = SkipLine(p, end) - 1;
+        }
+        else {
+            // 'o' and the states of multi-state patterns are alive
+            emitRun(cursor.x, cursor.row, n);
+            cursor.x += n;
+        }
+    }
+}
+
+// Position after the chunk, given the position before it and the change made by the chunk
+RleCursor AdvanceRleCursor(const RleCursor& start, const RleCursor& chunk) {
+    if (start.ended) {
+        return start;
+    }
+
+    RleCursor cursor;
+    cursor.row = start.row + chunk.row;
+    cursor.x = (chunk.row > 0) ? chunk.x : start.x + chunk.x;
+    cursor.ended = chunk.ended;
+    return cursor;
+}
+
+// Move the chunk boundary forward to a token boundary, so that no run count is split
+const char* AlignRleBoundary(const char* p, const char* end) {
+    while (p < end && ((p[-1] >= '0' && p[-1] <= '9') || IsBlank(p[-1]))) {
+        p++;
+    }
+    return p;
+}
+
+void DecodeRle(const char* p, const char* end, BitGrid& grid, const PatternPlacement& placement) {
+    RleCursor cursor;
+    WalkRle(p, end, cursor, placement.yTop, [&](int64_t x, int64_t row, int64_t length) {
+        SetClippedRun(grid, placement, x, row, length);
+    });
+}
+
+void DecodeRleParallel(const char* begin, const char* end, BitGrid& grid, const PatternPlacement& placement,
+        unsigned threads) {
+    const size_t size = end - begin;
+
+    // One chunk per thread, boundaries are moved to the ends of tokens
+    std::vector<const char*> bounds(threads + 1);
+    bounds[0] = begin;
+    bounds[threads] = end;
+    for (unsigned i = 1; i < threads; i++) {
+        bounds[i] = std::max(AlignRleBoundary(begin + size * i / threads, end), bounds[i - 1]);
+    }
+
+    // Change of the position made by every chunk, counting row ends and runs
+    std::vector<RleCursor> changes(threads);
+    CellularAutomata::ParallelFor(threads, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            WalkRle(bounds[i], bounds[i + 1], changes[i], std::numeric_limits<int64_t>::max(),
+                [](int64_t, int64_t, int64_t) {});
+        }
+    }, threads);
+
+    // Prefix scan gives the position at the start of every chunk
+    std::vector<RleCursor> starts(threads + 1);
+    for (unsigned i = 0; i < threads; i++) {
+        starts[i + 1] = AdvanceRleCursor(starts[i], changes[i]);
+    }
+
+    // Rows strictly inside of a chunk belong to it only. The first and the last rows
+    // may share words with the neighbour chunks, their runs are set afterwards.
+    std::vector<std::vector<RleRun>> sharedRuns(threads);
+    CellularAutomata::ParallelFor(threads, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            RleCursor cursor = starts[i];
+            if (cursor.ended || cursor.row > placement.yTop) {
+                continue;
+            }
+
+            const int64_t firstRow = starts[i].row;
+            const int64_t lastRow = starts[i + 1].row;
+            WalkRle(bounds[i], bounds[i + 1], cursor, placement.yTop, [&](int64_t x, int64_t row, int64_t length) {
+                if (row == firstRow || row == lastRow) {
+                    sharedRuns[i].push_back(RleRun{ x, row, length });
+                }
+                else {
+                    SetClippedRun(grid, placement, x, row, length);
+                }
+            });
+        }
+    }, threads);
+
+    for (const auto& runs : sharedRuns) {
+        for (const auto& r : runs) {
+            SetClippedRun(grid, placement, r.x, r.row, r.length);
+        }
+    }
+}
+
+bool IsPlainTextCell(char c) {
+    return c == 'O' || c == '*';
+}
+
+void MeasurePlainText(const char* p, const char* end, PatternInfo& info) {
+    info.width = 0;
+    info.height = 0;
+
+    while (p < end) {
+        const char* eol = SkipLine(p, end);
+        if (*p != '!') {
+            const char* last = eol;
+            while (last > p && IsBlank(last[-1])) {
+                last--;
+            }
+            info.width = std::max<int64_t>(info.width, last - p);
+            info.height++;
+        }
+        p = eol;
+    }
+}
+
+void DecodePlainText(const char* p, const char* end, BitGrid& grid, const PatternPlacement& placement) {
+    int64_t row = 0;
+    while (p < end && placement.yTop - row >= 0) {
+        const char* eol = SkipLine(p, end);
+        if (*p == '!') {
+            p = eol;
+            continue;
+        }
+
+        for (const char* c = p; c < eol; ) {
+            if (!IsPlainTextCell(*c)) {
+                c++;
+                continue;
+            }
+            const char* runEnd = c;
+            while (runEnd < eol && IsPlainTextCell(*runEnd)) {
+                runEnd++;
+            }
+            SetClippedRun(grid, placement, c - p, row, runEnd - c);
+            c = runEnd;
+        }
+
+        row++;
+        p = eol;
+    }
+}
+
+
+namespace CellularAutomata {
+
+PatternFormat GetPatternFormat(const std::filesystem::path& path) {
+    auto ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (ext == ".cells" || ext == ".txt") {
+        return PatternFormat::PlainText;
+    }
+    if (ext == ".mc") {
+        return PatternFormat::Macrocell;
+    }
+    return PatternFormat::Rle;
+}
+
+PatternPlacement GetCenteredPlacement(const BitGrid& grid, const PatternInfo& info) {
+    return PatternPlacement{
+        (grid.GetWidth() - info.width) / 2,
+        (grid.GetHeight() + info.height) / 2 - 1
+    };
+}
+
+bool LoadPattern(const std::filesystem::path& path, BitGrid& grid, PatternInfo& info, unsigned threads) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    return DecodePattern(file.GetData(), file.GetSize(), GetPatternFormat(path), grid, info, threads);
+}
+
+bool DecodePattern(const char* data, size_t size, PatternFormat format, BitGrid& grid, PatternInfo& info,
+        unsigned threads) {
+    info = PatternInfo();
+    info.format = format;
+    info.bytes = size;
+
+    if (size == 0) {
+        LOGE << "Pattern is empty";
+        return false;
+    }
+
+    // The cells of the grid are kept when the pattern fails to decode
+    BitGrid decoded(grid.GetWidth(), grid.GetHeight());
+    const char* end = data + size;
+
+    if (format == PatternFormat::PlainText) {
+        MeasurePlainText(data, end, info);
+        DecodePlainText(data, end, decoded, GetCenteredPlacement(decoded, info));
+    }
+    else if (format == PatternFormat::Macrocell) {
+        NodeStore store;
+        NodeStore::NodeId root = 0;
+        if (!DecodeMacrocell(data, size, store, root, info)) {
+            return false;
+        }
+        store.Rasterize(root, decoded, GetCenteredPlacement(decoded, info));
+    }
+    else {
+        const char* cells = ParseRleHeader(data, end, info);
+        if (!cells) {
+            return false;
+        }
+
+        if (threads == 0) {
+            threads = (size >= ParallelDecodeMinSize) ? GetWorkerCount() : 1;
+        }
+
+        // Comments between the cells can't be split into chunks safely
+        const size_t cellsSize = end - cells;
+        if (threads > 1 && cellsSize > threads && !std::memchr(cells, '#', cellsSize)) {
+            DecodeRleParallel(cells, end, decoded, GetCenteredPlacement(decoded, info), threads);
+            info.threads = threads;
+        }
+        else {
+            DecodeRle(cells, end, decoded, GetCenteredPlacement(decoded, info));
+        }
+    }
+
+    grid = std::move(decoded);
+    return true;
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,45 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    enum class PatternFormat {
+        Unknown,
+        Rle,       // Run Length Encoded, *.rle
+        PlainText, // Plaintext, *.cells
+        Macrocell, // Macrocell of Golly, *.mc
+    };
+
+    struct PatternInfo {
+        PatternFormat format{ PatternFormat::Unknown };
+        int64_t width{ 0 };
+        int64_t height{ 0 };
+        std::string rule; // Empty if the file doesn't specify the rule
+
+        size_t bytes{ 0 };    // Size of the encoded pattern
+        unsigned threads{ 1 }; // Worker threads used for decoding
+    };
+
+    // Grid position of the top left cell of the pattern
+    struct PatternPlacement {
+        int64_t x0;
+        int64_t yTop;
+    };
+
+    // Format is detected by the extension, RLE is assumed for unknown ones
+    PatternFormat GetPatternFormat(const std::filesystem::path& path);
+
+    // Placement of the pattern in the center of the grid
+    PatternPlacement GetCenteredPlacement(const BitGrid& grid, const PatternInfo& info);
+
+    // Decode the pattern centered in the grid, cells outside of the grid are skipped.
+    // The file is memory mapped and decoded into a grid of the same size, which replaces the cells
+    // of the grid only when the pattern is valid.
+    // Large RLE files are split into chunks decoded by worker threads, zero threads
+    // selects the count automatically and one thread forces sequential decoding.
+    bool LoadPattern(const std::filesystem::path& path, BitGrid& grid, PatternInfo& info, unsigned threads = 0);
+
+    // Same for the pattern in memory
+    bool DecodePattern(const char* data, size_t size, PatternFormat format, BitGrid& grid, PatternInfo& info,
+        unsigned threads = 0);
+
+}
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "LifeEngine.h"
+#include "EnsembleEngine.h"
+#include "PeriodDetector.h"
+
+using CellularAutomata::BitGrid;
+
+bool SameCells(const BitGrid& a, const BitGrid& b) {
+    return a.GetWidth() == b.GetWidth() && a.GetHeight() == b.GetHeight() &&
+        std::equal(a.GetData(), a.GetData() + a.GetDataSize(), b.GetData());
+}
+
+
+namespace CellularAutomata {
+
+PeriodDetector::PeriodDetector(uint32_t maxPeriod) {
+    Reset(maxPeriod);
+}
+
+void PeriodDetector::Reset(uint32_t maxPeriod) {
+    maxPeriod_ = std::max(maxPeriod, 1u);
+    hashes_.assign(maxPeriod_, 0);
+    Reset();
+}
+
+void PeriodDetector::Reset() {
+    head_ = 0;
+    count_ = 0;
+    lastGeneration_ = 0;
+
+    candidate_ = BitGrid();
+    candidateGeneration_ = 0;
+    candidatePeriod_ = 0;
+
+    period_ = 0;
+    stableGeneration_ = 0;
+}
+
+bool PeriodDetector::Observe(const LifeEngine& engine) {
+    if (period_) {
+        return true;
+    }
+
+    // Generations must follow each other, the history is restarted otherwise
+    const uint64_t generation = engine.GetGeneration();
+    if (count_ > 0 && generation != lastGeneration_ + 1) {
+        Reset();
+    }
+    lastGeneration_ = generation;
+
+    const uint64_t hash = engine.GetStats().hash;
+
+    if (candidatePeriod_ && generation == candidateGeneration_ + candidatePeriod_) {
+        if (SameCells(candidate_, engine.GetGrid())) {
+            period_ = candidatePeriod_;
+            stableGeneration_ = candidateGeneration_;
+            candidate_ = BitGrid();
+            return true;
+        }
+        candidatePeriod_ = 0;
+    }
+
+    // The smallest matching period is tried first, the cells are copied only on a hash match
+    if (!candidatePeriod_) {
+        for (uint32_t p = 1; p <= count_; p++) {
+            if (hashes_[(head_ + hashes_.size() - p) % hashes_.size()] == hash) {
+                candidate_ = engine.GetGrid();
+                candidateGeneration_ = generation;
+                candidatePeriod_ = p;
+                break;
+            }
+        }
+    }
+
+    hashes_[head_] = hash;
+    head_ = (head_ + 1) % hashes_.size();
+    count_ = std::min(count_ + 1, hashes_.size());
+
+    return false;
+}
+
+bool PeriodDetector::IsStable() const {
+    return period_ != 0;
+}
+
+uint32_t PeriodDetector::GetPeriod() const {
+    return period_;
+}
+
+uint64_t PeriodDetector::GetStableGeneration() const {
+    return stableGeneration_;
+}
+
+uint32_t PeriodDetector::GetMaxPeriod() const {
+    return maxPeriod_;
+}
+
+void EnsemblePeriodTracker::Reset(size_t count, uint32_t maxPeriod) {
+    count_ = count;
+    maxPeriod_ = std::max(maxPeriod, 1u);
+
+    hashes_.assign(count * maxPeriod_, 0);
+    head_ = 0;
+    history_ = 0;
+
+    candidates_.assign(count * EnsembleEngine::UniverseSize, 0);
+    candidateGenerations_.assign(count, 0);
+    candidatePeriods_.assign(count, 0);
+
+    periods_.assign(count, 0);
+    stableGenerations_.assign(count, 0);
+    evolving_ = count;
+}
+
+size_t EnsemblePeriodTracker::Observe(const EnsembleEngine& engine) {
+    constexpr int size = EnsembleEngine::UniverseSize;
+    const uint64_t generation = engine.GetGeneration();
+
+    for (size_t u = 0; u < count_; u++) {
+        if (periods_[u]) {
+            continue;
+        }
+
+        const uint64_t hash = engine.GetStats(u).hash;
+        uint64_t* hashes = hashes_.data() + u * maxPeriod_;
+        BitGrid::Word* candidate = candidates_.data() + u * size;
+
+        if (candidatePeriods_[u] && generation == candidateGenerations_[u] + candidatePeriods_[u]) {
+            bool same = true;
+            for (int y = 0; y < size && same; y++) {
+                same = (candidate[y] == engine.GetRow(u, y));
+            }
+            if (same) {
+                periods_[u] = candidatePeriods_[u];
+                stableGenerations_[u] = candidateGenerations_[u];
+                evolving_--;
+                continue;
+            }
+            candidatePeriods_[u] = 0;
+        }
+
+        if (!candidatePeriods_[u]) {
+            for (uint32_t p = 1; p <= history_; p++) {
+                if (hashes[(head_ + maxPeriod_ - p) % maxPeriod_] == hash) {
+                    for (int y = 0; y < size; y++) {
+                        candidate[y] = engine.GetRow(u, y);
+                    }
+                    candidateGenerations_[u] = generation;
+                    candidatePeriods_[u] = p;
+                    break;
+                }
+            }
+        }
+
+        hashes[head_] = hash;
+    }
+
+    head_ = (head_ + 1) % maxPeriod_;
+    history_ = std::min<size_t>(history_ + 1, maxPeriod_);
+
+    return evolving_;
+}
+
+size_t EnsemblePeriodTracker::GetEvolvingCount() const {
+    return evolving_;
+}
+
+uint32_t EnsemblePeriodTracker::GetPeriod(size_t universe) const {
+    return periods_[universe];
+}
+
+uint64_t EnsemblePeriodTracker::GetStableGeneration(size_t universe) const {
+    return stableGenerations_[universe];
+}
+
+} // namespace CellularAutomata
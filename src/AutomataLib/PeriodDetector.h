@@ -0,0 +1,90 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    class LifeEngine;
+    class EnsembleEngine;
+
+    // Detects when the cells of a LifeEngine became static or periodic.
+    // Hashes of the recent generations are compared first, and a match is confirmed
+    // by comparing the cells one period later, so hash collisions are never reported.
+    class PeriodDetector {
+    public:
+        // Periods up to maxPeriod generations are detected, 1 means static cells only
+        explicit PeriodDetector(uint32_t maxPeriod = 1);
+
+        // Forget the history, needed whenever the cells were changed other than by stepping
+        void Reset(uint32_t maxPeriod);
+        void Reset();
+
+        // Called after every step, returns true once the period is confirmed
+        bool Observe(const LifeEngine& engine);
+
+        bool IsStable() const;
+
+        // Smallest period of the cells, 0 until stable
+        uint32_t GetPeriod() const;
+
+        // Generation since which the cells are known to repeat
+        uint64_t GetStableGeneration() const;
+
+        uint32_t GetMaxPeriod() const;
+
+    private:
+        uint32_t maxPeriod_{ 1 };
+
+        // Hashes of the last generations, the latest one is before the head
+        std::vector<uint64_t> hashes_;
+        size_t head_{ 0 };
+        size_t count_{ 0 };
+        uint64_t lastGeneration_{ 0 };
+
+        // Cells of a generation whose hash matched the one period earlier
+        BitGrid candidate_;
+        uint64_t candidateGeneration_{ 0 };
+        uint32_t candidatePeriod_{ 0 };
+
+        uint32_t period_{ 0 };
+        uint64_t stableGeneration_{ 0 };
+    };
+
+
+    // PeriodDetector for every universe of an EnsembleEngine. Universes whose period is confirmed
+    // are left alone, so a batch may stop as soon as none of them is evolving.
+    class EnsemblePeriodTracker {
+    public:
+        EnsemblePeriodTracker() = default;
+
+        // History of each universe is cleared
+        void Reset(size_t count, uint32_t maxPeriod);
+
+        // Called after every step of the ensemble, returns the number of universes still evolving
+        size_t Observe(const EnsembleEngine& engine);
+
+        size_t GetEvolvingCount() const;
+
+        // Smallest period of the universe, 0 while it's evolving. Empty universes have period 1.
+        uint32_t GetPeriod(size_t universe) const;
+
+        // Generation since which the cells of the universe are known to repeat
+        uint64_t GetStableGeneration(size_t universe) const;
+
+    private:
+        size_t count_{ 0 };
+        uint32_t maxPeriod_{ 1 };
+
+        // Universes step together, so they share the position in their rings of hashes
+        std::vector<uint64_t> hashes_; // [universe * maxPeriod_ + slot]
+        size_t head_{ 0 };
+        size_t history_{ 0 };
+
+        std::vector<BitGrid::Word> candidates_; // [universe * UniverseSize + y]
+        std::vector<uint64_t> candidateGenerations_;
+        std::vector<uint32_t> candidatePeriods_;
+
+        std::vector<uint32_t> periods_;
+        std::vector<uint64_t> stableGenerations_;
+        size_t evolving_{ 0 };
+    };
+
+}
@@ -0,0 +1,485 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "LifeKernel.h"
+#include "PlaneEngine.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::GenerationStats;
+using CellularAutomata::PlaneEngine;
+
+constexpr uint32_t NoChunk = std::numeric_limits<uint32_t>::max();
+
+// Empty chunks are kept for a few generations, so cells going back and forth don't reallocate them
+constexpr uint32_t ChunkIdleLimit = 16;
+
+// Fewer chunks are stepped faster than the threads are started
+constexpr size_t ParallelPlaneMinChunks = 256;
+
+constexpr size_t MinPlaneTableSize = 64;
+
+// Neighbour chunks in the order of the counts, dx and dy
+constexpr int PlaneNeighbours[8][2] = {
+    { -1, -1 }, { 0, -1 }, { 1, -1 },
+    { -1, 0 }, { 1, 0 },
+    { -1, 1 }, { 0, 1 }, { 1, 1 },
+};
+
+uint64_t HashChunkKey(uint64_t key) {
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    return key ^ (key >> 31);
+}
+
+
+namespace CellularAutomata {
+
+PlaneEngine::PlaneEngine() {
+    Clear();
+}
+
+void PlaneEngine::Clear() {
+    chunks_.clear();
+    freeChunks_.clear();
+    usedChunks_.clear();
+    slots_.assign(MinPlaneTableSize, Slot{ 0, NoChunk });
+    slotCount_ = 0;
+    generation_ = 0;
+    stats_ = GenerationStats();
+}
+
+void PlaneEngine::SetRules(const AutomatonRules& rules) {
+    if (rules.birth == rules_.birth && rules.survive == rules_.survive) {
+        rules_ = rules;
+        return;
+    }
+    rules_ = rules;
+
+    // Unchanged chunks are copied by the step, under new rules every chunk has to be stepped again
+    for (uint32_t chunk : usedChunks_) {
+        chunks_[chunk].changed = true;
+    }
+}
+
+const AutomatonRules& PlaneEngine::GetRules() const {
+    return rules_;
+}
+
+void PlaneEngine::Load(const BitGrid& grid, int64_t x, int64_t y, uint64_t generation) {
+    Clear();
+
+    const size_t words = grid.GetWordsPerRow();
+    for (int row = 0; row < grid.GetHeight(); row++) {
+        const BitGrid::Word* data = grid.GetRow(row);
+        for (size_t j = 0; j < words; j++) {
+            if (!data[j]) {
+                continue;
+            }
+            // A word of the grid covers one or two chunk words
+            const int64_t px = x + static_cast<int64_t>(j) * BitGrid::WordBits;
+            const int shift = static_cast<int>(px & (ChunkSize - 1));
+            GetChunk(px, y + row).cells[(y + row) & (ChunkSize - 1)] |= data[j] << shift;
+            if (shift && (data[j] >> (BitGrid::WordBits - shift))) {
+                GetChunk(px + ChunkSize, y + row).cells[(y + row) & (ChunkSize - 1)] |=
+                    data[j] >> (BitGrid::WordBits - shift);
+            }
+        }
+    }
+
+    generation_ = generation;
+    stats_ = GenerationStats();
+    for (uint32_t c : usedChunks_) {
+        for (int r = 0; r < ChunkSize; r++) {
+            stats_.population += std::bitset<BitGrid::WordBits>(chunks_[c].cells[r]).count();
+        }
+    }
+}
+
+void PlaneEngine::Store(int64_t x, int64_t y, BitGrid& grid) const {
+    grid.Clear();
+
+    const int64_t width = grid.GetWidth();
+    const int64_t height = grid.GetHeight();
+    for (uint32_t c : usedChunks_) {
+        const Chunk& chunk = chunks_[c];
+        const int64_t cx = static_cast<int64_t>(chunk.cx) * ChunkSize - x;
+        const int64_t cy = static_cast<int64_t>(chunk.cy) * ChunkSize - y;
+        if (cx >= width || cy >= height || cx + ChunkSize <= 0 || cy + ChunkSize <= 0) {
+            continue;
+        }
+        for (int r = 0; r < ChunkSize; r++) {
+            if (chunk.cells[r] && cy + r >= 0 && cy + r < height) {
+                grid.OrBits(cx, static_cast<int>(cy + r), chunk.cells[r], ChunkSize);
+            }
+        }
+    }
+}
+
+bool PlaneEngine::Get(int64_t x, int64_t y) const {
+    const uint32_t c = FindChunk(static_cast<int32_t>(x >> ChunkBits), static_cast<int32_t>(y >> ChunkBits));
+    if (c == NoChunk) {
+        return false;
+    }
+    return (chunks_[c].cells[y & (ChunkSize - 1)] >> (x & (ChunkSize - 1))) & 1;
+}
+
+void PlaneEngine::Set(int64_t x, int64_t y, bool alive) {
+    const BitGrid::Word bit = BitGrid::Word(1) << (x & (ChunkSize - 1));
+    if (alive) {
+        GetChunk(x, y).cells[y & (ChunkSize - 1)] |= bit;
+        return;
+    }
+
+    const uint32_t c = FindChunk(static_cast<int32_t>(x >> ChunkBits), static_cast<int32_t>(y >> ChunkBits));
+    if (c != NoChunk) {
+        chunks_[c].cells[y & (ChunkSize - 1)] &= ~bit;
+        chunks_[c].changed = true;
+    }
+}
+
+bool PlaneEngine::GetBounds(int64_t& x0, int64_t& y0, int64_t& x1, int64_t& y1) const {
+    bool found = false;
+    for (uint32_t c : usedChunks_) {
+        const Chunk& chunk = chunks_[c];
+        BitGrid::Word columns = 0;
+        int bottom = ChunkSize;
+        int top = -1;
+        for (int r = 0; r < ChunkSize; r++) {
+            if (chunk.cells[r]) {
+                columns |= chunk.cells[r];
+                bottom = std::min(bottom, r);
+                top = r;
+            }
+        }
+        if (!columns) {
+            continue;
+        }
+
+        int left = 0;
+        while (!((columns >> left) & 1)) {
+            left++;
+        }
+        int right = ChunkSize - 1;
+        while (!((columns >> right) & 1)) {
+            right--;
+        }
+
+        const int64_t cx = static_cast<int64_t>(chunk.cx) * ChunkSize;
+        const int64_t cy = static_cast<int64_t>(chunk.cy) * ChunkSize;
+        if (!found) {
+            x0 = cx + left;
+            y0 = cy + bottom;
+            x1 = cx + right + 1;
+            y1 = cy + top + 1;
+            found = true;
+        }
+        else {
+            x0 = std::min(x0, cx + left);
+            y0 = std::min(y0, cy + bottom);
+            x1 = std::max(x1, cx + right + 1);
+            y1 = std::max(y1, cy + top + 1);
+        }
+    }
+    return found;
+}
+
+void PlaneEngine::Step(unsigned threads) {
+    AddBorderChunks();
+
+    const size_t count = usedChunks_.size();
+    if (threads == 0) {
+        threads = (count >= ParallelPlaneMinChunks) ? GetWorkerCount() : 1;
+    }
+
+    std::vector<GenerationStats> partial(std::max(threads, 1u));
+    std::atomic<size_t> nextSlot{ 0 };
+    ParallelFor(count, [&](size_t begin, size_t end) {
+        GenerationStats stats;
+        for (size_t i = begin; i < end; i++) {
+            const GenerationStats s = StepChunk(usedChunks_[i]);
+            stats.population += s.population;
+            stats.births += s.births;
+            stats.deaths += s.deaths;
+            stats.hash += s.hash;
+        }
+        partial[nextSlot++] = stats;
+    }, threads);
+
+    stats_ = GenerationStats();
+    for (const auto& p : partial) {
+        stats_.population += p.population;
+        stats_.births += p.births;
+        stats_.deaths += p.deaths;
+        stats_.hash += p.hash;
+    }
+
+    // Neighbours read the cells and the flags while stepping, so they change only now
+    ParallelFor(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Chunk& chunk = chunks_[usedChunks_[i]];
+            chunk.changed = (chunk.cells != chunk.next);
+            chunk.cells = chunk.next;
+
+            bool empty = true;
+            for (BitGrid::Word w : chunk.cells) {
+                empty &= !w;
+            }
+            chunk.idle = empty ? chunk.idle + 1 : 0;
+        }
+    }, threads);
+
+    RemoveIdleChunks();
+    generation_++;
+}
+
+uint64_t PlaneEngine::GetGeneration() const {
+    return generation_;
+}
+
+const GenerationStats& PlaneEngine::GetStats() const {
+    return stats_;
+}
+
+size_t PlaneEngine::GetChunkCount() const {
+    return usedChunks_.size();
+}
+
+size_t PlaneEngine::GetMemoryUsage() const {
+    return chunks_.capacity() * sizeof(Chunk) + slots_.capacity() * sizeof(Slot) +
+        (freeChunks_.capacity() + usedChunks_.capacity()) * sizeof(uint32_t);
+}
+
+uint64_t PlaneEngine::MakeKey(int32_t cx, int32_t cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+uint32_t PlaneEngine::FindChunk(int32_t cx, int32_t cy) const {
+    const uint64_t key = MakeKey(cx, cy);
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = HashChunkKey(key) & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.chunk == NoChunk) {
+            return NoChunk;
+        }
+        if (slot.key == key) {
+            return slot.chunk;
+        }
+    }
+}
+
+uint32_t PlaneEngine::AddChunk(int32_t cx, int32_t cy) {
+    // At most half of the slots are taken, so probes stay short
+    if (2 * (slotCount_ + 1) > slots_.size()) {
+        ResizeTable(2 * slots_.size());
+    }
+
+    uint32_t c = 0;
+    if (!freeChunks_.empty()) {
+        c = freeChunks_.back();
+        freeChunks_.pop_back();
+    }
+    else {
+        c = static_cast<uint32_t>(chunks_.size());
+        chunks_.emplace_back();
+    }
+
+    Chunk& chunk = chunks_[c];
+    chunk.cells.fill(0);
+    chunk.next.fill(0);
+    chunk.cx = cx;
+    chunk.cy = cy;
+    chunk.listIndex = static_cast<uint32_t>(usedChunks_.size());
+    chunk.idle = 0;
+    chunk.changed = false;
+    usedChunks_.push_back(c);
+
+    const uint64_t key = MakeKey(cx, cy);
+    const size_t mask = slots_.size() - 1;
+    size_t i = HashChunkKey(key) & mask;
+    while (slots_[i].chunk != NoChunk) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = Slot{ key, c };
+    slotCount_++;
+
+    return c;
+}
+
+void PlaneEngine::RemoveChunk(uint32_t c) {
+    Chunk& chunk = chunks_[c];
+    const uint64_t key = MakeKey(chunk.cx, chunk.cy);
+    const size_t mask = slots_.size() - 1;
+    size_t i = HashChunkKey(key) & mask;
+    while (slots_[i].key != key || slots_[i].chunk == NoChunk) {
+        i = (i + 1) & mask;
+    }
+
+    // Backward shift deletion, later slots of the probe sequences move into the hole
+    for (size_t j = (i + 1) & mask; slots_[j].chunk != NoChunk; j = (j + 1) & mask) {
+        const size_t home = HashChunkKey(slots_[j].key) & mask;
+        // The slot may move if its home isn't within (i, j] cyclically
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+    slots_[i].chunk = NoChunk;
+    slotCount_--;
+
+    const uint32_t last = usedChunks_.back();
+    usedChunks_[chunk.listIndex] = last;
+    chunks_[last].listIndex = chunk.listIndex;
+    usedChunks_.pop_back();
+    freeChunks_.push_back(c);
+}
+
+void PlaneEngine::ResizeTable(size_t capacity) {
+    std::vector<Slot> slots(std::max(capacity, MinPlaneTableSize), Slot{ 0, NoChunk });
+    const size_t mask = slots.size() - 1;
+    for (const Slot& slot : slots_) {
+        if (slot.chunk == NoChunk) {
+            continue;
+        }
+        size_t i = HashChunkKey(slot.key) & mask;
+        while (slots[i].chunk != NoChunk) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+    slots_.swap(slots);
+}
+
+PlaneEngine::Chunk& PlaneEngine::GetChunk(int64_t x, int64_t y) {
+    const int32_t cx = static_cast<int32_t>(x >> ChunkBits);
+    const int32_t cy = static_cast<int32_t>(y >> ChunkBits);
+    uint32_t c = FindChunk(cx, cy);
+    if (c == NoChunk) {
+        c = AddChunk(cx, cy);
+    }
+    chunks_[c].changed = true;
+    chunks_[c].idle = 0;
+    return chunks_[c];
+}
+
+void PlaneEngine::AddBorderChunks() {
+    // Chunks added here are empty and have no borders, so the list may grow while it is walked
+    const size_t count = usedChunks_.size();
+    for (size_t i = 0; i < count; i++) {
+        const Chunk& chunk = chunks_[usedChunks_[i]];
+        BitGrid::Word columns = 0;
+        for (BitGrid::Word w : chunk.cells) {
+            columns |= w;
+        }
+        if (!columns) {
+            continue;
+        }
+
+        // Neighbours touching the cells, in the order of PlaneNeighbours
+        const BitGrid::Word bottom = chunk.cells[0];
+        const BitGrid::Word top = chunk.cells[ChunkSize - 1];
+        const BitGrid::Word lastBit = BitGrid::Word(1) << (ChunkSize - 1);
+        const bool touches[8] = {
+            (bottom & 1) != 0, bottom != 0, (bottom & lastBit) != 0,
+            (columns & 1) != 0, (columns & lastBit) != 0,
+            (top & 1) != 0, top != 0, (top & lastBit) != 0,
+        };
+
+        const int32_t cx = chunk.cx;
+        const int32_t cy = chunk.cy;
+        for (int n = 0; n < 8; n++) {
+            if (!touches[n]) {
+                continue;
+            }
+            uint32_t c = FindChunk(cx + PlaneNeighbours[n][0], cy + PlaneNeighbours[n][1]);
+            if (c == NoChunk) {
+                c = AddChunk(cx + PlaneNeighbours[n][0], cy + PlaneNeighbours[n][1]);
+            }
+            chunks_[c].idle = 0;
+        }
+    }
+}
+
+void PlaneEngine::RemoveIdleChunks() {
+    for (size_t i = usedChunks_.size(); i-- > 0;) {
+        if (chunks_[usedChunks_[i]].idle > ChunkIdleLimit) {
+            RemoveChunk(usedChunks_[i]);
+        }
+    }
+}
+
+GenerationStats PlaneEngine::StepChunk(uint32_t c) {
+    Chunk& chunk = chunks_[c];
+
+    const Chunk* neighbours[8];
+    bool changed = chunk.changed;
+    for (int n = 0; n < 8; n++) {
+        const uint32_t i = FindChunk(chunk.cx + PlaneNeighbours[n][0], chunk.cy + PlaneNeighbours[n][1]);
+        neighbours[n] = (i != NoChunk) ? &chunks_[i] : nullptr;
+        changed |= neighbours[n] && neighbours[n]->changed;
+    }
+
+    GenerationStats stats;
+
+    // Same neighbourhood as in the last step gives the same cells
+    if (!changed) {
+        chunk.next = chunk.cells;
+        for (int r = 0; r < ChunkSize; r++) {
+            if (chunk.cells[r]) {
+                stats.population += std::bitset<BitGrid::WordBits>(chunk.cells[r]).count();
+                stats.hash += HashCellWord(chunk.cells[r], MakeKey(chunk.cx, chunk.cy) * ChunkSize + r);
+            }
+        }
+        return stats;
+    }
+
+    // Rows -1..64 with the cells at x = -1 and x = 64 from the chunks on the sides
+    constexpr int Rows = ChunkSize + 2;
+    BitGrid::Word middle[Rows];
+    BitGrid::Word west[Rows];
+    BitGrid::Word east[Rows];
+
+    // Chunks west, at and east of the rows below, within and above the chunk
+    const Chunk* const sides[3][3] = {
+        { neighbours[0], neighbours[1], neighbours[2] },
+        { neighbours[3], &chunk, neighbours[4] },
+        { neighbours[5], neighbours[6], neighbours[7] },
+    };
+    auto row = [](const Chunk* chunk, int r) -> BitGrid::Word {
+        return chunk ? chunk->cells[r] : 0;
+    };
+    for (int r = 0; r < Rows; r++) {
+        const int side = (r == 0) ? 0 : (r == Rows - 1) ? 2 : 1;
+        const int sourceRow = (r == 0) ? ChunkSize - 1 : (r == Rows - 1) ? 0 : r - 1;
+
+        const BitGrid::Word cells = row(sides[side][1], sourceRow);
+        middle[r] = cells;
+        west[r] = (cells << 1) | (row(sides[side][0], sourceRow) >> (BitGrid::WordBits - 1));
+        east[r] = (cells >> 1) | (row(sides[side][2], sourceRow) << (BitGrid::WordBits - 1));
+    }
+
+    const uint64_t hashBase = MakeKey(chunk.cx, chunk.cy) * ChunkSize;
+    for (int r = 0; r < ChunkSize; r++) {
+        const BitGrid::Word n[8] = {
+            west[r], middle[r], east[r],
+            west[r + 1], east[r + 1],
+            west[r + 2], middle[r + 2], east[r + 2],
+        };
+        const NeighbourCount count = CountNeighbours(n);
+
+        const BitGrid::Word alive = middle[r + 1];
+        const BitGrid::Word cell = (alive & MatchCounts(rules_.survive, count)) |
+            (~alive & MatchCounts(rules_.birth, count));
+        chunk.next[r] = cell;
+
+        stats.population += std::bitset<BitGrid::WordBits>(cell).count();
+        stats.births += std::bitset<BitGrid::WordBits>(cell & ~alive).count();
+        stats.deaths += std::bitset<BitGrid::WordBits>(alive & ~cell).count();
+        if (cell) {
+            stats.hash += HashCellWord(cell, hashBase + r);
+        }
+    }
+    return stats;
+}
+
+} // namespace CellularAutomata
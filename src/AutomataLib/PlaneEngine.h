@@ -0,0 +1,91 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Life-like automaton on the unbounded plane stepped on the CPU. Cells are kept in 64x64 chunks
+    // of one word per row, found by their chunk coordinates in an open-addressing hash map.
+    // Chunks are added next to the cells on their borders before each step and freed after
+    // staying empty for a while, so memory follows the live area rather than the extent of the pattern.
+    // Chunks whose neighbourhood didn't change in the last step are copied instead of stepped.
+    // Rules with birth on 0 neighbours would fill the plane, cells outside of the chunks stay dead.
+    class PlaneEngine {
+    public:
+        static constexpr int ChunkBits = 6;
+        static constexpr int ChunkSize = 1 << ChunkBits;
+
+    public:
+        PlaneEngine();
+
+        void Clear();
+
+        void SetRules(const AutomatonRules& rules);
+        const AutomatonRules& GetRules() const;
+
+        // Cells of the plane are replaced by the grid with its cell (0, 0) at (x, y)
+        void Load(const BitGrid& grid, int64_t x, int64_t y, uint64_t generation);
+
+        // Cells of the window of the grid size with its cell (0, 0) at (x, y)
+        void Store(int64_t x, int64_t y, BitGrid& grid) const;
+
+        bool Get(int64_t x, int64_t y) const;
+        void Set(int64_t x, int64_t y, bool alive);
+
+        // Box of the alive cells, past the last cells. False if the plane is empty.
+        bool GetBounds(int64_t& x0, int64_t& y0, int64_t& x1, int64_t& y1) const;
+
+        // Zero threads selects the count automatically
+        void Step(unsigned threads = 0);
+
+        uint64_t GetGeneration() const;
+        const GenerationStats& GetStats() const;
+
+        size_t GetChunkCount() const;
+        size_t GetMemoryUsage() const;
+
+    private:
+        using Row = std::array<BitGrid::Word, ChunkSize>;
+
+        struct Chunk {
+            Row cells;
+            Row next;
+            int32_t cx;
+            int32_t cy;
+            uint32_t listIndex; // In the list of used chunks
+            uint32_t idle;      // Generations since the chunk had cells or cells next to it
+            bool changed;       // Cells differ from the previous generation
+        };
+
+        struct Slot {
+            uint64_t key;
+            uint32_t chunk;
+        };
+
+        static uint64_t MakeKey(int32_t cx, int32_t cy);
+
+        uint32_t FindChunk(int32_t cx, int32_t cy) const;
+        uint32_t AddChunk(int32_t cx, int32_t cy);
+        void RemoveChunk(uint32_t chunk);
+        void ResizeTable(size_t capacity);
+
+        // Chunk with the cell, added if missing
+        Chunk& GetChunk(int64_t x, int64_t y);
+
+        // Neighbours of the chunks with cells on the borders
+        void AddBorderChunks();
+        void RemoveIdleChunks();
+
+        GenerationStats StepChunk(uint32_t chunk);
+
+    private:
+        std::vector<Chunk> chunks_;
+        std::vector<uint32_t> freeChunks_;
+        std::vector<uint32_t> usedChunks_;
+        std::vector<Slot> slots_;
+        size_t slotCount_{ 0 };
+
+        AutomatonRules rules_{ 0, 8, 12 }; // B3/S23
+        uint64_t generation_{ 0 };
+        GenerationStats stats_;
+    };
+
+}
@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "RandomGenerator.h"
+
+constexpr uint32_t PhiloxM = 0xD256D193;
+constexpr uint32_t PhiloxW = 0x9E3779B9;
+constexpr int PhiloxRounds = 10;
+
+// Rings per unit of the shorter side of the grid
+constexpr uint32_t RadialScale = 100;
+
+// Second counter word of the radial pattern, never equal to a row index
+constexpr uint32_t RadialStream = 0xFFFFFFFF;
+
+uint32_t IntegerSqrt(uint32_t n) {
+    uint32_t r = static_cast<uint32_t>(std::sqrt(static_cast<float>(n)));
+    while (r * r > n) {
+        r--;
+    }
+    while ((r + 1) * (r + 1) <= n) {
+        r++;
+    }
+    return r;
+}
+
+
+namespace CellularAutomata {
+
+std::array<uint32_t, 2> Philox2x32(uint32_t ctr0, uint32_t ctr1, uint32_t key) {
+    for (int i = 0; i < PhiloxRounds; i++) {
+        if (i > 0) {
+            key += PhiloxW;
+        }
+        uint64_t product = static_cast<uint64_t>(PhiloxM) * ctr0;
+        uint32_t hi = static_cast<uint32_t>(product >> 32);
+        uint32_t lo = static_cast<uint32_t>(product);
+
+        ctr0 = hi ^ key ^ ctr1;
+        ctr1 = lo;
+    }
+    return { ctr0, ctr1 };
+}
+
+uint32_t GetDensityThreshold(float density) {
+    double threshold = std::clamp(static_cast<double>(density), 0.0, 1.0) * 4294967296.0;
+    return static_cast<uint32_t>(std::min(threshold, 4294967295.0));
+}
+
+uint32_t GetRadialRing(int x, int y, int width, int height) {
+    // Integer arithmetic only, so that the rings don't depend on float rounding
+    uint32_t dx = static_cast<uint32_t>(std::abs(x - width / 2));
+    uint32_t dy = static_cast<uint32_t>(std::abs(y - height / 2));
+    uint32_t size = static_cast<uint32_t>(std::min(width, height));
+    return IntegerSqrt(dx * dx + dy * dy) * RadialScale / size;
+}
+
+void GenerateFirstGeneration(BitGrid& grid, const FirstGenerationParams& params, unsigned threads) {
+    grid.Clear();
+    if (params.type != FirstGenerationType::UniformRandom &&
+        params.type != FirstGenerationType::RadialRandom) {
+        return;
+    }
+
+    const int width = grid.GetWidth();
+    const int height = grid.GetHeight();
+    const uint32_t threshold = GetDensityThreshold(params.density);
+
+    // Every ring has a single state, evaluate them once
+    std::vector<uint8_t> rings;
+    if (params.type == FirstGenerationType::RadialRandom) {
+        uint32_t ringCount = GetRadialRing(0, 0, width, height) + 1;
+        rings.resize(ringCount);
+        for (uint32_t i = 0; i < ringCount; i++) {
+            rings[i] = (Philox2x32(i, RadialStream, params.seed)[0] < threshold) ? 1 : 0;
+        }
+    }
+
+    ParallelFor(static_cast<size_t>(height), [&](size_t begin, size_t end) {
+        for (int y = static_cast<int>(begin); y < static_cast<int>(end); y++) {
+            BitGrid::Word* row = grid.GetRow(y);
+            for (int x = 0; x < width; x++) {
+                bool alive = false;
+                if (params.type == FirstGenerationType::UniformRandom) {
+                    alive = Philox2x32(static_cast<uint32_t>(x), static_cast<uint32_t>(y), params.seed)[0] < threshold;
+                }
+                else {
+                    alive = rings[GetRadialRing(x, y, width, height)] != 0;
+                }
+                if (alive) {
+                    row[x / BitGrid::WordBits] |= BitGrid::Word(1) << (x % BitGrid::WordBits);
+                }
+            }
+        }
+    }, threads);
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Philox2x32-10 counter-based generator from "Parallel Random Numbers: As Easy as 1, 2, 3"
+    // (Salmon et al., 2011). life-init.frag implements the same function with 32-bit arithmetic,
+    // so the first generation is identical on CPU and GPU for the same seed.
+    std::array<uint32_t, 2> Philox2x32(uint32_t ctr0, uint32_t ctr1, uint32_t key);
+
+    // Cells are alive when the first output word of Philox is below the threshold
+    uint32_t GetDensityThreshold(float density);
+
+    // Ring of the radial pattern that contains the cell
+    uint32_t GetRadialRing(int x, int y, int width, int height);
+
+    // Same cells as rendered by life-init.frag, rows are generated on worker threads
+    void GenerateFirstGeneration(BitGrid& grid, const FirstGenerationParams& params, unsigned threads = 0);
+
+}
@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "Rules.h"
+
+constexpr int MaxNeighbours = 8;
+
+bool ParseNeighbourCounts(const std::string& str, int& mask) {
+    mask = 0;
+    for (char c : str) {
+        if (c < '0' || c > '0' + MaxNeighbours) {
+            return false;
+        }
+        mask |= 1 << (c - '0');
+    }
+    return true;
+}
+
+
+namespace CellularAutomata {
+
+bool ParseRuleString(const std::string& str, AutomatonRules& rules) {
+    auto slash = str.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+
+    std::string first = str.substr(0, slash);
+    std::string second = str.substr(slash + 1);
+
+    // Drop suffixes of extended notations, e.g. the topology in "B3/S23:T64,64"
+    auto suffix = second.find_first_of(":/");
+    if (suffix != std::string::npos) {
+        second.resize(suffix);
+    }
+
+    auto isTag = [](const std::string& s, char tag) {
+        return !s.empty() && std::tolower(static_cast<unsigned char>(s[0])) == tag;
+    };
+
+    std::string birth, survive;
+    if (isTag(first, 'b') && isTag(second, 's')) {
+        birth = first.substr(1);
+        survive = second.substr(1);
+    }
+    else if (isTag(first, 's') && isTag(second, 'b')) {
+        survive = first.substr(1);
+        birth = second.substr(1);
+    }
+    else {
+        // S/B notation without letters
+        survive = first;
+        birth = second;
+    }
+
+    AutomatonRules parsed{ 0, 0, 0 };
+    if (!ParseNeighbourCounts(birth, parsed.birth) ||
+        !ParseNeighbourCounts(survive, parsed.survive)) {
+        return false;
+    }
+
+    rules = parsed;
+    return true;
+}
+
+std::string FormatRuleString(const AutomatonRules& rules) {
+    std::string str = "B";
+    for (int i = 0; i <= MaxNeighbours; i++) {
+        if (rules.birth & (1 << i)) {
+            str += static_cast<char>('0' + i);
+        }
+    }
+    str += "/S";
+    for (int i = 0; i <= MaxNeighbours; i++) {
+        if (rules.survive & (1 << i)) {
+            str += static_cast<char>('0' + i);
+        }
+    }
+    return str;
+}
+
+} // namespace CellularAutomata
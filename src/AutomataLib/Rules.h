@@ -0,0 +1,12 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Parse birth and survival conditions in B/S notation ("B3/S23") or S/B notation ("23/3").
+    // Id of the rules is set to zero.
+    bool ParseRuleString(const std::string& str, AutomatonRules& rules);
+
+    // Rules in B/S notation
+    std::string FormatRuleString(const AutomatonRules& rules);
+
+}
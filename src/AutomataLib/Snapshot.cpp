@@ -0,0 +1,198 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "ByteOrder.h"
+#include "MappedFile.h"
+#include "ZeroRuns.h"
+#include "Snapshot.h"
+
+constexpr char SnapshotMagic[4] = { 'G', 'O', 'L', 'S' };
+constexpr uint32_t SnapshotVersion = 1;
+
+// Fields are little endian, see ByteOrder.h
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t compression;
+    uint32_t width;
+    uint32_t height;
+    int32_t ruleId;
+    int32_t ruleBirth;
+    int32_t ruleSurvive;
+    uint64_t generation;
+    uint32_t seed;
+    uint32_t reserved;
+    uint64_t payloadSize;
+    uint64_t checksum; // Of the header with zero checksum and the payload
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "Snapshot header must have no padding");
+
+
+namespace CellularAutomata {
+
+uint64_t Checksum64(const void* data, size_t size, uint64_t hash) {
+    constexpr uint64_t Prime = 0x100000001b3ull;
+
+    const char* bytes = static_cast<const char*>(data);
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, std::min(sizeof(word), size - i));
+        hash = (hash ^ word) * Prime;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+std::vector<char> EncodeSnapshot(const SnapshotState& state, SnapshotCompression compression) {
+    const BitGrid& grid = state.grid;
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+    header.version = SnapshotVersion;
+    header.width = static_cast<uint32_t>(grid.GetWidth());
+    header.height = static_cast<uint32_t>(grid.GetHeight());
+    header.ruleId = state.rules.id;
+    header.ruleBirth = state.rules.birth;
+    header.ruleSurvive = state.rules.survive;
+    header.generation = state.generation;
+    header.seed = state.seed;
+
+    const size_t rawSize = grid.GetDataSize() * sizeof(BitGrid::Word);
+
+    std::vector<char> out(sizeof(SnapshotHeader));
+    out.reserve(sizeof(SnapshotHeader) + rawSize);
+
+    if (compression == SnapshotCompression::ZeroRuns) {
+        EncodeZeroRuns(grid.GetData(), grid.GetDataSize(), out);
+        if (out.size() - sizeof(SnapshotHeader) >= rawSize) {
+            out.resize(sizeof(SnapshotHeader));
+            compression = SnapshotCompression::None;
+        }
+    }
+    if (compression == SnapshotCompression::None) {
+        const char* raw = reinterpret_cast<const char*>(grid.GetData());
+        out.insert(out.end(), raw, raw + rawSize);
+    }
+
+    header.compression = static_cast<uint32_t>(compression);
+    header.payloadSize = out.size() - sizeof(SnapshotHeader);
+    header.checksum = Checksum64(out.data() + sizeof(SnapshotHeader), header.payloadSize,
+        Checksum64(&header, sizeof(header)));
+
+    std::memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+bool DecodeSnapshot(const char* data, size_t size, SnapshotState& state) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        LOGE << "Snapshot is truncated";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) != 0) {
+        LOGE << "Not a snapshot file";
+        return false;
+    }
+    if (header.version != SnapshotVersion) {
+        LOGE << "Unsupported snapshot version " << header.version;
+        return false;
+    }
+    if (header.payloadSize != size - sizeof(header)) {
+        LOGE << "Snapshot is truncated";
+        return false;
+    }
+
+    const uint64_t checksum = header.checksum;
+    header.checksum = 0;
+    const char* payload = data + sizeof(header);
+    if (Checksum64(payload, header.payloadSize, Checksum64(&header, sizeof(header))) != checksum) {
+        LOGE << "Snapshot checksum mismatch";
+        return false;
+    }
+
+    if (header.width == 0 || header.height == 0 ||
+            header.width > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+            header.height > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+        LOGE << "Snapshot has invalid size " << header.width << "x" << header.height;
+        return false;
+    }
+
+    // The grid is allocated only for a payload that can hold it
+    const uint64_t gridWords = (static_cast<uint64_t>(header.width) + BitGrid::WordBits - 1) / BitGrid::WordBits *
+        header.height;
+    const auto compression = static_cast<SnapshotCompression>(header.compression);
+    if (compression != SnapshotCompression::None && compression != SnapshotCompression::ZeroRuns) {
+        LOGE << "Unsupported snapshot compression " << header.compression;
+        return false;
+    }
+    if ((compression == SnapshotCompression::None && header.payloadSize != gridWords * sizeof(BitGrid::Word)) ||
+            (compression == SnapshotCompression::ZeroRuns && header.payloadSize < GetZeroRunsMinSize(gridWords))) {
+        LOGE << "Snapshot grid size mismatch";
+        return false;
+    }
+
+    try {
+        state.grid.Resize(static_cast<int>(header.width), static_cast<int>(header.height));
+    }
+    catch (const std::exception& e) {
+        LOGE << "Unable to allocate the " << header.width << "x" << header.height << " snapshot grid: " << e.what();
+        return false;
+    }
+    state.rules = AutomatonRules{ header.ruleId, header.ruleBirth, header.ruleSurvive };
+    state.generation = header.generation;
+    state.seed = header.seed;
+
+    BitGrid::Word* words = state.grid.GetData();
+    const size_t count = state.grid.GetDataSize();
+
+    switch (compression) {
+    case SnapshotCompression::None:
+        std::memcpy(words, payload, header.payloadSize);
+        return true;
+
+    case SnapshotCompression::ZeroRuns:
+        if (!DecodeZeroRuns(payload, header.payloadSize, words, count)) {
+            LOGE << "Snapshot grid is malformed";
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool SaveSnapshot(const std::filesystem::path& path, const SnapshotState& state, SnapshotCompression compression) {
+    std::vector<char> data = EncodeSnapshot(state, compression);
+
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), data.size())) {
+            LOGE << "Unable to write snapshot " << tmpPath.string();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        LOGE << "Unable to replace snapshot " << path.string() << " : " << ec.message();
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LoadSnapshot(const std::filesystem::path& path, SnapshotState& state) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    return DecodeSnapshot(file.GetData(), file.GetSize(), state);
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    enum class SnapshotCompression : uint32_t {
+        None = 0,     // Grid words as is
+        ZeroRuns = 1, // Runs of empty words are collapsed, literal words are kept as is
+    };
+
+    // Full state of a run, enough to continue it after a restart
+    struct SnapshotState {
+        BitGrid grid;
+        AutomatonRules rules{ 0, 0, 0 };
+        uint64_t generation{ 0 };
+        uint32_t seed{ 0 }; // Seed of the first generation
+    };
+
+    // File is a fixed header followed by the grid words, both are covered by the checksum.
+    // Compression falls back to None when it doesn't make the payload smaller.
+    // The file is assembled in memory, written at once and renamed over the old one,
+    // so an interrupted save never damages the previous snapshot.
+    bool SaveSnapshot(const std::filesystem::path& path, const SnapshotState& state,
+        SnapshotCompression compression = SnapshotCompression::ZeroRuns);
+
+    // The file is memory mapped and decoded straight into the grid
+    bool LoadSnapshot(const std::filesystem::path& path, SnapshotState& state);
+
+    // Same for the snapshot in memory
+    std::vector<char> EncodeSnapshot(const SnapshotState& state, SnapshotCompression compression);
+    bool DecodeSnapshot(const char* data, size_t size, SnapshotState& state);
+
+    // Checksum of 64-bit words, little endian, the tail is zero padded
+    uint64_t Checksum64(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+}
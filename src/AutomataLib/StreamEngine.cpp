@@ -0,0 +1,521 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "ByteOrder.h"
+#include "Parallel.h"
+#include "RandomGenerator.h"
+#include "LifeKernel.h"
+#include "StreamEngine.h"
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::GenerationStats;
+
+constexpr char StreamMagic[4] = { 'G', 'O', 'L', 'B' };
+constexpr uint32_t StreamVersion = 1;
+
+// Rows start at a multiple of the mapping alignment of every platform, so bands of whole
+// rows are mapped without touching the header
+constexpr uint64_t StreamDataOffset = 64 * 1024;
+
+// Fields are little endian, see ByteOrder.h
+struct StreamHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    int32_t ruleId;
+    int32_t ruleBirth;
+    int32_t ruleSurvive;
+    uint32_t incomplete; // Set while a step rewrites the rows
+    uint64_t generation;
+    uint64_t dataOffset;
+    uint64_t rowBytes;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(StreamHeader) == 64, "Stream header must have no padding");
+
+size_t GetStreamRowWords(int width) {
+    return (static_cast<size_t>(width) + BitGrid::WordBits - 1) / BitGrid::WordBits;
+}
+
+#ifdef _WIN32
+
+size_t GetMapAlignment() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
+// No read ahead hint for views, the first touch of each page reads it
+void PrefetchMapping(void* /*data*/, size_t /*size*/) {
+}
+
+// Bytes transferred by the process, including other files
+void ReadStorageCounters(uint64_t& read, uint64_t& written) {
+    IO_COUNTERS counters{};
+    if (GetProcessIoCounters(GetCurrentProcess(), &counters)) {
+        read = counters.ReadTransferCount;
+        written = counters.WriteTransferCount;
+    }
+}
+
+#else
+
+size_t GetMapAlignment() {
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Ask the OS to read the band while the previous one is stepped
+void PrefetchMapping(void* data, size_t size) {
+    madvise(data, size, MADV_WILLNEED);
+    madvise(data, size, MADV_SEQUENTIAL);
+}
+
+// Bytes the process caused to be fetched from and sent to the storage, page cache hits are excluded
+void ReadStorageCounters(uint64_t& read, uint64_t& written) {
+#ifdef __linux__
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    while (io >> key >> value) {
+        if (key == "read_bytes:") {
+            read = value;
+        }
+        else if (key == "write_bytes:") {
+            written = value;
+        }
+    }
+#else
+    read = 0;
+    written = 0;
+#endif
+}
+
+#endif
+
+
+namespace CellularAutomata {
+
+StreamEngine::~StreamEngine() {
+    Close();
+}
+
+bool StreamEngine::Create(const std::filesystem::path& path, int width, int height, const AutomatonRules& rules,
+        const FirstGenerationParams& params, unsigned threads) {
+    if (width <= 0 || height <= 0) {
+        LOGE << "Invalid stream grid size " << width << "x" << height;
+        return false;
+    }
+    if (params.type != FirstGenerationType::Empty && params.type != FirstGenerationType::UniformRandom) {
+        LOGE << "Stream grids start empty or uniform random";
+        return false;
+    }
+
+    const size_t words = GetStreamRowWords(width);
+    const uint64_t rowBytes = words * sizeof(BitGrid::Word);
+
+    StreamHeader header{};
+    std::memcpy(header.magic, StreamMagic, sizeof(header.magic));
+    header.version = StreamVersion;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.ruleId = rules.id;
+    header.ruleBirth = rules.birth;
+    header.ruleSurvive = rules.survive;
+    header.dataOffset = StreamDataOffset;
+    header.rowBytes = rowBytes;
+
+    // Written next to the target and renamed when complete, so an interrupted run leaves no partial file
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        LOGE << "Unable to create " << tempPath.string();
+        return false;
+    }
+
+    std::vector<char> headerBlock(StreamDataOffset, 0);
+    std::memcpy(headerBlock.data(), &header, sizeof(header));
+    out.write(headerBlock.data(), headerBlock.size());
+
+    if (params.type == FirstGenerationType::UniformRandom) {
+        const uint32_t threshold = GetDensityThreshold(params.density);
+        const size_t bandRows = std::max<size_t>(DefaultBandBytes / rowBytes, 1);
+        std::vector<BitGrid::Word> band(bandRows * words);
+
+        for (size_t y0 = 0; y0 < static_cast<size_t>(height) && out; y0 += bandRows) {
+            const size_t rows = std::min(bandRows, static_cast<size_t>(height) - y0);
+            std::fill(band.begin(), band.end(), 0);
+
+            ParallelFor(rows, [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; r++) {
+                    const uint32_t y = static_cast<uint32_t>(y0 + r);
+                    BitGrid::Word* row = band.data() + r * words;
+                    for (int x = 0; x < width; x++) {
+                        if (Philox2x32(static_cast<uint32_t>(x), y, params.seed)[0] < threshold) {
+                            row[x / BitGrid::WordBits] |= BitGrid::Word(1) << (x % BitGrid::WordBits);
+                        }
+                    }
+                }
+            }, threads);
+
+            out.write(reinterpret_cast<const char*>(band.data()), static_cast<std::streamsize>(rows * rowBytes));
+        }
+    }
+
+    out.close();
+    if (!out) {
+        LOGE << "Failed to write " << tempPath.string();
+        return false;
+    }
+
+    // Rows of an empty grid are never written
+    std::error_code ec;
+    std::filesystem::resize_file(tempPath, StreamDataOffset + rowBytes * static_cast<uint64_t>(height), ec);
+    if (!ec) {
+        std::filesystem::rename(tempPath, path, ec);
+    }
+    if (ec) {
+        LOGE << "Unable to complete " << path.string() << " : " << ec.message();
+        return false;
+    }
+
+    return true;
+}
+
+bool StreamEngine::Open(const std::filesystem::path& path, size_t bandBytes) {
+    Close();
+
+    if (!OpenFile(path)) {
+        return false;
+    }
+
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec || fileSize < StreamDataOffset || !MapRange(0, sizeof(StreamHeader), header_)) {
+        LOGE << "File " << path.string() << " is too short for a stream grid";
+        Close();
+        return false;
+    }
+
+    const auto* header = static_cast<const StreamHeader*>(header_.base);
+    if (std::memcmp(header->magic, StreamMagic, sizeof(header->magic)) != 0 || header->version != StreamVersion) {
+        LOGE << "File " << path.string() << " is not a stream grid of version " << StreamVersion;
+        Close();
+        return false;
+    }
+    if (header->incomplete) {
+        LOGE << "Step of generation " << header->generation << " of " << path.string() << " was interrupted";
+        Close();
+        return false;
+    }
+
+    const int width = static_cast<int>(header->width);
+    const int height = static_cast<int>(header->height);
+    const size_t words = GetStreamRowWords(width);
+    if (width <= 0 || height <= 0 || header->dataOffset != StreamDataOffset ||
+            header->rowBytes != words * sizeof(BitGrid::Word) ||
+            fileSize < StreamDataOffset + header->rowBytes * static_cast<uint64_t>(height)) {
+        LOGE << "Stream grid " << path.string() << " is damaged";
+        Close();
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    wordsPerRow_ = words;
+    bandRows_ = std::clamp<size_t>(bandBytes / header->rowBytes, 1, static_cast<size_t>(height));
+    rules_ = AutomatonRules{ header->ruleId, header->ruleBirth, header->ruleSurvive };
+    generation_ = header->generation;
+    stats_ = GenerationStats();
+    ioStats_ = IoStats();
+
+    firstRow_.assign(words, 0);
+    carryRow_.assign(words, 0);
+    band_.assign(bandRows_ * words, 0);
+
+    return true;
+}
+
+void StreamEngine::SetRules(const AutomatonRules& rules) {
+    rules_ = rules;
+
+    if (header_.base) {
+        auto* header = static_cast<StreamHeader*>(header_.base);
+        header->ruleId = rules.id;
+        header->ruleBirth = rules.birth;
+        header->ruleSurvive = rules.survive;
+    }
+}
+
+const AutomatonRules& StreamEngine::GetRules() const {
+    return rules_;
+}
+
+bool StreamEngine::MapRows(size_t y, size_t count, Mapping& mapping) {
+    const uint64_t rowBytes = wordsPerRow_ * sizeof(BitGrid::Word);
+    return MapRange(StreamDataOffset + rowBytes * y, static_cast<size_t>(rowBytes * count), mapping);
+}
+
+bool StreamEngine::CopyRow(size_t y, BitGrid::Word* dst) {
+    Mapping row;
+    if (!MapRows(y, 1, row)) {
+        return false;
+    }
+    std::memcpy(dst, row.rows, wordsPerRow_ * sizeof(BitGrid::Word));
+    Unmap(row);
+    return true;
+}
+
+#ifdef _WIN32
+
+bool StreamEngine::OpenFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOGE << "Unable to open file " << path.string();
+        return false;
+    }
+    file_ = file;
+
+    mapping_ = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (!mapping_) {
+        LOGE << "Unable to map file " << path.string();
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void StreamEngine::Close() {
+    Unmap(header_);
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+
+    mapping_ = nullptr;
+    file_ = nullptr;
+    width_ = 0;
+    height_ = 0;
+}
+
+bool StreamEngine::MapRange(uint64_t offset, size_t size, Mapping& mapping) {
+    const uint64_t base = offset - offset % GetMapAlignment();
+    mapping.size = static_cast<size_t>(offset - base) + size;
+    mapping.base = MapViewOfFile(mapping_, FILE_MAP_WRITE, static_cast<DWORD>(base >> 32),
+        static_cast<DWORD>(base), mapping.size);
+    if (!mapping.base) {
+        LOGE << "Unable to map " << size << " bytes of the stream grid at " << offset;
+        mapping = Mapping();
+        return false;
+    }
+
+    mapping.rows = reinterpret_cast<BitGrid::Word*>(static_cast<char*>(mapping.base) + (offset - base));
+    return true;
+}
+
+void StreamEngine::Unmap(Mapping& mapping) {
+    if (mapping.base) {
+        // Writes back asynchronously
+        FlushViewOfFile(mapping.base, mapping.size);
+        UnmapViewOfFile(mapping.base);
+    }
+    mapping = Mapping();
+}
+
+#else
+
+bool StreamEngine::OpenFile(const std::filesystem::path& path) {
+    fd_ = open(path.c_str(), O_RDWR);
+    if (fd_ < 0) {
+        LOGE << "Unable to open file " << path.string();
+        return false;
+    }
+    return true;
+}
+
+void StreamEngine::Close() {
+    Unmap(header_);
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+
+    fd_ = -1;
+    width_ = 0;
+    height_ = 0;
+}
+
+bool StreamEngine::MapRange(uint64_t offset, size_t size, Mapping& mapping) {
+    const uint64_t base = offset - offset % GetMapAlignment();
+    mapping.size = static_cast<size_t>(offset - base) + size;
+    mapping.base = mmap(nullptr, mapping.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, static_cast<off_t>(base));
+    if (mapping.base == MAP_FAILED) {
+        LOGE << "Unable to map " << size << " bytes of the stream grid at " << offset;
+        mapping = Mapping();
+        return false;
+    }
+
+    mapping.rows = reinterpret_cast<BitGrid::Word*>(static_cast<char*>(mapping.base) + (offset - base));
+    return true;
+}
+
+void StreamEngine::Unmap(Mapping& mapping) {
+    if (mapping.base) {
+        // Dirty pages are written back by the OS, the step doesn't wait for them
+        msync(mapping.base, mapping.size, MS_ASYNC);
+        munmap(mapping.base, mapping.size);
+    }
+    mapping = Mapping();
+}
+
+#endif
+
+bool StreamEngine::Step(unsigned threads) {
+    if (!header_.base) {
+        return false;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    IoStats io;
+    uint64_t storageRead = 0, storageWritten = 0;
+    ReadStorageCounters(storageRead, storageWritten);
+
+    const size_t height = static_cast<size_t>(height_);
+    const size_t words = wordsPerRow_;
+    const size_t rowBytes = words * sizeof(BitGrid::Word);
+    const size_t bands = (height + bandRows_ - 1) / bandRows_;
+
+    auto* header = static_cast<StreamHeader*>(header_.base);
+    header->incomplete = 1;
+
+    // Neighbours across the top and bottom edges of the torus, taken before the first band is written
+    if (!CopyRow(0, firstRow_.data()) || !CopyRow(height - 1, carryRow_.data())) {
+        return false;
+    }
+    io.bytesRead += 2 * rowBytes;
+
+    if (threads == 0) {
+        threads = GetWorkerCount();
+    }
+    std::vector<GenerationStats> partial(std::max(threads, 1u));
+    GenerationStats stats;
+
+    // Window of the band written back, the band being stepped and the band read ahead
+    Mapping previous, current, next;
+    bool mapped = MapRows(0, std::min(bandRows_, height), current);
+    if (mapped) {
+        PrefetchMapping(current.base, current.size);
+    }
+
+    for (size_t b = 0; b < bands && mapped; b++) {
+        const size_t y0 = b * bandRows_;
+        const size_t rows = std::min(bandRows_, height - y0);
+
+        if (b + 1 < bands) {
+            const size_t y1 = y0 + rows;
+            if (!MapRows(y1, std::min(bandRows_, height - y1), next)) {
+                mapped = false;
+                break;
+            }
+            PrefetchMapping(next.base, next.size);
+        }
+
+        const BitGrid::Word* band = current.rows;
+        const BitGrid::Word* aboveBand = (b + 1 < bands) ? next.rows : firstRow_.data();
+
+        std::fill(partial.begin(), partial.end(), GenerationStats());
+        std::atomic<size_t> nextSlot{ 0 };
+        ParallelFor(rows, [&](size_t begin, size_t end) {
+            GenerationStats& s = partial[nextSlot++];
+            for (size_t r = begin; r < end; r++) {
+                const BitGrid::Word* below = (r == 0) ? carryRow_.data() : band + (r - 1) * words;
+                const BitGrid::Word* above = (r + 1 == rows) ? aboveBand : band + (r + 1) * words;
+                StepRow(below, band + r * words, above, band_.data() + r * words, words, width_, rules_,
+                    (y0 + r) * words, s);
+            }
+        }, threads);
+
+        for (const auto& p : partial) {
+            stats.population += p.population;
+            stats.births += p.births;
+            stats.deaths += p.deaths;
+            stats.hash += p.hash;
+        }
+
+        // The next band sees the old cells of this one
+        std::memcpy(carryRow_.data(), band + (rows - 1) * words, rowBytes);
+        std::memcpy(current.rows, band_.data(), rows * rowBytes);
+        io.bytesRead += rows * rowBytes;
+        io.bytesWritten += rows * rowBytes;
+
+        Unmap(previous);
+        previous = current;
+        current = next;
+        next = Mapping();
+    }
+
+    Unmap(previous);
+    Unmap(current);
+    Unmap(next);
+
+    if (!mapped) {
+        LOGE << "Step of generation " << generation_ << " is incomplete";
+        return false;
+    }
+
+    generation_++;
+    header->generation = generation_;
+    header->incomplete = 0;
+    stats_ = stats;
+
+    uint64_t storageReadAfter = 0, storageWrittenAfter = 0;
+    ReadStorageCounters(storageReadAfter, storageWrittenAfter);
+    io.storageRead = storageReadAfter - storageRead;
+    io.storageWritten = storageWrittenAfter - storageWritten;
+    io.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    ioStats_ = io;
+
+    return true;
+}
+
+int StreamEngine::GetWidth() const {
+    return width_;
+}
+
+int StreamEngine::GetHeight() const {
+    return height_;
+}
+
+size_t StreamEngine::GetBandRows() const {
+    return bandRows_;
+}
+
+uint64_t StreamEngine::GetGeneration() const {
+    return generation_;
+}
+
+const GenerationStats& StreamEngine::GetStats() const {
+    return stats_;
+}
+
+const StreamEngine::IoStats& StreamEngine::GetIoStats() const {
+    return ioStats_;
+}
+
+} // namespace CellularAutomata
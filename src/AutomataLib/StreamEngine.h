@@ -0,0 +1,95 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Life-like automaton on a torus stored in a file of bit-packed rows, for grids larger than the memory.
+    // The generation is stepped in place one band of rows at a time, and only a window of three bands is
+    // mapped: the band written back by the OS, the band being stepped and the next one, which the OS is
+    // asked to read ahead. Throughput is bound by the storage rather than by the kernel.
+    class StreamEngine {
+    public:
+        static constexpr size_t DefaultBandBytes = 64 * 1024 * 1024;
+
+        // Transfers of the last step
+        struct IoStats {
+            uint64_t bytesRead{ 0 };      // Rows of the generation mapped by the step
+            uint64_t bytesWritten{ 0 };
+            uint64_t storageRead{ 0 };    // Reported by the OS for the process, zero where unavailable
+            uint64_t storageWritten{ 0 };
+            double seconds{ 0.0 };
+        };
+
+    public:
+        StreamEngine() = default;
+        ~StreamEngine();
+
+        StreamEngine(StreamEngine const&) = delete;
+        StreamEngine& operator=(StreamEngine const&) = delete;
+
+        // Write a file with the first generation, empty or uniform random with the same cells as
+        // GenerateFirstGeneration. Empty files are sparse where the file system allows.
+        static bool Create(const std::filesystem::path& path, int width, int height, const AutomatonRules& rules,
+            const FirstGenerationParams& params, unsigned threads = 0);
+
+        // Bands hold as many rows as fit in bandBytes, at least one
+        bool Open(const std::filesystem::path& path, size_t bandBytes = DefaultBandBytes);
+        void Close();
+
+        void SetRules(const AutomatonRules& rules);
+        const AutomatonRules& GetRules() const;
+
+        // Advance by one generation, rows of each band are split between worker threads.
+        // A step that fails midway leaves the file marked as incomplete, Open refuses it.
+        bool Step(unsigned threads = 0);
+
+        int GetWidth() const;
+        int GetHeight() const;
+        size_t GetBandRows() const;
+        uint64_t GetGeneration() const;
+
+        // Population is unknown until the first step after Open
+        const GenerationStats& GetStats() const;
+        const IoStats& GetIoStats() const;
+
+    private:
+        // View of a range of the file, the OS maps it from an aligned offset
+        struct Mapping {
+            void* base{ nullptr };
+            size_t size{ 0 };
+            BitGrid::Word* rows{ nullptr };
+        };
+
+        bool OpenFile(const std::filesystem::path& path);
+        bool MapRange(uint64_t offset, size_t size, Mapping& mapping);
+        bool MapRows(size_t y, size_t count, Mapping& mapping);
+        void Unmap(Mapping& mapping);
+        bool CopyRow(size_t y, BitGrid::Word* dst);
+
+    private:
+        int width_{ 0 };
+        int height_{ 0 };
+        size_t wordsPerRow_{ 0 };
+        size_t bandRows_{ 0 };
+
+        AutomatonRules rules_{ 0, 8, 12 }; // B3/S23
+        uint64_t generation_{ 0 };
+        GenerationStats stats_;
+        IoStats ioStats_;
+
+        // Header stays mapped while the file is open
+        Mapping header_;
+
+        // Old rows the first and the last band need after they are overwritten
+        std::vector<BitGrid::Word> firstRow_;
+        std::vector<BitGrid::Word> carryRow_;
+        std::vector<BitGrid::Word> band_;
+
+#ifdef _WIN32
+        void* file_{ nullptr };
+        void* mapping_{ nullptr };
+#else
+        int fd_{ -1 };
+#endif
+    };
+
+}
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "ZeroRuns.h"
+
+// Shorter runs of empty words are cheaper to keep as literals
+constexpr size_t MinZeroRun = 2;
+
+struct ZeroRunToken {
+    uint32_t zeros;
+    uint32_t literals;
+};
+
+// Walk the tokens, return false if they don't fit into the words
+template<typename ApplyLiterals>
+bool WalkZeroRuns(const char* p, const char* end, size_t count, ApplyLiterals&& applyLiterals) {
+    size_t i = 0;
+    while (p < end) {
+        ZeroRunToken token;
+        if (static_cast<size_t>(end - p) < sizeof(token)) {
+            return false;
+        }
+        std::memcpy(&token, p, sizeof(token));
+        p += sizeof(token);
+
+        const size_t literalBytes = static_cast<size_t>(token.literals) * sizeof(uint64_t);
+        if (count - i < static_cast<size_t>(token.zeros) + token.literals ||
+                static_cast<size_t>(end - p) < literalBytes) {
+            return false;
+        }
+
+        applyLiterals(i, i + token.zeros, p, token.literals);
+        i += static_cast<size_t>(token.zeros) + token.literals;
+        p += literalBytes;
+    }
+    applyLiterals(i, count, p, 0);
+    return true;
+}
+
+
+namespace CellularAutomata {
+
+void EncodeZeroRuns(const uint64_t* words, size_t count, std::vector<char>& out) {
+    auto append = [&out](const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    };
+
+    size_t i = 0;
+    while (i < count) {
+        size_t zeros = 0;
+        while (i + zeros < count && words[i + zeros] == 0 && zeros < std::numeric_limits<uint32_t>::max()) {
+            zeros++;
+        }
+        i += zeros;
+
+        // Literals end at the next run of empty words worth collapsing
+        size_t literals = 0;
+        while (i + literals < count && literals < std::numeric_limits<uint32_t>::max()) {
+            if (words[i + literals] == 0) {
+                size_t run = 1;
+                while (run < MinZeroRun && i + literals + run < count && words[i + literals + run] == 0) {
+                    run++;
+                }
+                if (run == MinZeroRun || i + literals + run == count) {
+                    break;
+                }
+            }
+            literals++;
+        }
+
+        ZeroRunToken token{ static_cast<uint32_t>(zeros), static_cast<uint32_t>(literals) };
+        append(&token, sizeof(token));
+        append(words + i, literals * sizeof(uint64_t));
+        i += literals;
+    }
+}
+
+bool DecodeZeroRuns(const char* data, size_t size, uint64_t* words, size_t count) {
+    return WalkZeroRuns(data, data + size, count,
+        [words](size_t zerosBegin, size_t literalsBegin, const char* literals, size_t literalCount) {
+            std::fill(words + zerosBegin, words + literalsBegin, 0);
+            std::memcpy(words + literalsBegin, literals, literalCount * sizeof(uint64_t));
+        });
+}
+
+uint64_t GetZeroRunsMinSize(uint64_t count) {
+    const uint64_t maxRun = std::numeric_limits<uint32_t>::max();
+    return (count + maxRun - 1) / maxRun * sizeof(ZeroRunToken);
+}
+
+bool ApplyZeroRunsXor(const char* data, size_t size, uint64_t* words, size_t count) {
+    return WalkZeroRuns(data, data + size, count,
+        [words](size_t /*zerosBegin*/, size_t literalsBegin, const char* literals, size_t literalCount) {
+            for (size_t i = 0; i < literalCount; i++) {
+                uint64_t word;
+                std::memcpy(&word, literals + i * sizeof(word), sizeof(word));
+                words[literalsBegin + i] ^= word;
+            }
+        });
+}
+
+} // namespace CellularAutomata
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace CellularAutomata {
+
+    // Words are encoded as tokens of two 32-bit counts, empty words and literal words,
+    // followed by the literal words. Suits grids with empty areas and XOR deltas
+    // of consecutive generations, which are mostly empty.
+    void EncodeZeroRuns(const uint64_t* words, size_t count, std::vector<char>& out);
+
+    bool DecodeZeroRuns(const char* data, size_t size, uint64_t* words, size_t count);
+
+    // Fewest bytes EncodeZeroRuns writes for the count of words, all of them empty
+    uint64_t GetZeroRunsMinSize(uint64_t count);
+
+    // Literal words are XORed into the words, words of the empty runs are kept
+    bool ApplyZeroRunsXor(const char* data, size_t size, uint64_t* words, size_t count);
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <plog/Log.h>
+
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <bitset>
+#include <filesystem>
+#include <cctype>
+#include <sstream>
+#include <limits>
+#include <unordered_map>
+#include <atomic>
+#include <fstream>
+#include <chrono>
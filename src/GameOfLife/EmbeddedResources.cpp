@@ -0,0 +1,11 @@
+#include "stdafx.h"
+#include "EmbeddedResources.h"
+
+const char* Utils::EmbeddedResources::Find(const std::string& name) {
+    for (const auto* r = ResourceTable; r->name != nullptr; r++) {
+        if (name == r->name) {
+            return r->data;
+        }
+    }
+    return nullptr;
+}
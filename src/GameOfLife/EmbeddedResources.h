@@ -0,0 +1,19 @@
+#pragma once
+
+namespace Utils
+{
+    namespace EmbeddedResources
+    {
+        struct Resource {
+            const char* name;
+            const char* data;
+            size_t size;
+        };
+
+        // Generated at build time by embed_resources(), terminated with an empty entry
+        extern const Resource ResourceTable[];
+
+        // Zero-terminated contents of the embedded file, nullptr if there is no such file
+        const char* Find(const std::string& name);
+    }
+}
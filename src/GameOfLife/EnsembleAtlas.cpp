@@ -0,0 +1,236 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "GraphicsResource.h"
+#include "TexturePool.h"
+#include "RenderTargetRing.h"
+#include "AsyncReadback.h"
+#include "PlanarTextureRenderer.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "EnsembleEngine.h"
+#include "EnsembleAtlas.h"
+
+using CellularAutomata::EnsembleEngine;
+
+// Shift of the survive mask in the rules texture, as in ensemble.frag
+constexpr int RulesSurviveShift = 9;
+
+// Integer textures are incomplete with linear filtering
+void SetNearestFilter(GLuint texture) {
+    glBindTexture(GL_TEXTURE_2D, texture); LOGOPENGLERROR();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); LOGOPENGLERROR();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+}
+
+EnsembleAtlas::~EnsembleAtlas() {
+    Release();
+}
+
+bool EnsembleAtlas::Init(GLuint stepProgram, GLuint statsProgram, size_t readbackCount) {
+    if (!stepRenderer_.Init(stepProgram) || !statsRenderer_.Init(statsProgram)) {
+        LOGE << "Failed to init ensemble renderers";
+        return false;
+    }
+
+    stepProgram_ = stepProgram;
+    uRulesTex_ = glGetUniformLocation(stepProgram, "rulesTex"); LOGOPENGLERROR();
+
+    readbackCount_ = readbackCount;
+    return true;
+}
+
+bool EnsembleAtlas::Resize(GraphicsUtils::TexturePool& pool, size_t count) {
+    Release();
+
+    pool_ = &pool;
+    count_ = count;
+    columns_ = std::max(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count)))), 1);
+    rows_ = std::max(static_cast<int>((count + columns_ - 1) / columns_), 1);
+    generation_ = 0;
+
+    const int width = columns_ * EnsembleEngine::UniverseSize;
+    const int height = rows_ * EnsembleEngine::UniverseSize;
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize); LOGOPENGLERROR();
+    if (width > maxSize || height > maxSize) {
+        LOGE << "Atlas of " << count << " universes is larger than the maximum texture size " << maxSize;
+        Release();
+        return false;
+    }
+
+    if (!generations_.Init(pool, 2, width, height, GL_R8, GL_NEAREST, GL_CLAMP_TO_EDGE)) {
+        LOGE << "Failed to init ensemble atlas " << width << "x" << height;
+        Release();
+        return false;
+    }
+
+    rulesTexture_ = pool_->Acquire(columns_, rows_, GL_R32UI);
+    statsTexture_ = pool_->Acquire(columns_, rows_, GL_RG32UI);
+    if (!rulesTexture_ || !statsTexture_) {
+        LOGE << "Failed to init ensemble textures";
+        Release();
+        return false;
+    }
+    SetNearestFilter(rulesTexture_);
+    SetNearestFilter(statsTexture_);
+
+    glGenFramebuffers(1, statsFramebuffer_.put()); LOGOPENGLERROR();
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(statsFramebuffer_)); LOGOPENGLERROR();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, statsTexture_, 0); LOGOPENGLERROR();
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER); LOGOPENGLERROR();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOGE << "Ensemble stats framebuffer is incomplete : " << status;
+        Release();
+        return false;
+    }
+
+    if (!readback_.Init(readbackCount_, static_cast<size_t>(columns_) * rows_ * 2 * sizeof(GLuint))) {
+        LOGE << "Failed to init ensemble readback";
+        Release();
+        return false;
+    }
+
+    stepRenderer_.Resize(width, height);
+    statsRenderer_.Resize(columns_, rows_);
+
+    rules_.assign(static_cast<size_t>(columns_) * rows_, 0);
+    stats_.assign(count_, CellularAutomata::GenerationStats());
+
+    LOGI << "Ensemble of " << count_ << " universes in a " << width << "x" << height << " atlas";
+    return true;
+}
+
+void EnsembleAtlas::Release() {
+    readback_.Release();
+    generations_.Release();
+
+    statsFramebuffer_.reset();
+    if (rulesTexture_) {
+        pool_->Recycle(rulesTexture_);
+        rulesTexture_ = 0;
+    }
+    if (statsTexture_) {
+        pool_->Recycle(statsTexture_);
+        statsTexture_ = 0;
+    }
+}
+
+void EnsembleAtlas::Upload(const EnsembleEngine& engine) {
+    if (engine.GetCount() != count_) {
+        LOGE << "Ensemble of " << engine.GetCount() << " universes doesn't fit the atlas of " << count_;
+        return;
+    }
+
+    constexpr int size = EnsembleEngine::UniverseSize;
+    const size_t width = static_cast<size_t>(columns_) * size;
+    uploadBuffer_.assign(width * rows_ * size, 0);
+
+    for (size_t u = 0; u < count_; u++) {
+        const size_t x0 = (u % columns_) * size;
+        const size_t y0 = (u / columns_) * size;
+        for (int y = 0; y < size; y++) {
+            const auto row = engine.GetRow(u, y);
+            uint8_t* dst = uploadBuffer_.data() + (y0 + y) * width + x0;
+            for (int x = 0; x < size; x++) {
+                dst[x] = ((row >> x) & 1) ? 0xff : 0;
+            }
+        }
+
+        const auto rules = engine.GetRules(u);
+        rules_[u] = static_cast<GLuint>(rules.birth) | (static_cast<GLuint>(rules.survive) << RulesSurviveShift);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, generations_.GetNextTexture()); LOGOPENGLERROR();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); LOGOPENGLERROR();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns_ * size, rows_ * size,
+        GL_RED, GL_UNSIGNED_BYTE, uploadBuffer_.data()); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+    generations_.Advance();
+    generations_.ResetHistory();
+    generation_ = engine.GetGeneration();
+
+    UploadRules();
+}
+
+void EnsembleAtlas::UploadRules() {
+    glBindTexture(GL_TEXTURE_2D, rulesTexture_); LOGOPENGLERROR();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4); LOGOPENGLERROR();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns_, rows_, GL_RED_INTEGER, GL_UNSIGNED_INT, rules_.data()); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+}
+
+void EnsembleAtlas::Step() {
+    if (count_ == 0) {
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, generations_.GetNextFramebuffer()); LOGOPENGLERROR();
+
+    // The renderer binds the generation to unit 0, rules go to unit 1
+    glUseProgram(stepProgram_); LOGOPENGLERROR();
+    glUniform1i(uRulesTex_, 1); LOGOPENGLERROR();
+    glActiveTexture(GL_TEXTURE1); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, rulesTexture_); LOGOPENGLERROR();
+
+    stepRenderer_.SetTexture(generations_.GetTexture());
+    stepRenderer_.AdjustViewport();
+    stepRenderer_.Render();
+
+    glActiveTexture(GL_TEXTURE1); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+    glActiveTexture(GL_TEXTURE0); LOGOPENGLERROR();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    generations_.Advance();
+    generation_++;
+}
+
+bool EnsembleAtlas::RequestStats() {
+    if (count_ == 0 || readback_.GetPendingCount() == readback_.GetCount()) {
+        return false;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(statsFramebuffer_)); LOGOPENGLERROR();
+
+    statsRenderer_.SetTexture(generations_.GetTexture());
+    statsRenderer_.AdjustViewport();
+    statsRenderer_.Render();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    return readback_.Request(static_cast<GLuint>(statsFramebuffer_), columns_, rows_, GL_RG_INTEGER,
+        GL_UNSIGNED_INT, generation_);
+}
+
+void EnsembleAtlas::Poll(const Consumer& consume) {
+    readback_.Poll([this, &consume](const void* data, size_t /*size*/, uint64_t generation) {
+        const GLuint* texels = static_cast<const GLuint*>(data);
+        for (size_t u = 0; u < count_; u++) {
+            stats_[u].population = texels[2 * u];
+            stats_[u].hash = texels[2 * u + 1];
+        }
+        consume(generation, stats_);
+    });
+}
+
+void EnsembleAtlas::Discard() {
+    readback_.Flush([](const void*, size_t, uint64_t) {});
+}
+
+GLuint EnsembleAtlas::GetTexture() const {
+    return generations_.GetTexture();
+}
+
+size_t EnsembleAtlas::GetCount() const {
+    return count_;
+}
+
+uint64_t EnsembleAtlas::GetGeneration() const {
+    return generation_;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Universes of an EnsembleEngine stepped on the GPU. Every universe is a 64x64 tile of one atlas
+// texture, so all of them advance with a single draw call. Population and hash of each universe
+// are reduced to a texel per tile and read back a few frames later.
+class EnsembleAtlas {
+public:
+    using Consumer = std::function<void(uint64_t generation, const std::vector<CellularAutomata::GenerationStats>& stats)>;
+
+public:
+    EnsembleAtlas() = default;
+    ~EnsembleAtlas();
+
+    EnsembleAtlas(EnsembleAtlas const&) = delete;
+    EnsembleAtlas& operator=(EnsembleAtlas const&) = delete;
+
+    bool Init(GLuint stepProgram, GLuint statsProgram, size_t readbackCount);
+
+    // Tiles are laid out in a square as far as possible, textures are taken from the pool
+    bool Resize(GraphicsUtils::TexturePool& pool, size_t count);
+    void Release();
+
+    // Cells, rules and generation of the CPU ensemble of the same size
+    void Upload(const CellularAutomata::EnsembleEngine& engine);
+
+    void Step();
+
+    // Queue the counters of the latest generation, false if every readback is in flight
+    bool RequestStats();
+
+    // Pass the completed counters to the consumer in the generation order.
+    // The hash is 32-bit and differs from the hash of the CPU engines.
+    void Poll(const Consumer& consume);
+    void Discard();
+
+    GLuint GetTexture() const;
+    size_t GetCount() const;
+    uint64_t GetGeneration() const;
+
+private:
+    void UploadRules();
+
+private:
+    GraphicsUtils::TexturePool* pool_{ nullptr };
+    size_t count_{ 0 };
+    int columns_{ 0 };
+    int rows_{ 0 };
+    uint64_t generation_{ 0 };
+
+    GraphicsUtils::RenderTargetRing generations_;
+
+    // Birth in bits 0-8 and survive in bits 9-17, zero for the unused tiles
+    std::vector<GLuint> rules_;
+    GLuint rulesTexture_{ 0 };
+
+    GLuint statsTexture_{ 0 };
+    GraphicsUtils::unique_framebuffer statsFramebuffer_;
+
+    GLuint stepProgram_{ 0 };
+    GLint uRulesTex_{ -1 };
+    PlanarTextureRenderer stepRenderer_;
+    PlanarTextureRenderer statsRenderer_;
+
+    GraphicsUtils::AsyncReadback readback_;
+    size_t readbackCount_{ 0 };
+    std::vector<CellularAutomata::GenerationStats> stats_;
+
+    std::vector<uint8_t> uploadBuffer_;
+};
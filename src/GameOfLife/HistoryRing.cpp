@@ -0,0 +1,31 @@
+#include "stdafx.h"
+#include "HistoryRing.h"
+
+HistoryRing::HistoryRing(size_t capacity)
+    : values(capacity, 0.0f) {
+}
+
+void HistoryRing::Push(float value) {
+    values[head] = value;
+    head = (head + 1) % values.size();
+    count = std::min(count + 1, values.size());
+}
+
+void HistoryRing::Clear() {
+    head = 0;
+    count = 0;
+}
+
+size_t HistoryRing::GetSize() const {
+    return count;
+}
+
+float HistoryRing::GetLast() const {
+    return (count > 0) ? values[(head + values.size() - 1) % values.size()] : 0.0f;
+}
+
+void HistoryRing::Plot(const char* label, ImVec2 size) const {
+    // Oldest value is at the head once the ring is full
+    const int offset = (count == values.size()) ? static_cast<int>(head) : 0;
+    ImGui::PlotLines(label, values.data(), static_cast<int>(count), offset, nullptr, 0.0f, FLT_MAX, size);
+}
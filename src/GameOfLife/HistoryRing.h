@@ -0,0 +1,21 @@
+#pragma once
+
+// Latest values of a statistic for plotting, the oldest ones are overwritten
+class HistoryRing {
+public:
+    explicit HistoryRing(size_t capacity);
+
+    void Push(float value);
+    void Clear();
+
+    size_t GetSize() const;
+    float GetLast() const;
+
+    // Plot lines from the oldest value to the latest one
+    void Plot(const char* label, ImVec2 size) const;
+
+private:
+    std::vector<float> values;
+    size_t head = 0; // Slot of the next value
+    size_t count = 0;
+};
@@ -1,14 +1,56 @@
 #include "stdafx.h"
 #include "GraphicsLogger.h"
 #include "GraphicsResource.h"
+#include "TexturePool.h"
+#include "RenderTargetRing.h"
+#include "AsyncReadback.h"
+#include "ImageFile.h"
+#include "FrameCapture.h"
 #include "Shader.h"
 #include "PlanarTextureRenderer.h"
+#include "PopulationCounter.h"
+#include "HistoryRing.h"
 #include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "RandomGenerator.h"
+#include "Rules.h"
+#include "PatternLoader.h"
+#include "NodeStore.h"
+#include "Macrocell.h"
+#include "Snapshot.h"
+#include "MappedFile.h"
+#include "GenerationStream.h"
+#include "LifeEngine.h"
+#include "PeriodDetector.h"
+#include "Components.h"
+#include "PlaneEngine.h"
+#include "EnsembleEngine.h"
+#include "EnsembleAtlas.h"
+#include "TiledGrid.h"
 #include "ResourceFinder.h"
+#include "EmbeddedResources.h"
 #include "LifeContext.h"
 
 constexpr double UiWidth = 250.0;
 
+const std::string ShaderDirArg = "--shader-dir";
+const std::string SeedArg = "--seed";
+const std::string DensityArg = "--density";
+const std::string PatternArg = "--pattern";
+const std::string DecodeThreadsArg = "--decode-threads";
+const std::string SnapshotArg = "--snapshot";
+const std::string SnapshotIntervalArg = "--snapshot-interval";
+const std::string RecordArg = "--record";
+const std::string PlayArg = "--play";
+const std::string CaptureArg = "--capture";
+const std::string CaptureDirArg = "--capture-dir";
+const std::string UntilStableArg = "--until-stable";
+const std::string EnsembleArg = "--ensemble";
+const std::string TiledArg = "--tiled";
+
+const std::filesystem::path SnapshotExtension = ".snap";
+const std::filesystem::path RecordingExtension = ".rec";
+
 const std::filesystem::path BufferRendererVert = "life.vert";
 const std::filesystem::path BufferRendererFrag = "life.frag";
 
@@ -18,8 +60,39 @@ const std::filesystem::path InitialDataFrag = "life-init.frag";
 const std::filesystem::path ScreenRendererVert = "screen-plane.vert";
 const std::filesystem::path ScreenRendererFrag = "screen-plane.frag";
 
+const std::filesystem::path PopulationVert = BufferRendererVert;
+const std::filesystem::path PopulationFirstFrag = "population-first.frag";
+const std::filesystem::path PopulationReduceFrag = "population-reduce.frag";
+
+const std::filesystem::path EnsembleVert = BufferRendererVert;
+const std::filesystem::path EnsembleFrag = "ensemble.frag";
+const std::filesystem::path EnsembleStatsFrag = "ensemble-stats.frag";
+
+const std::filesystem::path TiledGridVert = BufferRendererVert;
+const std::filesystem::path TiledGridFrag = "life-tile.frag";
+
 const HMM_Vec4 ScreenArea = { -1.0, 1.0, -1.0, 1.0 };
 
+constexpr size_t GenerationsRingSize = 8;
+constexpr int MaxGensPerFrame = 16;
+
+// The CPU consumes generation N while the GPU computes N + 2
+constexpr size_t ReadbackRingSize = 3;
+
+// Counts of a few frames of generations are in flight
+constexpr size_t PopulationReadbackCount = 4 * MaxGensPerFrame;
+constexpr size_t StatsHistorySize = 512;
+
+// Fraction of the model drawn around the cursor, as in life.frag
+constexpr float ActivityRadius = 0.05f;
+
+constexpr int MaxStablePeriodLimit = 64;
+constexpr uint64_t FastForwardGenerations = 1000000;
+
+constexpr int DefaultEnsembleCount = 4096;
+constexpr int MaxEnsembleCount = 16384;
+constexpr size_t EnsembleReadbackCount = 3;
+
 const std::vector<std::tuple<std::string, int>> ModelSizes = {
     {"128", 128},
     {"256", 256},
@@ -54,23 +127,20 @@ static const std::vector<std::tuple<std::string, CellularAutomata::FirstGenerati
     {"Empty / Manual draw", CellularAutomata::FirstGenerationType::Empty},
     {"Radial Random", CellularAutomata::FirstGenerationType::RadialRandom},
     {"Uniform Random", CellularAutomata::FirstGenerationType::UniformRandom},
+    {"Pattern file", CellularAutomata::FirstGenerationType::Pattern},
 };
 
-auto InitTexture(GLuint tex, GLenum format, GLsizei size, GLenum filter, GLenum wrap) -> void {
-    glBindTexture(GL_TEXTURE_2D, tex); LOGOPENGLERROR();
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
-        size, size,
-        0, format, GL_UNSIGNED_BYTE, nullptr); LOGOPENGLERROR();
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter); LOGOPENGLERROR();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter); LOGOPENGLERROR();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap); LOGOPENGLERROR();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap); LOGOPENGLERROR();
-}
-
 LifeContext::LifeContext(GLFWwindow* w)
-    : window(w) {
+    : window(w)
+    , populationHistory(StatsHistorySize)
+    , birthsHistory(StatsHistorySize)
+    , deathsHistory(StatsHistorySize) {
+    generationConsumer = [this](const void* data, size_t size, uint64_t generation) {
+        ConsumeGeneration(data, size, generation);
+    };
+    ensembleConsumer = [this](uint64_t generation, const std::vector<CellularAutomata::GenerationStats>& stats) {
+        AddEnsembleStats(generation, stats);
+    };
 }
 
 bool LifeContext::InitTextures(int newSize) {
@@ -78,29 +148,87 @@ bool LifeContext::InitTextures(int newSize) {
 
     textureSize = newSize;
 
-    glGenTextures(1, currentGenerationTex.put()); LOGOPENGLERROR();
-    if (!currentGenerationTex) {
-        LOGE << "Failed to init texture";
+    // Textures of the previous size go back to the pool, so switching back is free
+    if (!generations.Init(texturePool, GenerationsRingSize, (GLsizei)textureSize, (GLsizei)textureSize,
+            GL_R8, GL_NEAREST, GL_REPEAT)) {
+        LOGE << "Failed to init textures";
         return false;
     }
 
-    glGenTextures(1, nextGenerationTex.put()); LOGOPENGLERROR();
-    if (!nextGenerationTex) {
-        LOGE << "Failed to init texture";
+    if (!generationReadback.Init(ReadbackRingSize, static_cast<size_t>(textureSize) * textureSize)) {
+        LOGE << "Failed to init generation readback";
         return false;
     }
 
-    InitTexture(static_cast<GLuint>(currentGenerationTex), GL_RED, (GLsizei)textureSize, GL_NEAREST, GL_REPEAT);
-    InitTexture(static_cast<GLuint>(nextGenerationTex), GL_RED, (GLsizei)textureSize, GL_NEAREST, GL_REPEAT);
+    if (!populationCounter.Resize(texturePool, textureSize)) {
+        LOGE << "Failed to init population count textures";
+        return false;
+    }
+    LOGD << "Population is reduced in " << populationCounter.GetPassCount() << " passes";
 
     return true;
 }
 
-bool LifeContext::Init(int /*argc*/, const char* argv[], int newWidth, int newHeight, int texSize) {
-    std::filesystem::path moduleDataDir;
-    if (!Utils::ResourceFinder::GetDataDirectory(argv[0], moduleDataDir)) {
-        LOGE << "Unable to find data directory";
-        return false;
+bool LifeContext::Init(int argc, const char* argv[], int newWidth, int newHeight, int texSize) {
+    std::filesystem::path initialPattern;
+    std::filesystem::path recordPath, playPath;
+    bool startCapture = false;
+    for (int i = 1; i < argc - 1; i++) {
+        if (argv[i] == ShaderDirArg) {
+            shaderOverrideDir = argv[++i];
+            LOGI << "Loading shaders from " << shaderOverrideDir.string();
+        }
+        else if (argv[i] == SeedArg) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+            randomizeSeed = false;
+        }
+        else if (argv[i] == DensityArg) {
+            density = std::strtof(argv[++i], nullptr);
+        }
+        else if (argv[i] == PatternArg) {
+            initialPattern = argv[++i];
+        }
+        else if (argv[i] == DecodeThreadsArg) {
+            patternDecodeThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argv[i] == SnapshotArg) {
+            snapshotPath = argv[++i];
+        }
+        else if (argv[i] == SnapshotIntervalArg) {
+            snapshotInterval = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i] == RecordArg) {
+            recordPath = argv[++i];
+        }
+        else if (argv[i] == PlayArg) {
+            playPath = argv[++i];
+        }
+        else if (argv[i] == CaptureArg) {
+            captureState = (std::string(argv[++i]) == "state");
+            startCapture = true;
+        }
+        else if (argv[i] == CaptureDirArg) {
+            captureDir = argv[++i];
+        }
+        else if (argv[i] == EnsembleArg) {
+            ensembleCount = std::clamp(std::atoi(argv[++i]), 1, MaxEnsembleCount);
+            ensembleMode = true;
+        }
+        else if (argv[i] == TiledArg) {
+            // Width and height as WxH
+            char* end = nullptr;
+            tiledWidth = std::clamp(static_cast<int>(std::strtol(argv[++i], &end, 10)), 1, TiledGrid::MaxSize);
+            tiledHeight = tiledWidth;
+            if (*end == 'x') {
+                tiledHeight = std::clamp(static_cast<int>(std::strtol(end + 1, nullptr, 10)), 1, TiledGrid::MaxSize);
+            }
+            tiledMode = true;
+        }
+        else if (argv[i] == UntilStableArg) {
+            maxStablePeriod = std::clamp(std::atoi(argv[++i]), 1, MaxStablePeriodLimit);
+            stopWhenStable = true;
+            simulateOnCpu = true;
+        }
     }
 
     LOGI << "OpenGL Renderer : " << glGetString(GL_RENDERER);
@@ -117,10 +245,12 @@ bool LifeContext::Init(int /*argc*/, const char* argv[], int newWidth, int newHe
     currentRules = std::get<2>(AutomatonRules[0]);
     firstGenerationType = CellularAutomata::FirstGenerationType::RadialRandom;
 
+    // Compare with the previous start to see the effect of the program cache
+    Shader::SetProgramCacheDirectory(Utils::ResourceFinder::GetCacheDirectory());
+    auto programsStartTime = std::chrono::steady_clock::now();
+
     // CA simulation
-    auto bufferRendererVert = (moduleDataDir / BufferRendererVert).string();
-    auto bufferRendererFrag = (moduleDataDir / BufferRendererFrag).string();
-    automataProgram.reset(Shader::CreateProgram(bufferRendererVert, bufferRendererFrag));
+    automataProgram.reset(CreateProgram(BufferRendererVert, BufferRendererFrag));
     if (!automataProgram) {
         LOGE << "Failed to init shader program for cellular automata";
         return false;
@@ -138,15 +268,15 @@ bool LifeContext::Init(int /*argc*/, const char* argv[], int newWidth, int newHe
     }
 
     // CA init data
-    auto initialDataVert = (moduleDataDir / InitialDataVert).string();
-    auto initialDataFrag = (moduleDataDir / InitialDataFrag).string();
-    automataInitProgram.reset(Shader::CreateProgram(initialDataVert, initialDataFrag));
+    automataInitProgram.reset(CreateProgram(InitialDataVert, InitialDataFrag));
     if (!automataInitProgram) {
         LOGE << "Failed to init shader program for initial state of cellular automata";
         return false;
     }
 
     uInitType = glGetUniformLocation(static_cast<GLuint>(automataInitProgram), "initType"); LOGOPENGLERROR();
+    uInitSeed = glGetUniformLocation(static_cast<GLuint>(automataInitProgram), "seed"); LOGOPENGLERROR();
+    uInitDensityThreshold = glGetUniformLocation(static_cast<GLuint>(automataInitProgram), "densityThreshold"); LOGOPENGLERROR();
 
     if (!automataInitialRenderer.Init(static_cast<GLuint>(automataInitProgram))) {
         LOGE << "Failed to setup initial cellular automata data creator";
@@ -154,9 +284,7 @@ bool LifeContext::Init(int /*argc*/, const char* argv[], int newWidth, int newHe
     }
 
     // Screen renderer
-    auto screenRendererVert = (moduleDataDir / ScreenRendererVert).string();
-    auto screenRendererFrag = (moduleDataDir / ScreenRendererFrag).string();
-    screenProgram.reset(Shader::CreateProgram(screenRendererVert, screenRendererFrag));
+    screenProgram.reset(CreateProgram(ScreenRendererVert, ScreenRendererFrag));
     if (!screenProgram) {
         LOGE << "Failed to init shader program for screen rendering";
         return false;
@@ -169,13 +297,49 @@ bool LifeContext::Init(int /*argc*/, const char* argv[], int newWidth, int newHe
 
     screenRenderer.Resize(width, height);
 
-    // Init framebuffer
-    glGenFramebuffers(1, frameBuffer.put()); LOGOPENGLERROR();
-    if (!frameBuffer) {
-        LOGE << "Failed to init framebuffer";
+    // Population count
+    populationFirstProgram.reset(CreateProgram(PopulationVert, PopulationFirstFrag));
+    populationReduceProgram.reset(CreateProgram(PopulationVert, PopulationReduceFrag));
+    if (!populationFirstProgram || !populationReduceProgram) {
+        LOGE << "Failed to init shader programs for population count";
+        return false;
+    }
+
+    if (!populationCounter.Init(static_cast<GLuint>(populationFirstProgram),
+            static_cast<GLuint>(populationReduceProgram), PopulationReadbackCount)) {
+        LOGE << "Failed to init population counter";
+        return false;
+    }
+
+    // Ensemble of small universes
+    ensembleStepProgram.reset(CreateProgram(EnsembleVert, EnsembleFrag));
+    ensembleStatsProgram.reset(CreateProgram(EnsembleVert, EnsembleStatsFrag));
+    if (!ensembleStepProgram || !ensembleStatsProgram) {
+        LOGE << "Failed to init shader programs for the ensemble";
+        return false;
+    }
+
+    if (!ensembleAtlas.Init(static_cast<GLuint>(ensembleStepProgram),
+            static_cast<GLuint>(ensembleStatsProgram), EnsembleReadbackCount)) {
+        LOGE << "Failed to init ensemble atlas";
         return false;
     }
 
+    // Grids larger than a texture
+    tiledStepProgram.reset(CreateProgram(TiledGridVert, TiledGridFrag));
+    if (!tiledStepProgram) {
+        LOGE << "Failed to init shader program for the tiled grid";
+        return false;
+    }
+
+    if (!tiledGrid.Init(static_cast<GLuint>(tiledStepProgram), static_cast<GLuint>(automataInitProgram))) {
+        LOGE << "Failed to init tiled grid";
+        return false;
+    }
+
+    std::chrono::duration<double, std::milli> programsTime = std::chrono::steady_clock::now() - programsStartTime;
+    LOGI << "Shader programs ready in " << programsTime.count() << " ms";
+
     // Setup OpenGL flags
     glClearColor(0.0, 0.0, 0.0, 1.0); LOGOPENGLERROR();
     glClearDepth(1.0); LOGOPENGLERROR();
@@ -185,27 +349,428 @@ bool LifeContext::Init(int /*argc*/, const char* argv[], int newWidth, int newHe
     // Init textures and create first generation
     SetModelSize(texSize);
 
+    if (!initialPattern.empty() && !LoadPattern(initialPattern)) {
+        return false;
+    }
+
+    // Continue the run interrupted by a restart
+    if (!snapshotPath.empty() && std::filesystem::exists(snapshotPath) && !RestoreSnapshot(snapshotPath)) {
+        return false;
+    }
+
+    if (!recordPath.empty() && !StartRecording(recordPath)) {
+        return false;
+    }
+    if (!playPath.empty() && !StartPlayback(playPath)) {
+        return false;
+    }
+    if (startCapture && !StartCapture()) {
+        return false;
+    }
+    if (ensembleMode && !StartEnsemble(static_cast<size_t>(ensembleCount))) {
+        return false;
+    }
+    if (tiledMode && !StartTiledGrid(tiledWidth, tiledHeight)) {
+        return false;
+    }
+
     RegisterCallbacks();
 
     return true;
 }
 
+GLuint LifeContext::CreateProgram(const std::filesystem::path& vertexShader, const std::filesystem::path& fragmentShader) {
+    if (!shaderOverrideDir.empty()) {
+        return Shader::CreateProgram((shaderOverrideDir / vertexShader).string(),
+            (shaderOverrideDir / fragmentShader).string());
+    }
+
+    const char* vertexSource = Utils::EmbeddedResources::Find(vertexShader.string());
+    const char* fragmentSource = Utils::EmbeddedResources::Find(fragmentShader.string());
+    if (!vertexSource || !fragmentSource) {
+        LOGE << "Shaders " << vertexShader << " " << fragmentShader << " are not embedded";
+        return 0;
+    }
+
+    LOGI << "Embedded Shaders: " << vertexShader.string() << " " << fragmentShader.string();
+    return Shader::CreateProgramFromSource(vertexSource, fragmentSource);
+}
+
 void LifeContext::InitFirstGeneration() {
+    // Generations of a recording must increase, a recording without frames yet starts with this run
+    if (recorder.IsOpen() && (recorder.GetFrameCount() > 0 || generationReadback.GetPendingCount() > 0)) {
+        LOGI << "Recording is stopped by the restart";
+        StopRecording();
+    }
+
     generationCounter = 0;
+    lastSnapshotGeneration = 0;
+
+    // Counts of the previous run are late
+    populationCounter.Discard();
+    ClearStatsHistory();
+    cpuEngineStale = true;
+
+    if (firstGenerationType == CellularAutomata::FirstGenerationType::Pattern) {
+        if (patternGrid.GetWidth() != textureSize || patternGrid.GetHeight() != textureSize) {
+            DecodePatternFile();
+        }
+        UploadGeneration(patternGrid);
+        return;
+    }
+
+    if (randomizeSeed) {
+        seed = std::random_device{}();
+    }
+    LOGI << "First generation seed : " << seed;
 
-    automataInitialRenderer.SetTime(glfwGetTime());
+    if (generateOnCpu) {
+        CellularAutomata::FirstGenerationParams params{ firstGenerationType, seed, density };
+
+        auto startTime = std::chrono::steady_clock::now();
+        cpuGrid.Resize(textureSize, textureSize);
+        CellularAutomata::GenerateFirstGeneration(cpuGrid, params);
+        std::chrono::duration<double, std::milli> generationTime = std::chrono::steady_clock::now() - startTime;
+        LOGD << "First generation on CPU in " << generationTime.count() << " ms";
+
+        UploadGeneration(cpuGrid);
+        return;
+    }
 
     glUseProgram(static_cast<GLuint>(automataInitProgram)); LOGOPENGLERROR();
     glUniform1i(uInitType, static_cast<int>(firstGenerationType)); LOGOPENGLERROR();
+    glUniform1ui(uInitSeed, seed); LOGOPENGLERROR();
+    glUniform1ui(uInitDensityThreshold, CellularAutomata::GetDensityThreshold(density)); LOGOPENGLERROR();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(frameBuffer)); LOGOPENGLERROR();
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, static_cast<GLuint>(nextGenerationTex), 0); LOGOPENGLERROR();
+    glBindFramebuffer(GL_FRAMEBUFFER, generations.GetNextFramebuffer()); LOGOPENGLERROR();
 
     automataInitialRenderer.AdjustViewport();
     automataInitialRenderer.Render();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    generations.Advance();
+    generations.ResetHistory();
+}
+
+void LifeContext::UploadGeneration(const CellularAutomata::BitGrid& grid) {
+    uploadBuffer.resize(static_cast<size_t>(grid.GetWidth()) * grid.GetHeight());
+    grid.Unpack(uploadBuffer.data(), 0xff);
+
+    glBindTexture(GL_TEXTURE_2D, generations.GetNextTexture()); LOGOPENGLERROR();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); LOGOPENGLERROR();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, grid.GetWidth(), grid.GetHeight(),
+        GL_RED, GL_UNSIGNED_BYTE, uploadBuffer.data()); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+    generations.Advance();
+    generations.ResetHistory();
+}
+
+void LifeContext::DownloadGeneration(CellularAutomata::BitGrid& grid) {
+    grid.Resize(textureSize, textureSize);
+    uploadBuffer.resize(static_cast<size_t>(textureSize) * textureSize);
+
+    glBindTexture(GL_TEXTURE_2D, generations.GetTexture()); LOGOPENGLERROR();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); LOGOPENGLERROR();
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_UNSIGNED_BYTE, uploadBuffer.data()); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+    grid.Pack(uploadBuffer.data());
+}
+
+bool LifeContext::LoadPattern(const std::filesystem::path& path) {
+    // The pattern already loaded stays when the new one fails
+    const std::filesystem::path previousPath = patternPath;
+    patternPath = path;
+    if (!DecodePatternFile()) {
+        patternPath = previousPath;
+        return false;
+    }
+
+    std::strncpy(patternPathInput.data(), patternPath.string().c_str(), patternPathInput.size() - 1);
+
+    SetFirstGenerationType(CellularAutomata::FirstGenerationType::Pattern);
+    return true;
+}
+
+bool LifeContext::DecodePatternFile() {
+    if (patternPath.empty()) {
+        patternGrid.Resize(textureSize, textureSize);
+        return true;
+    }
+    if (patternGrid.GetWidth() != textureSize || patternGrid.GetHeight() != textureSize) {
+        patternGrid.Resize(textureSize, textureSize);
+    }
+
+    CellularAutomata::PatternInfo info;
+
+    auto startTime = std::chrono::steady_clock::now();
+    if (!CellularAutomata::LoadPattern(patternPath, patternGrid, info, patternDecodeThreads)) {
+        LOGE << "Unable to load pattern " << patternPath.string();
+        return false;
+    }
+    std::chrono::duration<double> decodeTime = std::chrono::steady_clock::now() - startTime;
+
+    // Compare with --decode-threads 1 for the sequential decoder
+    LOGI << "Pattern " << patternPath.filename().string() << " : " << info.width << "x" << info.height
+        << " decoded in " << decodeTime.count() * 1000.0 << " ms, "
+        << info.bytes / (1024.0 * 1024.0) / std::max(decodeTime.count(), 1e-9) << " MB/s, "
+        << info.threads << " threads";
+    if (info.width > textureSize || info.height > textureSize) {
+        LOGW << "Pattern is clipped by the model size " << textureSize;
+    }
+
+    if (!info.rule.empty()) {
+        CellularAutomata::AutomatonRules rules;
+        if (!CellularAutomata::ParseRuleString(info.rule, rules)) {
+            LOGW << "Unsupported rule of the pattern : " << info.rule;
+        }
+        else if (rules.birth != currentRules.birth || rules.survive != currentRules.survive) {
+            // Select the listed rules if there are such
+            for (const auto& r : AutomatonRules) {
+                const auto& listed = std::get<2>(r);
+                if (listed.birth == rules.birth && listed.survive == rules.survive) {
+                    rules = listed;
+                }
+            }
+            LOGI << "Switching to the rule of the pattern : " << CellularAutomata::FormatRuleString(rules);
+            SetAutomatonRules(rules);
+        }
+    }
+
+    return true;
+}
+
+bool LifeContext::SavePattern(const std::filesystem::path& path) {
+    if (CellularAutomata::GetPatternFormat(path) != CellularAutomata::PatternFormat::Macrocell) {
+        LOGE << "Patterns are saved in Macrocell format only, use .mc extension : " << path.string();
+        return false;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    CellularAutomata::BitGrid grid;
+    DownloadGeneration(grid);
+
+    CellularAutomata::NodeStore store;
+    auto root = store.FromGrid(grid);
+    if (!CellularAutomata::SaveMacrocell(path, store, root, CellularAutomata::FormatRuleString(currentRules))) {
+        LOGE << "Unable to save pattern " << path.string();
+        return false;
+    }
+    std::chrono::duration<double, std::milli> saveTime = std::chrono::steady_clock::now() - startTime;
+
+    LOGI << "Generation " << generationCounter << " saved to " << path.string() << " : "
+        << store.GetNodeCount() << " nodes in " << saveTime.count() << " ms";
+    return true;
+}
+
+bool LifeContext::SaveSnapshot(const std::filesystem::path& path) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    CellularAutomata::SnapshotState state;
+    DownloadGeneration(state.grid);
+    state.rules = currentRules;
+    state.generation = generationCounter;
+    state.seed = seed;
+
+    if (!CellularAutomata::SaveSnapshot(path, state)) {
+        return false;
+    }
+    std::chrono::duration<double, std::milli> saveTime = std::chrono::steady_clock::now() - startTime;
+
+    LOGI << "Generation " << generationCounter << " snapshot saved to " << path.string() << " in "
+        << saveTime.count() << " ms";
+    lastSnapshotGeneration = generationCounter;
+    return true;
+}
+
+bool LifeContext::RestoreSnapshot(const std::filesystem::path& path) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    CellularAutomata::SnapshotState state;
+    if (!CellularAutomata::LoadSnapshot(path, state)) {
+        LOGE << "Unable to restore snapshot " << path.string();
+        return false;
+    }
+    if (state.grid.GetWidth() != state.grid.GetHeight()) {
+        LOGE << "Snapshot model is not square : " << state.grid.GetWidth() << "x" << state.grid.GetHeight();
+        return false;
+    }
+
+    if (state.grid.GetWidth() != textureSize) {
+        SetModelSize(state.grid.GetWidth());
+    }
+
+    // Prefer the listed rules, the id of the snapshot may come from an older build
+    currentRules = state.rules;
+    for (const auto& r : AutomatonRules) {
+        const auto& listed = std::get<2>(r);
+        if (listed.birth == state.rules.birth && listed.survive == state.rules.survive) {
+            currentRules = listed;
+        }
+    }
+
+    seed = state.seed;
+    UploadGeneration(state.grid);
+    generationCounter = state.generation;
+    lastSnapshotGeneration = state.generation;
+    needDataInit = false;
+    cpuEngineStale = true;
+
+    std::chrono::duration<double, std::milli> restoreTime = std::chrono::steady_clock::now() - startTime;
+    LOGI << "Generation " << generationCounter << " restored from " << path.string() << " in "
+        << restoreTime.count() << " ms, rule " << CellularAutomata::FormatRuleString(currentRules);
+    return true;
+}
+
+bool LifeContext::StartRecording(const std::filesystem::path& path) {
+    StopPlayback();
+
+    if (!recorder.Open(path, textureSize, textureSize)) {
+        return false;
+    }
+    recordGrid.Resize(textureSize, textureSize);
+    LOGI << "Recording to " << path.string();
+
+    // Generation on the screen is the first frame, or the first generation once it is initialized
+    if (!needDataInit) {
+        RecordGeneration();
+    }
+    return true;
+}
+
+void LifeContext::StopRecording() {
+    if (!recorder.IsOpen()) {
+        return;
+    }
+
+    generationReadback.Flush(generationConsumer);
+
+    LOGI << "Recorded " << recorder.GetFrameCount() << " frames, "
+        << recorder.GetBytesWritten() / (1024.0 * 1024.0) << " MB";
+    recorder.Close();
+}
+
+void LifeContext::RecordGeneration() {
+    // Generations read back a few frames ago are ready by now
+    generationReadback.Poll(generationConsumer);
+
+    // Wait for the oldest read only if the GPU falls that much behind
+    const GLuint framebuffer = generations.GetFramebuffer();
+    if (!generationReadback.Request(framebuffer, textureSize, textureSize, GL_RED, GL_UNSIGNED_BYTE,
+            generationCounter)) {
+        generationReadback.Poll(generationConsumer, true);
+        generationReadback.Request(framebuffer, textureSize, textureSize, GL_RED, GL_UNSIGNED_BYTE,
+            generationCounter);
+    }
+}
+
+void LifeContext::ConsumeGeneration(const void* data, size_t size, uint64_t generation) {
+    if (!recorder.IsOpen() || size != static_cast<size_t>(recordGrid.GetWidth()) * recordGrid.GetHeight()) {
+        return;
+    }
+
+    recordGrid.Pack(static_cast<const uint8_t*>(data));
+    if (!recorder.Append(generation, recordGrid)) {
+        recorder.Close();
+    }
+}
+
+bool LifeContext::StartCapture() {
+    auto format = capturePng ? GraphicsUtils::ImageFormat::Png : GraphicsUtils::ImageFormat::Pnm;
+    return frameCapture.Start(captureDir, format);
+}
+
+void LifeContext::CaptureFrame() {
+    if (captureState) {
+        frameCapture.Capture(generations.GetFramebuffer(), textureSize, textureSize, 1);
+        return;
+    }
+
+    // Back buffer of the frame being finished, with the UI
+    int framebufferWidth = 0, framebufferHeight = 0;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    frameCapture.Capture(0, framebufferWidth, framebufferHeight, 3);
+}
+
+bool LifeContext::StartPlayback(const std::filesystem::path& path) {
+    StopRecording();
+
+    if (!player.Open(path)) {
+        LOGE << "Unable to play " << path.string();
+        return false;
+    }
+    if (player.GetWidth() != player.GetHeight()) {
+        LOGE << "Recorded model is not square : " << player.GetWidth() << "x" << player.GetHeight();
+        player.Close();
+        return false;
+    }
+
+    LOGI << "Playing " << path.string() << " : generations " << player.GetFirstGeneration() << ".."
+        << player.GetLastGeneration();
+
+    if (player.GetWidth() != textureSize) {
+        SetModelSize(player.GetWidth());
+    }
+
+    playbackPaused = false;
+    SeekPlayback(player.GetFirstGeneration());
+    return true;
+}
+
+void LifeContext::StopPlayback() {
+    player.Close();
+    cpuEngineStale = true;
+}
+
+void LifeContext::SeekPlayback(uint64_t generation) {
+    if (!player.Seek(generation, playbackGrid)) {
+        StopPlayback();
+        return;
+    }
+
+    UploadGeneration(playbackGrid);
+    generationCounter = player.GetGeneration();
+    needDataInit = false;
+}
+
+void LifeContext::AdvancePlayback() {
+    // Frames in between are decoded but not uploaded
+    int frames = 0;
+    while (frames < gensPerFrame && player.Next(playbackGrid)) {
+        frames++;
+    }
+
+    if (frames == 0) {
+        playbackPaused = true;
+        return;
+    }
+
+    UploadGeneration(playbackGrid);
+    generationCounter = player.GetGeneration();
+    gensCounter += frames;
+}
+
+bool LifeContext::OpenFile(const std::filesystem::path& path) {
+    if (path.extension() == SnapshotExtension) {
+        return RestoreSnapshot(path);
+    }
+    if (path.extension() == RecordingExtension) {
+        return StartPlayback(path);
+    }
+    return LoadPattern(path);
+}
+
+bool LifeContext::SaveFile(const std::filesystem::path& path) {
+    if (path.extension() == SnapshotExtension) {
+        return SaveSnapshot(path);
+    }
+    if (path.extension() == RecordingExtension) {
+        return StartRecording(path);
+    }
+    return SavePattern(path);
 }
 
 void LifeContext::SetModelSize(int newSize) {
@@ -214,6 +779,8 @@ void LifeContext::SetModelSize(int newSize) {
     automataRenderer.Resize(textureSize, textureSize);
     automataInitialRenderer.Resize(textureSize, textureSize);
 
+    screenRenderer.SetTexture(generations.GetTexture());
+
     NeedDataInit();
 }
 
@@ -237,6 +804,8 @@ void LifeContext::RegisterCallbacks() {
 
     glfwSetMouseButtonCallback(window, LifeContext::MouseCallback);
     glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, GLFW_TRUE);
+
+    glfwSetDropCallback(window, LifeContext::DropCallback);
 }
 
 void LifeContext::Reshape(int newWidth, int newHeight) {
@@ -253,16 +822,29 @@ void LifeContext::Reshape(int newWidth, int newHeight) {
 }
 
 void LifeContext::ReleaseTextures() {
-    currentGenerationTex.reset();
-    nextGenerationTex.reset();
+    // Reads in flight still belong to the textures being released
+    generationReadback.Flush(generationConsumer);
+    generationReadback.Release();
+
+    populationCounter.Release();
+    generations.Release();
 }
 
 void LifeContext::Update() {
     double currentTime = glfwGetTime();
 
+    // Before the generation on the screen is replaced
+    if (frameCapture.IsCapturing()) {
+        CaptureFrame();
+    }
+
     // Update FPS counter every second
     if (currentTime - lastFpsTime > 1.0) {
         gensPerSec = gensCounter;
+
+        const auto& readbackStats = generationReadback.GetStats();
+        readbackMBPerSec = static_cast<float>((readbackStats.bytes - lastReadbackBytes) / (1024.0 * 1024.0));
+        lastReadbackBytes = readbackStats.bytes;
         fps = ImGui::GetIO().Framerate;
         lastFpsTime = currentTime;
         gensCounter = 0;
@@ -276,21 +858,375 @@ void LifeContext::Update() {
         this->MouseDown(x, y);
     }
 
-    if (needDataInit) {
+    if (ensembleMode) {
+        StepEnsemble();
+    }
+    else if (tiledMode) {
+        StepTiledGrid();
+    }
+    else if (player.IsOpen()) {
+        if (!playbackPaused) {
+            AdvancePlayback();
+            CountPopulation();
+        }
+    }
+    else if (needDataInit) {
         InitFirstGeneration();
         needDataInit = false;
+        gensCounter++;
+        CountPopulation();
+
+        if (recorder.IsOpen()) {
+            RecordGeneration();
+        }
+    }
+    else {
+        int steps = gensPerFrame;
+        if (simulateOnCpu) {
+            steps = unboundedPlane ? StepOnPlane() : StepOnCpu();
+        }
+        else {
+            // Every framebuffer of the ring is prebuilt, so each step is just a draw call
+            for (int i = 0; i < gensPerFrame; i++) {
+                CalcNextGeneration();
+                CountPopulation();
+            }
+        }
+        gensCounter += steps;
+
+        // Stable cells are not recorded again
+        if (steps > 0 && recorder.IsOpen()) {
+            RecordGeneration();
+        }
+
+        if (snapshotInterval > 0 && !snapshotPath.empty() &&
+                generationCounter - lastSnapshotGeneration >= snapshotInterval) {
+            SaveSnapshot(snapshotPath);
+        }
+    }
+
+    if (ensembleMode) {
+        screenRenderer.SetTexture(ensembleAtlas.GetTexture());
+    }
+    else if (tiledMode) {
+        screenRenderer.SetTexture(tiledGrid.GetOverviewTexture());
     }
     else {
-        CalcNextGeneration();
+        screenRenderer.SetTexture(generations.GetTexture());
+    }
+}
+
+void LifeContext::CountPopulation() {
+    populationCounter.Poll([this](uint64_t generation, uint64_t count) { AddPopulation(generation, count); });
+    populationCounter.Count(generations.GetTexture(), generationCounter);
+}
+
+void LifeContext::AddPopulation(uint64_t /*generation*/, uint64_t count) {
+    population = count;
+    populationHistory.Push(static_cast<float>(count));
+}
+
+void LifeContext::ClearStatsHistory() {
+    population = 0;
+    cpuStats = CellularAutomata::GenerationStats();
+
+    populationHistory.Clear();
+    birthsHistory.Clear();
+    deathsHistory.Clear();
+}
+
+int LifeContext::StepOnCpu() {
+    if (cpuEngineStale) {
+        CellularAutomata::BitGrid grid;
+        DownloadGeneration(grid);
+        cpuEngine.Load(grid, generationCounter);
+        cpuEngineStale = false;
+        periodDetector.Reset(maxStablePeriod);
+    }
+
+    // Other rules make other cycles
+    const auto& rules = cpuEngine.GetRules();
+    if (rules.birth != currentRules.birth || rules.survive != currentRules.survive) {
+        cpuEngine.SetRules(currentRules);
+        periodDetector.Reset();
+    }
+
+    if (needSetActivity) {
+        DrawActivity(cpuEngine.EditGrid());
+        needSetActivity = false;
+        periodDetector.Reset();
+    }
+
+    if (stopWhenStable && periodDetector.IsStable()) {
+        return 0;
     }
 
-    // Move to the next generation
-    SwapGenerations();
-    gensCounter++;
+    // Counters and hash come from the step itself, no extra pass over the grid
+    int steps = 0;
+    while (steps < gensPerFrame) {
+        cpuEngine.Step();
+        steps++;
+
+        cpuStats = cpuEngine.GetStats();
+        AddPopulation(cpuEngine.GetGeneration(), cpuStats.population);
+        birthsHistory.Push(static_cast<float>(cpuStats.births));
+        deathsHistory.Push(static_cast<float>(cpuStats.deaths));
+
+        if (stopWhenStable && periodDetector.Observe(cpuEngine)) {
+            LOGI << "Stable with period " << periodDetector.GetPeriod() << " since generation "
+                << periodDetector.GetStableGeneration() << ", stopped at generation " << cpuEngine.GetGeneration();
+            break;
+        }
+    }
+
+    UploadGeneration(cpuEngine.GetGrid());
+    generationCounter = cpuEngine.GetGeneration();
+
+    if (countObjects) {
+        CountObjects(cpuEngine.GetGrid(), true);
+    }
+
+    return steps;
+}
+
+int LifeContext::StepOnPlane() {
+    // The model becomes the window at the origin of the plane
+    if (cpuEngineStale) {
+        CellularAutomata::BitGrid grid;
+        DownloadGeneration(grid);
+        planeEngine.Load(grid, 0, 0, generationCounter);
+        planeViewX = 0;
+        planeViewY = 0;
+        cpuEngineStale = false;
+    }
+
+    const auto& rules = planeEngine.GetRules();
+    if (rules.birth != currentRules.birth || rules.survive != currentRules.survive) {
+        planeEngine.SetRules(currentRules);
+    }
+
+    if (needSetActivity) {
+        CellularAutomata::BitGrid activity(textureSize, textureSize);
+        DrawActivity(activity);
+        for (int y = 0; y < activity.GetHeight(); y++) {
+            for (int x = 0; x < activity.GetWidth(); x++) {
+                if (activity.Get(x, y)) {
+                    planeEngine.Set(planeViewX + x, planeViewY + y, true);
+                }
+            }
+        }
+        needSetActivity = false;
+    }
+
+    for (int i = 0; i < gensPerFrame; i++) {
+        planeEngine.Step();
+
+        cpuStats = planeEngine.GetStats();
+        AddPopulation(planeEngine.GetGeneration(), cpuStats.population);
+        birthsHistory.Push(static_cast<float>(cpuStats.births));
+        deathsHistory.Push(static_cast<float>(cpuStats.deaths));
+    }
+
+    planeView.Resize(textureSize, textureSize);
+    planeEngine.Store(planeViewX, planeViewY, planeView);
+    UploadGeneration(planeView);
+    generationCounter = planeEngine.GetGeneration();
+
+    if (countObjects) {
+        // Objects on the opposite edges of the window aren't joined
+        CountObjects(planeView, false);
+    }
+
+    return gensPerFrame;
+}
+
+void LifeContext::CenterPlaneView() {
+    int64_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (!planeEngine.GetBounds(x0, y0, x1, y1)) {
+        return;
+    }
+
+    planeViewX = (x0 + x1) / 2 - textureSize / 2;
+    planeViewY = (y0 + y1) / 2 - textureSize / 2;
+    planeEngine.Store(planeViewX, planeViewY, planeView);
+    UploadGeneration(planeView);
+}
+
+void LifeContext::FastForwardStable(uint64_t generations) {
+    if (!periodDetector.IsStable()) {
+        return;
+    }
+
+    cpuEngine.FastForward(cpuEngine.GetGeneration() + generations, periodDetector.GetPeriod());
+    UploadGeneration(cpuEngine.GetGrid());
+    generationCounter = cpuEngine.GetGeneration();
+
+    LOGI << "Fast-forwarded to generation " << generationCounter;
+}
+
+void LifeContext::CountObjects(const CellularAutomata::BitGrid& grid, bool wrap) {
+    objectCount = objectLabeller.Label(grid, 0, wrap);
+
+    largestObject = CellularAutomata::Component();
+    for (const auto& c : objectLabeller.GetComponents()) {
+        if (c.size > largestObject.size) {
+            largestObject = c;
+        }
+    }
+}
+
+bool LifeContext::StartEnsemble(size_t count) {
+    if (tiledMode) {
+        StopTiledGrid();
+    }
+
+    ensembleEngine.Resize(count);
+    if (!ensembleAtlas.Resize(texturePool, count)) {
+        LOGE << "Failed to start the ensemble of " << count << " universes";
+        ensembleMode = false;
+        return false;
+    }
+
+    ensembleCount = static_cast<int>(count);
+    ensembleMode = true;
+    InitEnsemble();
+    return true;
+}
+
+void LifeContext::StopEnsemble() {
+    ensembleAtlas.Release();
+    ensembleEngine.Resize(0);
+    ensembleMode = false;
+}
+
+void LifeContext::InitEnsemble() {
+    if (randomizeSeed) {
+        seed = std::random_device{}();
+    }
+    LOGI << "Ensemble seed : " << seed;
+
+    // Universe u starts as the 64x64 model with the seed + u
+    ensembleEngine.SetRules(currentRules);
+    ensembleEngine.Randomize(seed, density);
+    ensembleAtlas.Upload(ensembleEngine);
+    ensembleAtlas.Discard();
+
+    ensembleHashes.assign(ensembleEngine.GetCount(), 0);
+    AddEnsembleStats(0, ensembleEngine.GetStats());
+}
+
+void LifeContext::StepEnsemble() {
+    needSetActivity = false;
+
+    if (needDataInit) {
+        InitEnsemble();
+        needDataInit = false;
+        return;
+    }
+
+    // The CPU ensemble is uploaded once per frame, its counters are ready at once
+    if (simulateOnCpu) {
+        for (int i = 0; i < gensPerFrame; i++) {
+            ensembleEngine.Step();
+        }
+        ensembleAtlas.Upload(ensembleEngine);
+        AddEnsembleStats(ensembleEngine.GetGeneration(), ensembleEngine.GetStats());
+    }
+    else {
+        for (int i = 0; i < gensPerFrame; i++) {
+            ensembleAtlas.Step();
+        }
+        ensembleAtlas.Poll(ensembleConsumer);
+        ensembleAtlas.RequestStats();
+    }
+    gensCounter += gensPerFrame;
+}
+
+void LifeContext::AddEnsembleStats(uint64_t generation, const std::vector<CellularAutomata::GenerationStats>& stats) {
+    ensembleGeneration = generation;
+    ensemblePopulation = 0;
+    ensembleAlive = 0;
+    ensembleChanged = 0;
+
+    for (size_t u = 0; u < stats.size() && u < ensembleHashes.size(); u++) {
+        ensemblePopulation += stats[u].population;
+        ensembleAlive += (stats[u].population > 0) ? 1 : 0;
+        ensembleChanged += (stats[u].hash != ensembleHashes[u]) ? 1 : 0;
+        ensembleHashes[u] = stats[u].hash;
+    }
+}
+
+bool LifeContext::StartTiledGrid(int newWidth, int newHeight) {
+    if (ensembleMode) {
+        StopEnsemble();
+    }
+
+    if (!tiledGrid.Resize(texturePool, newWidth, newHeight)) {
+        LOGE << "Failed to start the tiled grid " << newWidth << "x" << newHeight;
+        StopTiledGrid();
+        return false;
+    }
+
+    tiledWidth = newWidth;
+    tiledHeight = newHeight;
+    tiledMode = true;
+    NeedDataInit();
+    return true;
+}
+
+void LifeContext::StopTiledGrid() {
+    tiledGrid.Release();
+    tiledMode = false;
+
+    // Tiles of this size are unlikely to be reused, unlike the model textures
+    texturePool.Trim();
+}
+
+void LifeContext::StepTiledGrid() {
+    tiledGrid.SetRules(currentRules);
+
+    if (needDataInit) {
+        if (randomizeSeed) {
+            seed = std::random_device{}();
+        }
+        LOGI << "Tiled grid seed : " << seed;
+
+        tiledGrid.Generate(firstGenerationType, seed, density);
+        needDataInit = false;
+        gensCounter++;
+    }
+    else {
+        for (int i = 0; i < gensPerFrame; i++) {
+            tiledGrid.Step();
+        }
+        gensCounter += gensPerFrame;
+    }
+
+    tiledGrid.UpdateOverview();
+}
+
+void LifeContext::DrawActivity(CellularAutomata::BitGrid& grid) {
+    const float radius = ActivityRadius * textureSize;
+    const float cx = activityPos.X * textureSize;
+    const float cy = activityPos.Y * textureSize;
+
+    const int y0 = std::max(static_cast<int>(cy - radius), 0);
+    const int y1 = std::min(static_cast<int>(cy + radius) + 1, grid.GetHeight() - 1);
+    for (int y = y0; y <= y1; y++) {
+        const float dy = y + 0.5f - cy;
+        const float dx = std::sqrt(std::max(radius * radius - dy * dy, 0.0f));
+        const int x0 = std::max(static_cast<int>(std::ceil(cx - dx - 0.5f)), 0);
+        const int x1 = std::min(static_cast<int>(std::floor(cx + dx - 0.5f)) + 1, grid.GetWidth());
+        if (dy * dy < radius * radius && x0 < x1) {
+            grid.SetRange(x0, x1, y);
+        }
+    }
 }
 
 void LifeContext::CalcNextGeneration() {
-    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(frameBuffer)); LOGOPENGLERROR();
+    automataRenderer.SetTexture(generations.GetTexture());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, generations.GetNextFramebuffer()); LOGOPENGLERROR();
 
     glUseProgram(static_cast<GLuint>(automataProgram)); LOGOPENGLERROR();
     glUniform1i(uRulesBirth, currentRules.birth); LOGOPENGLERROR();
@@ -310,23 +1246,10 @@ void LifeContext::CalcNextGeneration() {
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
 
+    generations.Advance();
     generationCounter++;
 }
 
-void LifeContext::SwapGenerations() {
-    // Swap IDs
-    nextGenerationTex.swap(currentGenerationTex);
-
-    // Swap IDs in the renderer objects
-    automataRenderer.SetTexture(static_cast<GLuint>(currentGenerationTex));
-
-    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(frameBuffer)); LOGOPENGLERROR();
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, static_cast<GLuint>(nextGenerationTex), 0); LOGOPENGLERROR();
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
-
-    screenRenderer.SetTexture(static_cast<GLuint>(nextGenerationTex));
-}
-
 void LifeContext::Display() {
     glClear(GL_COLOR_BUFFER_BIT); LOGOPENGLERROR();
 
@@ -400,17 +1323,217 @@ void LifeContext::DisplayUi() {
         }
     }
 
+    if (ImGui::SliderFloat("Density", &density, 0.0f, 1.0f, "%.2f")) {
+        NeedDataInit();
+    }
+
+    int iSeed = static_cast<int>(seed);
+    if (ImGui::InputInt("Seed", &iSeed)) {
+        seed = static_cast<uint32_t>(iSeed);
+        randomizeSeed = false;
+        NeedDataInit();
+    }
+    ImGui::Checkbox("New seed on restart", &randomizeSeed);
+    ImGui::Checkbox("Generate on CPU", &generateOnCpu);
+    if (ImGui::Checkbox("Simulate on CPU", &simulateOnCpu)) {
+        cpuEngineStale = true;
+        populationCounter.Discard();
+        ClearStatsHistory();
+
+        // The GPU and CPU ensembles don't follow each other
+        if (ensembleMode) {
+            NeedDataInit();
+        }
+    }
+    if (simulateOnCpu) {
+        if (ImGui::Checkbox("Unbounded plane", &unboundedPlane)) {
+            cpuEngineStale = true;
+        }
+        if (unboundedPlane) {
+            ImGui::Text("Chunks: %zu, %.1f MB", planeEngine.GetChunkCount(),
+                planeEngine.GetMemoryUsage() / (1024.0 * 1024.0));
+            ImGui::Text("View: %lld, %lld", static_cast<long long>(planeViewX), static_cast<long long>(planeViewY));
+            if (ImGui::Button("Center view")) {
+                CenterPlaneView();
+            }
+        }
+    }
+    if (simulateOnCpu && !unboundedPlane) {
+        bool detectorChanged = ImGui::Checkbox("Stop when stable", &stopWhenStable);
+        detectorChanged |= ImGui::SliderInt("Max period", &maxStablePeriod, 1, MaxStablePeriodLimit);
+        if (detectorChanged) {
+            periodDetector.Reset(maxStablePeriod);
+        }
+
+        if (stopWhenStable && periodDetector.IsStable()) {
+            ImGui::Text("Period %u since gen. %llu", periodDetector.GetPeriod(),
+                static_cast<unsigned long long>(periodDetector.GetStableGeneration()));
+            if (ImGui::Button("Skip 1M generations")) {
+                FastForwardStable(FastForwardGenerations);
+            }
+        }
+    }
+    if (simulateOnCpu) {
+        if (ImGui::Checkbox("Count objects", &countObjects) && countObjects) {
+            CountObjects(unboundedPlane ? planeView : cpuEngine.GetGrid(), !unboundedPlane);
+        }
+        if (countObjects) {
+            ImGui::Text("Objects: %zu", objectCount);
+            ImGui::Text("Largest: %llu cells, %dx%d", static_cast<unsigned long long>(largestObject.size),
+                largestObject.width, largestObject.height);
+        }
+    }
+
+    bool showEnsemble = ensembleMode;
+    if (ImGui::Checkbox("Ensemble of 64x64 universes", &showEnsemble)) {
+        if (showEnsemble) {
+            StartEnsemble(static_cast<size_t>(ensembleCount > 0 ? ensembleCount : DefaultEnsembleCount));
+        }
+        else {
+            StopEnsemble();
+        }
+    }
+    if (ensembleMode) {
+        int count = ensembleCount;
+        if (ImGui::InputInt("Universes", &count, 256, 1024)) {
+            count = std::clamp(count, 1, MaxEnsembleCount);
+            // Keep the previous ensemble if the atlas doesn't fit
+            if (!StartEnsemble(static_cast<size_t>(count))) {
+                StartEnsemble(static_cast<size_t>(ensembleCount));
+            }
+        }
+        ImGui::Text("Ensemble gen.: %llu", static_cast<unsigned long long>(ensembleGeneration));
+        ImGui::Text("Alive: %zu, evolving: %zu", ensembleAlive, ensembleChanged);
+        ImGui::Text("Mean population: %.1f",
+            ensembleCount > 0 ? static_cast<double>(ensemblePopulation) / ensembleCount : 0.0);
+    }
+
+    if (ImGui::CollapsingHeader("Large grid")) {
+        ImGui::InputInt("Width", &tiledWidth, 1024, 8192);
+        ImGui::InputInt("Height", &tiledHeight, 1024, 8192);
+        tiledWidth = std::clamp(tiledWidth, 1, TiledGrid::MaxSize);
+        tiledHeight = std::clamp(tiledHeight, 1, TiledGrid::MaxSize);
+
+        // Shown before allocating, the driver may fail or swap on grids beyond the video memory
+        const auto layout = TiledGrid::GetLayout(tiledWidth, tiledHeight, TiledGrid::GetMaxTextureSize());
+        ImGui::Text("%dx%d tiles of %dx%d", layout.columns, layout.rows, layout.tileWidth, layout.tileHeight);
+        ImGui::Text("Textures: %.1f MB", layout.textureBytes / (1024.0 * 1024.0));
+
+        if (ImGui::Button(tiledMode ? "Reallocate" : "Allocate")) {
+            StartTiledGrid(tiledWidth, tiledHeight);
+        }
+        if (tiledMode) {
+            ImGui::SameLine();
+            if (ImGui::Button("Release")) {
+                StopTiledGrid();
+            }
+            ImGui::Text("Grid gen.: %llu", static_cast<unsigned long long>(tiledGrid.GetGeneration()));
+        }
+    }
+
+    ImGui::InputText("##PatternPath", patternPathInput.data(), patternPathInput.size());
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+        OpenFile(patternPathInput.data());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
+        SaveFile(patternPathInput.data());
+    }
+
     ImGui::Separator();
 
     ImGui::Text("User Guide:");
     ImGui::BulletText("F1 to on/off fullscreen mode.");
     ImGui::BulletText("RMB/Space to Clear model.");
+    ImGui::BulletText("Drop RLE, .cells, .mc, .snap or .rec file to load.");
+    ImGui::BulletText("Save writes .mc or .snap file, or records to .rec file.");
 
     ImGui::Separator();
 
-    ImGui::Text("Generation no.: %d", generationCounter);
+    ImGui::Text("Generation no.: %llu", static_cast<unsigned long long>(generationCounter));
     ImGui::Text("Gens/sec: %.1f", gensPerSec);
 
+    const ImVec2 plotSize(UiWidth - 20.0f, 50.0f);
+    ImGui::Text("Population: %llu", static_cast<unsigned long long>(population));
+    populationHistory.Plot("##Population", plotSize);
+
+    // Births and deaths are maintained by the CPU engine only
+    if (simulateOnCpu && !player.IsOpen()) {
+        ImGui::Text("Births: %llu", static_cast<unsigned long long>(cpuStats.births));
+        birthsHistory.Plot("##Births", plotSize);
+        ImGui::Text("Deaths: %llu", static_cast<unsigned long long>(cpuStats.deaths));
+        deathsHistory.Plot("##Deaths", plotSize);
+    }
+
+    ImGui::Text("Gens/frame:");
+    ImGui::SliderInt("##GensPerFrame", &gensPerFrame, 1, MaxGensPerFrame);
+    ImGui::Text("Resident generations: %d", static_cast<int>(generations.GetHistorySize()));
+
+    const auto& poolStats = texturePool.GetStats();
+    ImGui::Text("Textures: %d allocated, %d reused",
+        static_cast<int>(poolStats.allocated), static_cast<int>(poolStats.reused));
+    ImGui::Text("Texture memory: %.1f MB", poolStats.bytes / (1024.0 * 1024.0));
+
+    const auto& readbackStats = generationReadback.GetStats();
+    ImGui::Text("Readback: %.2f ms, %.1f MB/s", readbackStats.latencyMs, readbackMBPerSec);
+
+    if (recorder.IsOpen()) {
+        ImGui::Separator();
+        ImGui::Text("Recording: %llu frames, %.1f MB", static_cast<unsigned long long>(recorder.GetFrameCount()),
+            recorder.GetBytesWritten() / (1024.0 * 1024.0));
+        if (ImGui::Button("Stop recording")) {
+            StopRecording();
+        }
+    }
+
+    if (player.IsOpen()) {
+        ImGui::Separator();
+        ImGui::Text("Playback:");
+
+        uint64_t position = player.GetGeneration();
+        const uint64_t first = player.GetFirstGeneration();
+        const uint64_t last = player.GetLastGeneration();
+        if (ImGui::SliderScalar("##Playback", ImGuiDataType_U64, &position, &first, &last)) {
+            SeekPlayback(position);
+        }
+        ImGui::Checkbox("Pause", &playbackPaused);
+        ImGui::SameLine();
+        if (ImGui::Button("Stop playback")) {
+            StopPlayback();
+        }
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Capture:");
+    if (!frameCapture.IsCapturing()) {
+        if (ImGui::RadioButton("Window", !captureState)) {
+            captureState = false;
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Model", captureState)) {
+            captureState = true;
+        }
+        if (ImGui::RadioButton("PNG", capturePng)) {
+            capturePng = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("PPM", !capturePng)) {
+            capturePng = false;
+        }
+        if (ImGui::Button("Start capture")) {
+            StartCapture();
+        }
+    }
+    else if (ImGui::Button("Stop capture")) {
+        frameCapture.Stop();
+    }
+
+    const auto captureStats = frameCapture.GetStats();
+    ImGui::Text("Frames: %llu written, %llu dropped", static_cast<unsigned long long>(captureStats.written),
+        static_cast<unsigned long long>(captureStats.dropped));
+    ImGui::Text("Queued frames: %d", static_cast<int>(captureStats.queued));
+
     ImGui::Separator();
 
     ImGui::Text("FPS Counter : %.1f", fps);
@@ -511,6 +1634,12 @@ void LifeContext::Mouse(int button, int action, int /*mods*/) {
     }
 }
 
+void LifeContext::Drop(int count, const char* paths[]) {
+    if (count > 0) {
+        OpenFile(paths[0]);
+    }
+}
+
 void LifeContext::ReshapeCallback(GLFWwindow* window, int width, int height) {
     auto context = static_cast<LifeContext *>(glfwGetWindowUserPointer(window));
     assert(context);
@@ -531,3 +1660,10 @@ void LifeContext::MouseCallback(GLFWwindow* window, int button, int action, int
 
     context->Mouse(button, action, mods);
 }
+
+void LifeContext::DropCallback(GLFWwindow* window, int count, const char* paths[]) {
+    auto context = static_cast<LifeContext *>(glfwGetWindowUserPointer(window));
+    assert(context);
+
+    context->Drop(count, paths);
+}
@@ -22,10 +22,12 @@ public:
     void Reshape(int width, int height);
     void Keyboard(int key, int /*scancode*/, int action, int /*mods*/);
     void Mouse(int button, int action, int /*mods*/);
+    void Drop(int count, const char* paths[]);
 
     static void ReshapeCallback(GLFWwindow* window, int width, int height);
     static void KeyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
     static void MouseCallback(GLFWwindow* window, int button, int action, int mods);
+    static void DropCallback(GLFWwindow* window, int count, const char* paths[]);
 
 private:
     bool InitTextures(int newSize);
@@ -33,7 +35,54 @@ private:
 
     void InitFirstGeneration();
     void CalcNextGeneration();
-    void SwapGenerations();
+    void CountPopulation();
+    void AddPopulation(uint64_t generation, uint64_t population);
+    void ClearStatsHistory();
+
+    // Returns the number of generations stepped, none once the cells are stable
+    int StepOnCpu();
+    void FastForwardStable(uint64_t generations);
+    void CountObjects(const CellularAutomata::BitGrid& grid, bool wrap);
+    int StepOnPlane();
+    void CenterPlaneView();
+    void DrawActivity(CellularAutomata::BitGrid& grid);
+
+    bool StartEnsemble(size_t count);
+    void StopEnsemble();
+    void InitEnsemble();
+    void StepEnsemble();
+    void AddEnsembleStats(uint64_t generation, const std::vector<CellularAutomata::GenerationStats>& stats);
+
+    bool StartTiledGrid(int newWidth, int newHeight);
+    void StopTiledGrid();
+    void StepTiledGrid();
+
+    void UploadGeneration(const CellularAutomata::BitGrid& grid);
+    void DownloadGeneration(CellularAutomata::BitGrid& grid);
+
+    bool LoadPattern(const std::filesystem::path& path);
+    bool DecodePatternFile();
+    bool SavePattern(const std::filesystem::path& path);
+
+    bool SaveSnapshot(const std::filesystem::path& path);
+    bool RestoreSnapshot(const std::filesystem::path& path);
+
+    bool StartRecording(const std::filesystem::path& path);
+    void StopRecording();
+    void RecordGeneration();
+    void ConsumeGeneration(const void* data, size_t size, uint64_t generation);
+
+    bool StartCapture();
+    void CaptureFrame();
+
+    bool StartPlayback(const std::filesystem::path& path);
+    void StopPlayback();
+    void SeekPlayback(uint64_t generation);
+    void AdvancePlayback();
+
+    // Snapshots, recordings and patterns are told apart by the extension
+    bool OpenFile(const std::filesystem::path& path);
+    bool SaveFile(const std::filesystem::path& path);
 
     void DisplayUi();
 
@@ -43,6 +92,8 @@ private:
 
     void RegisterCallbacks();
 
+    GLuint CreateProgram(const std::filesystem::path& vertexShader, const std::filesystem::path& fragmentShader);
+
 private:
     GLFWwindow* window = nullptr;
 
@@ -50,14 +101,27 @@ private:
     int width = 0, height = 0;
     WindowDimensions savedWindowPos = { 0, 0, 0, 0 };
 
-    int generationCounter = 0;
+    uint64_t generationCounter = 0;
     float fps = 0.0;
     float gensPerSec = 0.0;
 
     int textureSize = 0;
 
-    GraphicsUtils::unique_texture currentGenerationTex;
-    GraphicsUtils::unique_texture nextGenerationTex;
+    // Load shaders from files instead of the embedded ones
+    std::filesystem::path shaderOverrideDir;
+
+    // Keeps textures of every model size used so far, must outlive the ring
+    GraphicsUtils::TexturePool texturePool;
+
+    // Latest generation is the head of the ring, older ones stay resident
+    GraphicsUtils::RenderTargetRing generations;
+    int gensPerFrame = 1;
+
+    // Generations for the CPU are read back without stalling the GPU
+    GraphicsUtils::AsyncReadback generationReadback;
+    GraphicsUtils::AsyncReadback::Consumer generationConsumer;
+    float readbackMBPerSec = 0.0f;
+    uint64_t lastReadbackBytes = 0;
 
     GraphicsUtils::unique_program automataProgram;
     GLint uRulesBirth = -1, uRulesSurvive = -1;
@@ -65,13 +129,66 @@ private:
     PlanarTextureRenderer automataRenderer;
 
     GraphicsUtils::unique_program automataInitProgram;
-    GLint uInitType = -1;
+    GLint uInitType = -1, uInitSeed = -1, uInitDensityThreshold = -1;
     PlanarTextureRenderer automataInitialRenderer;
 
     GraphicsUtils::unique_program screenProgram;
     PlanarTextureRenderer screenRenderer;
 
-    GraphicsUtils::unique_framebuffer frameBuffer;
+    // Population of every generation is reduced on the GPU and read back a few frames later
+    GraphicsUtils::unique_program populationFirstProgram, populationReduceProgram;
+    PopulationCounter populationCounter;
+    uint64_t population = 0;
+    HistoryRing populationHistory;
+
+    // Generations are stepped by the CPU engine and uploaded once per frame.
+    // The engine takes the texture over when the generation was changed elsewhere.
+    bool simulateOnCpu = false;
+    bool cpuEngineStale = true;
+    CellularAutomata::LifeEngine cpuEngine;
+    CellularAutomata::GenerationStats cpuStats;
+    HistoryRing birthsHistory;
+    HistoryRing deathsHistory;
+
+    // Stepping stops when the cells repeat with a period up to maxStablePeriod
+    bool stopWhenStable = false;
+    int maxStablePeriod = 16;
+    CellularAutomata::PeriodDetector periodDetector;
+
+    // Connected groups of cells of the CPU generation, labelled once per frame
+    bool countObjects = false;
+    CellularAutomata::ComponentLabeller objectLabeller;
+    size_t objectCount = 0;
+    CellularAutomata::Component largestObject;
+
+    // The CPU engine runs on the unbounded plane, the model shows a window of it
+    bool unboundedPlane = false;
+    CellularAutomata::PlaneEngine planeEngine;
+    CellularAutomata::BitGrid planeView;
+    int64_t planeViewX = 0;
+    int64_t planeViewY = 0;
+
+    // Independent 64x64 universes shown as an atlas instead of the model, stepped on the GPU
+    // or with the CPU ensemble engine. Rules, seed and density are shared with the model.
+    bool ensembleMode = false;
+    int ensembleCount = 0;
+    GraphicsUtils::unique_program ensembleStepProgram, ensembleStatsProgram;
+    EnsembleAtlas ensembleAtlas;
+    CellularAutomata::EnsembleEngine ensembleEngine;
+    EnsembleAtlas::Consumer ensembleConsumer;
+    uint64_t ensembleGeneration = 0;
+    uint64_t ensemblePopulation = 0;
+    size_t ensembleAlive = 0;    // Universes with alive cells
+    size_t ensembleChanged = 0;  // Universes whose hash changed since the previous counters
+    std::vector<uint64_t> ensembleHashes;
+
+    // Rectangular grid split over several textures, shown scaled down instead of the model and
+    // stepped on the GPU only. Rules, seed and density are shared with the model.
+    bool tiledMode = false;
+    int tiledWidth = 16384;
+    int tiledHeight = 8192;
+    GraphicsUtils::unique_program tiledStepProgram;
+    TiledGrid tiledGrid;
 
     bool needDataInit = false;
 
@@ -79,6 +196,41 @@ private:
     CellularAutomata::FirstGenerationType firstGenerationType{
         CellularAutomata::FirstGenerationType::Empty };
 
+    // Same seed gives the same first generation on CPU and GPU
+    uint32_t seed = 0;
+    bool randomizeSeed = true;
+    float density = 0.5f;
+
+    bool generateOnCpu = false;
+    CellularAutomata::BitGrid cpuGrid;
+    std::vector<uint8_t> uploadBuffer;
+
+    // Pattern is decoded for the current model size, cells outside of it are clipped
+    std::filesystem::path patternPath;
+    CellularAutomata::BitGrid patternGrid;
+    std::array<char, 512> patternPathInput{};
+    unsigned patternDecodeThreads = 0; // Automatic
+
+    // Restored on start if exists and saved every snapshotInterval generations
+    std::filesystem::path snapshotPath;
+    uint64_t snapshotInterval = 0; // Never
+    uint64_t lastSnapshotGeneration = 0;
+
+    // Every displayed generation is appended while recording
+    CellularAutomata::GenerationRecorder recorder;
+    CellularAutomata::BitGrid recordGrid;
+
+    // Playback replaces the simulation until stopped, which continues it from the shown frame
+    CellularAutomata::GenerationPlayer player;
+    CellularAutomata::BitGrid playbackGrid;
+    bool playbackPaused = false;
+
+    // Image sequence of the window or of the generations
+    GraphicsUtils::FrameCapture frameCapture;
+    std::filesystem::path captureDir = "capture";
+    bool captureState = false;
+    bool capturePng = true;
+
     bool needSetActivity = false;
     HMM_Vec2 activityPos = { 0 };
 
@@ -0,0 +1,124 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "GraphicsResource.h"
+#include "TexturePool.h"
+#include "AsyncReadback.h"
+#include "PlanarTextureRenderer.h"
+#include "PopulationCounter.h"
+
+// Each pass reduces 4x4 texels to one, as in the shaders
+constexpr int ReductionBlockSize = 4;
+
+PopulationCounter::~PopulationCounter() {
+    Release();
+}
+
+bool PopulationCounter::Init(GLuint firstProgram, GLuint reduceProgram, size_t readbackCount) {
+    if (!firstRenderer_.Init(firstProgram) || !reduceRenderer_.Init(reduceProgram)) {
+        LOGE << "Failed to init population count renderers";
+        return false;
+    }
+
+    readbackCount_ = readbackCount;
+    return true;
+}
+
+bool PopulationCounter::Resize(GraphicsUtils::TexturePool& pool, int size) {
+    Release();
+
+    pool_ = &pool;
+
+    if (!readback_.Init(readbackCount_, sizeof(GLuint))) {
+        LOGE << "Failed to init population readback";
+        return false;
+    }
+
+    do {
+        size = (size + ReductionBlockSize - 1) / ReductionBlockSize;
+
+        Level& level = levels_.emplace_back();
+        level.size = size;
+        level.texture = pool_->Acquire(size, size, GL_R32UI);
+        if (!level.texture) {
+            LOGE << "Failed to init population count texture " << size << "x" << size;
+            Release();
+            return false;
+        }
+
+        // Integer textures are incomplete with linear filtering
+        glBindTexture(GL_TEXTURE_2D, level.texture); LOGOPENGLERROR();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); LOGOPENGLERROR();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); LOGOPENGLERROR();
+        glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+        glGenFramebuffers(1, level.framebuffer.put()); LOGOPENGLERROR();
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(level.framebuffer)); LOGOPENGLERROR();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0); LOGOPENGLERROR();
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER); LOGOPENGLERROR();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            LOGE << "Population count framebuffer is incomplete : " << status;
+            Release();
+            return false;
+        }
+    } while (size > 1);
+
+    return true;
+}
+
+void PopulationCounter::Release() {
+    readback_.Release();
+
+    for (auto& level : levels_) {
+        if (level.texture) {
+            pool_->Recycle(level.texture);
+        }
+    }
+    levels_.clear();
+}
+
+bool PopulationCounter::Count(GLuint texture, uint64_t generation) {
+    if (levels_.empty() || readback_.GetPendingCount() == readback_.GetCount()) {
+        return false;
+    }
+
+    GLuint source = texture;
+    for (size_t i = 0; i < levels_.size(); i++) {
+        PlanarTextureRenderer& renderer = (i == 0) ? firstRenderer_ : reduceRenderer_;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(levels_[i].framebuffer)); LOGOPENGLERROR();
+
+        renderer.SetTexture(source);
+        renderer.Resize(levels_[i].size, levels_[i].size);
+        renderer.AdjustViewport();
+        renderer.Render();
+
+        source = levels_[i].texture;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    return readback_.Request(static_cast<GLuint>(levels_.back().framebuffer), 1, 1, GL_RED_INTEGER,
+        GL_UNSIGNED_INT, generation);
+}
+
+void PopulationCounter::Poll(const Consumer& consume) {
+    readback_.Poll([&consume](const void* data, size_t /*size*/, uint64_t generation) {
+        GLuint population = 0;
+        std::memcpy(&population, data, sizeof(population));
+        consume(generation, population);
+    });
+}
+
+void PopulationCounter::Discard() {
+    readback_.Flush([](const void*, size_t, uint64_t) {});
+}
+
+size_t PopulationCounter::GetPassCount() const {
+    return levels_.size();
+}
+
+const GraphicsUtils::AsyncReadback::Stats& PopulationCounter::GetReadbackStats() const {
+    return readback_.GetStats();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Counts alive cells on the GPU. Each pass sums 4x4 blocks into a texture four times
+// smaller, down to a single texel, which is read back a few frames later.
+class PopulationCounter {
+public:
+    using Consumer = std::function<void(uint64_t generation, uint64_t population)>;
+
+public:
+    PopulationCounter() = default;
+    ~PopulationCounter();
+
+    PopulationCounter(PopulationCounter const&) = delete;
+    PopulationCounter& operator=(PopulationCounter const&) = delete;
+
+    // First pass reads the generation, the others reduce the counts
+    bool Init(GLuint firstProgram, GLuint reduceProgram, size_t readbackCount);
+
+    // Build the passes for the model size, textures are taken from the pool
+    bool Resize(GraphicsUtils::TexturePool& pool, int size);
+    void Release();
+
+    // Queue counting of the generation texture, false if every readback is in flight
+    bool Count(GLuint texture, uint64_t generation);
+
+    // Pass the completed counts to the consumer in the generation order
+    void Poll(const Consumer& consume);
+
+    // Forget the counts in flight, e.g. after a restart
+    void Discard();
+
+    size_t GetPassCount() const;
+    const GraphicsUtils::AsyncReadback::Stats& GetReadbackStats() const;
+
+private:
+    struct Level {
+        GLuint texture{ 0 };
+        GraphicsUtils::unique_framebuffer framebuffer;
+        int size{ 0 };
+    };
+
+private:
+    GraphicsUtils::TexturePool* pool_{ nullptr };
+    std::vector<Level> levels_;
+
+    PlanarTextureRenderer firstRenderer_;
+    PlanarTextureRenderer reduceRenderer_;
+
+    GraphicsUtils::AsyncReadback readback_;
+    size_t readbackCount_{ 0 };
+};
@@ -1,38 +1,30 @@
 #include "stdafx.h"
 #include "ResourceFinder.h"
 
-const std::filesystem::path DataDirName = "data";
+const std::filesystem::path CacheDirName = "GameOfLifeGpu";
 
-Utils::ResourceFinder::DirectoryList Utils::ResourceFinder::GetDataDirectoryList(const std::string& argv_path) {
-    const auto current_directory{ std::filesystem::current_path() };
-
-    const auto proc_path = std::filesystem::canonical(argv_path);
-    const auto proc_directory = proc_path.parent_path();
-
-    return Utils::ResourceFinder::DirectoryList{
-        current_directory,
-        proc_directory
-    };
-}
-
-bool Utils::ResourceFinder::LookForDataDir(const Utils::ResourceFinder::DirectoryList& paths_for_lookup,
-        std::filesystem::path& found_path) {
-
-    for (const auto& p : paths_for_lookup) {
-        std::filesystem::path data_path = p / DataDirName;
-        if (std::filesystem::exists(data_path) &&
-            std::filesystem::is_directory(data_path)) {
-            found_path = data_path;
-            return true;
-        }
+std::filesystem::path Utils::ResourceFinder::GetCacheDirectory() {
+#ifdef _WIN32
+    const char* local_app_data = std::getenv("LOCALAPPDATA");
+    if (local_app_data && *local_app_data) {
+        return std::filesystem::path(local_app_data) / CacheDirName;
+    }
+#else
+    const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+    if (xdg_cache_home && *xdg_cache_home) {
+        return std::filesystem::path(xdg_cache_home) / CacheDirName;
     }
 
-    found_path = std::filesystem::path(); // empty path
-    return false;
-}
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::filesystem::path(home) / ".cache" / CacheDirName;
+    }
+#endif
 
-bool Utils::ResourceFinder::GetDataDirectory(const std::string& argv_path,
-        std::filesystem::path& found_path) {
-    auto path_list = Utils::ResourceFinder::GetDataDirectoryList(argv_path);
-    return Utils::ResourceFinder::LookForDataDir(path_list, found_path);
+    std::error_code ec;
+    auto tmp_path = std::filesystem::temp_directory_path(ec);
+    if (ec) {
+        return std::filesystem::path(); // empty path, no cache
+    }
+    return tmp_path / CacheDirName;
 }
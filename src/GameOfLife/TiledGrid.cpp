@@ -0,0 +1,291 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "GraphicsResource.h"
+#include "TexturePool.h"
+#include "RenderTargetRing.h"
+#include "PlanarTextureRenderer.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "RandomGenerator.h"
+#include "TiledGrid.h"
+
+// Cells on each side of a tile copied from the neighbour tiles
+constexpr int TileHalo = 1;
+
+// Larger textures are allowed by some drivers but are slow to allocate and clear
+constexpr int MaxTileTextureSize = 8192;
+
+// Splits a side of the grid into parts of at most maxPart cells, all but the last of the same size
+int GetTilePart(int size, int maxPart) {
+    const int parts = (size + maxPart - 1) / maxPart;
+    return (size + parts - 1) / parts;
+}
+
+void BlitRegion(GLuint source, GLuint target, int sx, int sy, int tx, int ty, int width, int height) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source); LOGOPENGLERROR();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target); LOGOPENGLERROR();
+    glBlitFramebuffer(sx, sy, sx + width, sy + height, tx, ty, tx + width, ty + height,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST); LOGOPENGLERROR();
+}
+
+TiledGrid::~TiledGrid() {
+    Release();
+}
+
+TiledGrid::Layout TiledGrid::GetLayout(int width, int height, int maxTextureSize) {
+    Layout layout;
+    if (width <= 0 || height <= 0 || maxTextureSize <= 2 * TileHalo) {
+        return layout;
+    }
+
+    layout.width = width;
+    layout.height = height;
+    layout.tileWidth = GetTilePart(width, maxTextureSize - 2 * TileHalo);
+    layout.tileHeight = GetTilePart(height, maxTextureSize - 2 * TileHalo);
+    layout.columns = (width + layout.tileWidth - 1) / layout.tileWidth;
+    layout.rows = (height + layout.tileHeight - 1) / layout.tileHeight;
+
+    // Halo of every tile is stored twice, once per generation
+    const size_t textureWidths = static_cast<size_t>(width) + 2 * TileHalo * layout.columns;
+    const size_t textureHeights = static_cast<size_t>(height) + 2 * TileHalo * layout.rows;
+    layout.textureBytes = 2 * textureWidths * textureHeights + static_cast<size_t>(OverviewSize) * OverviewSize;
+
+    return layout;
+}
+
+int TiledGrid::GetMaxTextureSize() {
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize); LOGOPENGLERROR();
+    return std::min(static_cast<int>(maxSize), MaxTileTextureSize);
+}
+
+bool TiledGrid::Init(GLuint stepProgram, GLuint initProgram) {
+    if (!stepRenderer_.Init(stepProgram) || !initRenderer_.Init(initProgram)) {
+        LOGE << "Failed to init tiled grid renderers";
+        return false;
+    }
+
+    stepProgram_ = stepProgram;
+    uRulesBirth_ = glGetUniformLocation(stepProgram, "rules.birth"); LOGOPENGLERROR();
+    uRulesSurvive_ = glGetUniformLocation(stepProgram, "rules.survive"); LOGOPENGLERROR();
+
+    initProgram_ = initProgram;
+    uInitType_ = glGetUniformLocation(initProgram, "initType"); LOGOPENGLERROR();
+    uInitSeed_ = glGetUniformLocation(initProgram, "seed"); LOGOPENGLERROR();
+    uInitDensityThreshold_ = glGetUniformLocation(initProgram, "densityThreshold"); LOGOPENGLERROR();
+    uInitOrigin_ = glGetUniformLocation(initProgram, "origin"); LOGOPENGLERROR();
+
+    return true;
+}
+
+bool TiledGrid::Resize(GraphicsUtils::TexturePool& pool, int width, int height) {
+    Release();
+
+    if (width <= 0 || height <= 0 || width > MaxSize || height > MaxSize) {
+        LOGE << "Tiled grid " << width << "x" << height << " is outside of 1x1 to " << MaxSize << "x" << MaxSize;
+        return false;
+    }
+
+    pool_ = &pool;
+    layout_ = GetLayout(width, height, GetMaxTextureSize());
+    generation_ = 0;
+
+    LOGI << "Tiled grid " << width << "x" << height << " in " << layout_.columns << "x" << layout_.rows
+        << " tiles of " << layout_.tileWidth << "x" << layout_.tileHeight << ", "
+        << layout_.textureBytes / (1024 * 1024) << " MB of textures";
+
+    for (int row = 0; row < layout_.rows; row++) {
+        for (int column = 0; column < layout_.columns; column++) {
+            Tile& tile = tiles_.emplace_back();
+            tile.x = column * layout_.tileWidth;
+            tile.y = row * layout_.tileHeight;
+            tile.width = std::min(layout_.tileWidth, width - tile.x);
+            tile.height = std::min(layout_.tileHeight, height - tile.y);
+
+            if (!tile.generations.Init(pool, 2, tile.width + 2 * TileHalo, tile.height + 2 * TileHalo,
+                    GL_R8, GL_NEAREST, GL_CLAMP_TO_EDGE)) {
+                LOGE << "Failed to init tile " << column << "," << row << " of the tiled grid";
+                Release();
+                return false;
+            }
+        }
+    }
+
+    overviewTexture_ = pool_->Acquire(OverviewSize, OverviewSize, GL_R8);
+    if (!overviewTexture_) {
+        LOGE << "Failed to init tiled grid overview";
+        Release();
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, overviewTexture_); LOGOPENGLERROR();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); LOGOPENGLERROR();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); LOGOPENGLERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+    glGenFramebuffers(1, overviewFramebuffer_.put()); LOGOPENGLERROR();
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(overviewFramebuffer_)); LOGOPENGLERROR();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, overviewTexture_, 0); LOGOPENGLERROR();
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER); LOGOPENGLERROR();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOGE << "Tiled grid overview framebuffer is incomplete : " << status;
+        Release();
+        return false;
+    }
+
+    // The first generation is placed by the whole grid, tiles are drawn through the viewport
+    initRenderer_.Resize(width, height);
+
+    return true;
+}
+
+void TiledGrid::Release() {
+    tiles_.clear();
+
+    overviewFramebuffer_.reset();
+    if (overviewTexture_) {
+        pool_->Recycle(overviewTexture_);
+        overviewTexture_ = 0;
+    }
+
+    layout_ = Layout();
+}
+
+void TiledGrid::SetRules(const CellularAutomata::AutomatonRules& rules) {
+    glUseProgram(stepProgram_); LOGOPENGLERROR();
+    glUniform1i(uRulesBirth_, rules.birth); LOGOPENGLERROR();
+    glUniform1i(uRulesSurvive_, rules.survive); LOGOPENGLERROR();
+}
+
+void TiledGrid::Generate(CellularAutomata::FirstGenerationType type, uint32_t seed, float density) {
+    // Patterns are decoded for the model only
+    if (type == CellularAutomata::FirstGenerationType::Pattern) {
+        type = CellularAutomata::FirstGenerationType::Empty;
+    }
+
+    glUseProgram(initProgram_); LOGOPENGLERROR();
+    glUniform1i(uInitType_, static_cast<int>(type)); LOGOPENGLERROR();
+    glUniform1ui(uInitSeed_, seed); LOGOPENGLERROR();
+    glUniform1ui(uInitDensityThreshold_, CellularAutomata::GetDensityThreshold(density)); LOGOPENGLERROR();
+
+    for (auto& t : tiles_) {
+        // Interior of the tile starts at the halo
+        glUniform2i(uInitOrigin_, t.x - TileHalo, t.y - TileHalo); LOGOPENGLERROR();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, t.generations.GetNextFramebuffer()); LOGOPENGLERROR();
+        glViewport(TileHalo, TileHalo, t.width, t.height); LOGOPENGLERROR();
+        initRenderer_.Render();
+
+        t.generations.Advance();
+        t.generations.ResetHistory();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    // Other users of the program see the whole model
+    glUniform2i(uInitOrigin_, 0, 0); LOGOPENGLERROR();
+
+    generation_ = 0;
+}
+
+const TiledGrid::Tile& TiledGrid::GetTile(int column, int row) const {
+    column = (column + layout_.columns) % layout_.columns;
+    row = (row + layout_.rows) % layout_.rows;
+    return tiles_[static_cast<size_t>(row) * layout_.columns + column];
+}
+
+void TiledGrid::ExchangeHalos() {
+    // Reads are from the interiors and writes to the halos, so a tile may be its own neighbour
+    for (int row = 0; row < layout_.rows; row++) {
+        for (int column = 0; column < layout_.columns; column++) {
+            const Tile& t = GetTile(column, row);
+            const GLuint target = t.generations.GetFramebuffer();
+            const int right = t.width + TileHalo;
+            const int top = t.height + TileHalo;
+
+            const Tile& w = GetTile(column - 1, row);
+            const Tile& e = GetTile(column + 1, row);
+            const Tile& s = GetTile(column, row - 1);
+            const Tile& n = GetTile(column, row + 1);
+            BlitRegion(w.generations.GetFramebuffer(), target, w.width, TileHalo, 0, TileHalo, 1, t.height);
+            BlitRegion(e.generations.GetFramebuffer(), target, TileHalo, TileHalo, right, TileHalo, 1, t.height);
+            BlitRegion(s.generations.GetFramebuffer(), target, TileHalo, s.height, TileHalo, 0, t.width, 1);
+            BlitRegion(n.generations.GetFramebuffer(), target, TileHalo, TileHalo, TileHalo, top, t.width, 1);
+
+            const Tile& sw = GetTile(column - 1, row - 1);
+            const Tile& se = GetTile(column + 1, row - 1);
+            const Tile& nw = GetTile(column - 1, row + 1);
+            const Tile& ne = GetTile(column + 1, row + 1);
+            BlitRegion(sw.generations.GetFramebuffer(), target, sw.width, sw.height, 0, 0, 1, 1);
+            BlitRegion(se.generations.GetFramebuffer(), target, TileHalo, se.height, right, 0, 1, 1);
+            BlitRegion(nw.generations.GetFramebuffer(), target, nw.width, TileHalo, 0, top, 1, 1);
+            BlitRegion(ne.generations.GetFramebuffer(), target, TileHalo, TileHalo, right, top, 1, 1);
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+}
+
+void TiledGrid::Step() {
+    if (tiles_.empty()) {
+        return;
+    }
+
+    ExchangeHalos();
+
+    for (auto& t : tiles_) {
+        glBindFramebuffer(GL_FRAMEBUFFER, t.generations.GetNextFramebuffer()); LOGOPENGLERROR();
+        glViewport(TileHalo, TileHalo, t.width, t.height); LOGOPENGLERROR();
+
+        stepRenderer_.SetTexture(t.generations.GetTexture());
+        stepRenderer_.Render();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    // Every tile reads the previous generation of its own texture only, so they advance together
+    for (auto& t : tiles_) {
+        t.generations.Advance();
+    }
+    generation_++;
+}
+
+void TiledGrid::UpdateOverview() {
+    if (tiles_.empty()) {
+        return;
+    }
+
+    // Grid keeps its aspect in the middle of the square overview
+    const double scale = static_cast<double>(OverviewSize) / std::max(layout_.width, layout_.height);
+    const int x0 = static_cast<int>((OverviewSize - layout_.width * scale) / 2);
+    const int y0 = static_cast<int>((OverviewSize - layout_.height * scale) / 2);
+    const GLenum filter = scale < 1.0 ? GL_LINEAR : GL_NEAREST;
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(overviewFramebuffer_)); LOGOPENGLERROR();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f); LOGOPENGLERROR();
+    glClear(GL_COLOR_BUFFER_BIT); LOGOPENGLERROR();
+
+    for (const auto& t : tiles_) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, t.generations.GetFramebuffer()); LOGOPENGLERROR();
+        glBlitFramebuffer(TileHalo, TileHalo, TileHalo + t.width, TileHalo + t.height,
+            x0 + static_cast<int>(t.x * scale), y0 + static_cast<int>(t.y * scale),
+            x0 + static_cast<int>((t.x + t.width) * scale), y0 + static_cast<int>((t.y + t.height) * scale),
+            GL_COLOR_BUFFER_BIT, filter); LOGOPENGLERROR();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+}
+
+GLuint TiledGrid::GetOverviewTexture() const {
+    return overviewTexture_;
+}
+
+const TiledGrid::Layout& TiledGrid::GetLayout() const {
+    return layout_;
+}
+
+uint64_t TiledGrid::GetGeneration() const {
+    return generation_;
+}
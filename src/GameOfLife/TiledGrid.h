@@ -0,0 +1,79 @@
+#pragma once
+
+// Torus larger than a texture, split into tiles that fit the maximum texture size. Every tile
+// texture has a halo of one cell copied from the neighbour tiles before each generation, so the
+// tiles are stepped one draw call each without wrapping. The screen shows an overview texture
+// the tiles are scaled down into.
+class TiledGrid {
+public:
+    static constexpr int MaxSize = 65536;
+    static constexpr int OverviewSize = 1024;
+
+    struct Layout {
+        int width{ 0 };
+        int height{ 0 };
+        int tileWidth{ 0 };   // Cells of a tile without the halo, the last column and row may be narrower
+        int tileHeight{ 0 };
+        int columns{ 0 };
+        int rows{ 0 };
+        size_t textureBytes{ 0 }; // Both generations of every tile and the overview
+    };
+
+public:
+    TiledGrid() = default;
+    ~TiledGrid();
+
+    TiledGrid(TiledGrid const&) = delete;
+    TiledGrid& operator=(TiledGrid const&) = delete;
+
+    // Tiles of a grid with the halo are at most maxTextureSize per side
+    static Layout GetLayout(int width, int height, int maxTextureSize);
+    static int GetMaxTextureSize();
+
+    bool Init(GLuint stepProgram, GLuint initProgram);
+
+    // Textures are taken from the pool, the previous ones are recycled
+    bool Resize(GraphicsUtils::TexturePool& pool, int width, int height);
+    void Release();
+
+    void SetRules(const CellularAutomata::AutomatonRules& rules);
+
+    // Same cells as the first generation of the model of the same size
+    void Generate(CellularAutomata::FirstGenerationType type, uint32_t seed, float density);
+    void Step();
+
+    void UpdateOverview();
+
+    GLuint GetOverviewTexture() const;
+    const Layout& GetLayout() const;
+    uint64_t GetGeneration() const;
+
+private:
+    struct Tile {
+        int x{ 0 };
+        int y{ 0 };
+        int width{ 0 };
+        int height{ 0 };
+        GraphicsUtils::RenderTargetRing generations;
+    };
+
+    const Tile& GetTile(int column, int row) const;
+    void ExchangeHalos();
+
+private:
+    GraphicsUtils::TexturePool* pool_{ nullptr };
+    Layout layout_;
+    std::deque<Tile> tiles_; // Row by row, rings can't be moved
+    uint64_t generation_{ 0 };
+
+    GLuint overviewTexture_{ 0 };
+    GraphicsUtils::unique_framebuffer overviewFramebuffer_;
+
+    GLuint stepProgram_{ 0 };
+    GLint uRulesBirth_{ -1 }, uRulesSurvive_{ -1 };
+    PlanarTextureRenderer stepRenderer_;
+
+    GLuint initProgram_{ 0 };
+    GLint uInitType_{ -1 }, uInitSeed_{ -1 }, uInitDensityThreshold_{ -1 }, uInitOrigin_{ -1 };
+    PlanarTextureRenderer initRenderer_;
+};
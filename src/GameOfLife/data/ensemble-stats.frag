@@ -0,0 +1,36 @@
+#version 330 core
+
+// Population and hash of each universe of the atlas, one texel per universe
+
+out uvec2 stats;
+
+uniform sampler2D tex;
+
+const int UniverseSize = 64;
+
+// Alive cells are hashed by their position and the hashes are summed
+uint hashCell(uint i) {
+    i ^= i >> 16u;
+    i *= 0x7feb352du;
+    i ^= i >> 15u;
+    i *= 0x846ca68bu;
+    i ^= i >> 16u;
+    return i;
+}
+
+void main(void) {
+    ivec2 origin = ivec2(gl_FragCoord.xy) * UniverseSize;
+
+    uint n = 0u;
+    uint h = 0u;
+    for (int y = 0; y < UniverseSize; y++) {
+        for (int x = 0; x < UniverseSize; x++) {
+            if (texelFetch(tex, origin + ivec2(x, y), 0).r > 0.5) {
+                n++;
+                h += hashCell(uint(y * UniverseSize + x) + 1u);
+            }
+        }
+    }
+
+    stats = uvec2(n, h);
+}
@@ -0,0 +1,43 @@
+#version 330 core
+
+// One generation of every universe of the atlas. Universes are tori of UniverseSize cells,
+// neighbours wrap around the tile instead of the texture.
+
+out vec4 outFragCol;
+
+uniform sampler2D tex;
+
+// Rules of each universe, birth in bits 0-8 and survive in bits 9-17
+uniform usampler2D rulesTex;
+
+const int UniverseSize = 64;
+
+const float PopulatedCell=1.;
+const float UnpopulatedCell=0.;
+
+void main(void) {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 tile = p / UniverseSize;
+    ivec2 origin = tile * UniverseSize;
+    ivec2 local = p - origin;
+
+    int n = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (dx == 0 && dy == 0) {
+                continue;
+            }
+            ivec2 q = origin + (local + ivec2(dx, dy) + UniverseSize) % UniverseSize;
+            if (texelFetch(tex, q, 0).r == PopulatedCell) {
+                n++;
+            }
+        }
+    }
+
+    uint rules = texelFetch(rulesTex, tile, 0).r;
+    bool alive = texelFetch(tex, p, 0).r == PopulatedCell;
+    uint mask = alive ? (rules >> 9u) : rules;
+
+    float c = (((mask >> uint(n)) & 1u) != 0u) ? PopulatedCell : UnpopulatedCell;
+    outFragCol = vec4(c, 0., 0., 1.);
+}
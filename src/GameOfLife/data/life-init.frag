@@ -4,9 +4,13 @@ in vec2 fragTexCoord;
 
 out vec4 outFragCol;
 
-uniform sampler2D tex;
-uniform float time;
+uniform vec2 res;
 uniform int initType;
+uniform uint seed;
+uniform uint densityThreshold;
+
+// Grid cell of the first fragment when the grid is split over several textures
+uniform ivec2 origin;
 
 const int InitEmpty=0;
 const int InitUniformRandom=1;
@@ -15,33 +19,65 @@ const int InitRadialRandom=2;
 const float PopulatedCell=1.;
 const float UnpopulatedCell=0.;
 
-const float TimeScale=0.002;
-const float RadialScale=100.;
+// Must match RandomGenerator.cpp
+const uint PhiloxM=0xD256D193u;
+const uint PhiloxW=0x9E3779B9u;
+const int PhiloxRounds=10;
+
+const uint RadialScale=100u;
+const uint RadialStream=0xFFFFFFFFu;
 
-float rand(vec2 crd) {
-   return fract(sin(dot(crd.xy,vec2(12.9898,78.233))) * 43758.5453);
+// High word of the 64-bit product, GLSL 3.30 has no umulExtended
+uint mulhi(uint a, uint b) {
+    uint al=a&0xFFFFu, ah=a>>16, bl=b&0xFFFFu, bh=b>>16;
+    uint ll=al*bl, hl=ah*bl, lh=al*bh, hh=ah*bh;
+    uint cross=(ll>>16)+(hl&0xFFFFu)+lh;
+    return hh+(hl>>16)+(cross>>16);
+}
+
+// Philox2x32-10 counter-based generator
+uvec2 philox(uvec2 ctr, uint key) {
+    for (int i=0; i<PhiloxRounds; i++) {
+        if (i>0) {
+            key+=PhiloxW;
+        }
+        uint hi=mulhi(PhiloxM,ctr.x);
+        uint lo=PhiloxM*ctr.x;
+        ctr=uvec2(hi^key^ctr.y,lo);
+    }
+    return ctr;
+}
+
+uint isqrt(uint n) {
+    uint r=uint(sqrt(float(n)));
+    while (r*r>n) {
+        r--;
+    }
+    while ((r+1u)*(r+1u)<=n) {
+        r++;
+    }
+    return r;
+}
+
+uint radialRing(ivec2 p, ivec2 size) {
+    uvec2 d=uvec2(abs(p-size/2));
+    uint minSize=uint(min(size.x,size.y));
+    return isqrt(d.x*d.x+d.y*d.y)*RadialScale/minSize;
 }
 
 void main(void) {
-    float c = 0.;
-    
-    if (initType==InitEmpty) {
-        c=UnpopulatedCell;
+    float c=UnpopulatedCell;
+
+    ivec2 p=ivec2(gl_FragCoord.xy)+origin;
+    ivec2 size=ivec2(res);
+
+    if (initType==InitUniformRandom) {
+        c=philox(uvec2(p),seed).x<densityThreshold ? PopulatedCell : UnpopulatedCell;
     }
-    else {
-        vec2 uv=fragTexCoord;
-        vec2 timeSeed=vec2(time,time)*TimeScale;
-        
-        if (initType==InitUniformRandom) {
-            c=rand(uv+timeSeed) > .5 ? PopulatedCell : UnpopulatedCell;
-        }
-        else if (initType==InitRadialRandom) {
-            vec2 c0=uv-vec2(0.5);
-            vec2 rt=vec2(trunc((length(c0)*RadialScale)));
-        
-            c=rand(rt+timeSeed) > .5 ? PopulatedCell : UnpopulatedCell;
-        }
+    else if (initType==InitRadialRandom) {
+        uint ring=radialRing(p,size);
+        c=philox(uvec2(ring,RadialStream),seed).x<densityThreshold ? PopulatedCell : UnpopulatedCell;
     }
-    
+
     outFragCol=vec4(c,0.,0.,1.);
 }
@@ -0,0 +1,40 @@
+#version 330 core
+
+// One generation of a tile of a grid split over several textures. The tile is surrounded by
+// a halo of one cell copied from the neighbour tiles, so the neighbours are fetched without wrapping.
+
+out vec4 outFragCol;
+
+uniform sampler2D tex;
+
+struct GameRules {
+    int birth;
+    int survive;
+};
+
+uniform GameRules rules;
+
+const float PopulatedCell=1.;
+const float UnpopulatedCell=0.;
+
+void main(void) {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+
+    int n = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (dx == 0 && dy == 0) {
+                continue;
+            }
+            if (texelFetch(tex, p + ivec2(dx, dy), 0).r == PopulatedCell) {
+                n++;
+            }
+        }
+    }
+
+    bool alive = texelFetch(tex, p, 0).r == PopulatedCell;
+    int mask = alive ? rules.survive : rules.birth;
+
+    float c = (((mask >> n) & 1) != 0) ? PopulatedCell : UnpopulatedCell;
+    outFragCol = vec4(c, 0., 0., 1.);
+}
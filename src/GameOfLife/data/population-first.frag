@@ -0,0 +1,26 @@
+#version 330 core
+
+// Alive cells of the 4x4 block of the generation
+
+out uint count;
+
+uniform sampler2D tex;
+
+const int BlockSize = 4;
+
+void main(void) {
+    ivec2 size = textureSize(tex, 0);
+    ivec2 origin = ivec2(gl_FragCoord.xy) * BlockSize;
+
+    uint n = 0u;
+    for (int y = 0; y < BlockSize; y++) {
+        for (int x = 0; x < BlockSize; x++) {
+            ivec2 p = origin + ivec2(x, y);
+            if (all(lessThan(p, size)) && texelFetch(tex, p, 0).r > 0.5) {
+                n++;
+            }
+        }
+    }
+
+    count = n;
+}
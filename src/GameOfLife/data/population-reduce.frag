@@ -0,0 +1,26 @@
+#version 330 core
+
+// Sum of the counts of the 4x4 block of the previous level
+
+out uint count;
+
+uniform usampler2D tex;
+
+const int BlockSize = 4;
+
+void main(void) {
+    ivec2 size = textureSize(tex, 0);
+    ivec2 origin = ivec2(gl_FragCoord.xy) * BlockSize;
+
+    uint n = 0u;
+    for (int y = 0; y < BlockSize; y++) {
+        for (int x = 0; x < BlockSize; x++) {
+            ivec2 p = origin + ivec2(x, y);
+            if (all(lessThan(p, size))) {
+                n += texelFetch(tex, p, 0).r;
+            }
+        }
+    }
+
+    count = n;
+}
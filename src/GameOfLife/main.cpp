@@ -1,9 +1,26 @@
 #include "stdafx.h"
 #include "GraphicsLogger.h"
 #include "GraphicsResource.h"
+#include "TexturePool.h"
+#include "RenderTargetRing.h"
+#include "AsyncReadback.h"
+#include "ImageFile.h"
+#include "FrameCapture.h"
 #include "LogFormatter.h"
 #include "PlanarTextureRenderer.h"
+#include "PopulationCounter.h"
+#include "HistoryRing.h"
 #include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "LifeEngine.h"
+#include "PeriodDetector.h"
+#include "Components.h"
+#include "PlaneEngine.h"
+#include "EnsembleEngine.h"
+#include "EnsembleAtlas.h"
+#include "TiledGrid.h"
+#include "MappedFile.h"
+#include "GenerationStream.h"
 #include "GlfwWrapper.h"
 #include "ImGuiWrapper.h"
 #include "LifeContext.h"
@@ -13,6 +13,20 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <filesystem>
 #include <functional>
 #include <tuple>
+#include <array>
+#include <cstring>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <cfloat>
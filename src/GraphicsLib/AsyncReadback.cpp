@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "GraphicsResource.h"
+#include "AsyncReadback.h"
+
+// Weight of the latest read in the average latency
+constexpr double LatencySmoothing = 0.05;
+
+size_t GetPixelSize(GLenum format, GLenum type) {
+    size_t components = 0;
+    switch (format) {
+    case GL_RED: case GL_RED_INTEGER: components = 1; break;
+    case GL_RG: case GL_RG_INTEGER: components = 2; break;
+    case GL_RGB: case GL_RGB_INTEGER: components = 3; break;
+    case GL_RGBA: case GL_RGBA_INTEGER: components = 4; break;
+    default: return 0;
+    }
+
+    switch (type) {
+    case GL_UNSIGNED_BYTE: return components;
+    case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return components * 4;
+    default: return 0;
+    }
+}
+
+
+namespace GraphicsUtils {
+
+AsyncReadback::~AsyncReadback() {
+    Release();
+}
+
+bool AsyncReadback::Init(size_t count, size_t bufferSize) {
+    Release();
+
+    slots_.resize(count);
+    bufferSize_ = bufferSize;
+
+    for (auto& slot : slots_) {
+        glGenBuffers(1, slot.buffer.put()); LOGOPENGLERROR();
+        if (!slot.buffer) {
+            LOGE << "Failed to create pixel buffer";
+            Release();
+            return false;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(slot.buffer)); LOGOPENGLERROR();
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_READ); LOGOPENGLERROR();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0); LOGOPENGLERROR();
+
+    return true;
+}
+
+void AsyncReadback::Release() {
+    for (auto& slot : slots_) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence); LOGOPENGLERROR();
+        }
+    }
+    slots_.clear();
+
+    bufferSize_ = 0;
+    oldest_ = 0;
+    pending_ = 0;
+}
+
+bool AsyncReadback::Request(GLuint framebuffer, GLsizei width, GLsizei height, GLenum format, GLenum type,
+        uint64_t tag) {
+    if (pending_ == slots_.size()) {
+        stats_.rejected++;
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(width) * height * GetPixelSize(format, type);
+    if (size == 0 || size > bufferSize_) {
+        LOGE << "Readback of " << width << "x" << height << " doesn't fit into " << bufferSize_ << " bytes";
+        return false;
+    }
+
+    Slot& slot = slots_[(oldest_ + pending_) % slots_.size()];
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer); LOGOPENGLERROR();
+    glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK); LOGOPENGLERROR();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(slot.buffer)); LOGOPENGLERROR();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); LOGOPENGLERROR();
+
+    // Returns immediately, the copy runs after the queued passes
+    glReadPixels(0, 0, width, height, format, type, nullptr); LOGOPENGLERROR();
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0); LOGOPENGLERROR();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); LOGOPENGLERROR();
+    slot.size = size;
+    slot.tag = tag;
+    slot.requestTime = std::chrono::steady_clock::now();
+
+    pending_++;
+    return true;
+}
+
+size_t AsyncReadback::Poll(const Consumer& consume, bool wait) {
+    size_t consumed = 0;
+
+    while (pending_ > 0) {
+        Slot& slot = slots_[oldest_];
+
+        // Only the first wait may block, the fence is flushed to make sure it gets signaled
+        const bool block = wait && consumed == 0;
+        const GLbitfield flags = block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+        const GLuint64 timeout = block ? std::numeric_limits<GLuint64>::max() : 0;
+
+        GLenum status = glClientWaitSync(slot.fence, flags, timeout); LOGOPENGLERROR();
+        if (status == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        if (status == GL_WAIT_FAILED) {
+            LOGE << "Failed to wait for the readback";
+        }
+
+        Consume(slot, consume);
+        consumed++;
+    }
+
+    return consumed;
+}
+
+void AsyncReadback::Flush(const Consumer& consume) {
+    while (pending_ > 0) {
+        Poll(consume, true);
+    }
+}
+
+void AsyncReadback::Consume(Slot& slot, const Consumer& consume) {
+    glDeleteSync(slot.fence); LOGOPENGLERROR();
+    slot.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(slot.buffer)); LOGOPENGLERROR();
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(slot.size),
+        GL_MAP_READ_BIT); LOGOPENGLERROR();
+    if (data) {
+        consume(data, slot.size, slot.tag);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER); LOGOPENGLERROR();
+    }
+    else {
+        LOGE << "Failed to map pixel buffer";
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0); LOGOPENGLERROR();
+
+    std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - slot.requestTime;
+    stats_.latencyMs = (stats_.completed == 0) ? latency.count() :
+        stats_.latencyMs + (latency.count() - stats_.latencyMs) * LatencySmoothing;
+    stats_.completed++;
+    stats_.bytes += slot.size;
+
+    oldest_ = (oldest_ + 1) % slots_.size();
+    pending_--;
+}
+
+size_t AsyncReadback::GetPendingCount() const {
+    return pending_;
+}
+
+size_t AsyncReadback::GetCount() const {
+    return slots_.size();
+}
+
+const AsyncReadback::Stats& AsyncReadback::GetStats() const {
+    return stats_;
+}
+
+} // namespace GraphicsUtils
@@ -0,0 +1,67 @@
+#pragma once
+
+namespace GraphicsUtils {
+
+    // Reads framebuffers back through a ring of pixel buffer objects.
+    // glReadPixels only queues a copy into a buffer, which is mapped once its fence
+    // is signaled, so with three buffers the CPU consumes pass N while the GPU works on N + 2.
+    class AsyncReadback {
+    public:
+        struct Stats {
+            uint64_t completed{ 0 };
+            uint64_t rejected{ 0 };  // Requests while every buffer was in flight
+            uint64_t bytes{ 0 };     // Read back since the start
+            double latencyMs{ 0.0 }; // Recent average from the request to the consumption
+        };
+
+        // Data is valid only during the call
+        using Consumer = std::function<void(const void* data, size_t size, uint64_t tag)>;
+
+    public:
+        AsyncReadback() = default;
+        ~AsyncReadback();
+
+        AsyncReadback(AsyncReadback const&) = delete;
+        AsyncReadback& operator=(AsyncReadback const&) = delete;
+
+        bool Init(size_t count, size_t bufferSize);
+        void Release();
+
+        // Queue reading of color attachment 0 of the framebuffer, or of the back buffer for framebuffer 0.
+        // The tag is passed to the consumer.
+        // Returns false if every buffer is in flight or the area doesn't fit into a buffer.
+        bool Request(GLuint framebuffer, GLsizei width, GLsizei height, GLenum format, GLenum type, uint64_t tag);
+
+        // Pass the completed reads to the consumer in the request order, return their count.
+        // The oldest read is waited for if wait is set.
+        size_t Poll(const Consumer& consume, bool wait = false);
+
+        // Wait for all reads in flight
+        void Flush(const Consumer& consume);
+
+        size_t GetPendingCount() const;
+        size_t GetCount() const;
+        const Stats& GetStats() const;
+
+    private:
+        struct Slot {
+            unique_buffer buffer;
+            GLsync fence{ nullptr };
+            size_t size{ 0 };
+            uint64_t tag{ 0 };
+            std::chrono::steady_clock::time_point requestTime;
+        };
+
+        void Consume(Slot& slot, const Consumer& consume);
+
+    private:
+        std::vector<Slot> slots_;
+        size_t bufferSize_{ 0 };
+
+        size_t oldest_{ 0 };
+        size_t pending_{ 0 };
+
+        Stats stats_;
+    };
+
+}
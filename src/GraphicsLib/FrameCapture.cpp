@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "GraphicsResource.h"
+#include "AsyncReadback.h"
+#include "ImageFile.h"
+#include "FrameCapture.h"
+
+// Frames are read back two frames after they are rendered
+constexpr size_t CaptureReadbackCount = 3;
+
+
+namespace GraphicsUtils {
+
+FrameCapture::~FrameCapture() {
+    Stop();
+    JoinWriter();
+}
+
+bool FrameCapture::Start(const std::filesystem::path& directory, ImageFormat format, size_t queueSize) {
+    Stop();
+    JoinWriter();
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        LOGE << "Unable to create capture directory " << directory.string() << " : " << ec.message();
+        return false;
+    }
+
+    directory_ = directory;
+    format_ = format;
+    queueSize_ = std::max<size_t>(queueSize, 1);
+    nextIndex_ = 0;
+    dropped_ = 0;
+    written_ = 0;
+    readbackSize_ = 0;
+
+    stopWriter_ = false;
+    writer_ = std::thread(&FrameCapture::WriterLoop, this);
+
+    isCapturing_ = true;
+    LOGI << "Capturing frames to " << directory_.string();
+    return true;
+}
+
+void FrameCapture::Stop() {
+    if (!isCapturing_) {
+        return;
+    }
+    isCapturing_ = false;
+
+    // Waits for the GPU only, the disk is left to the writer
+    readback_.Flush([this](const void* data, size_t size, uint64_t tag) { Consume(data, size, tag); });
+    readback_.Release();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopWriter_ = true;
+    }
+    hasFrames_.notify_one();
+
+    LOGI << "Capture stopped, " << nextIndex_ << " frames captured, " << dropped_ << " dropped";
+}
+
+bool FrameCapture::IsCapturing() const {
+    return isCapturing_;
+}
+
+void FrameCapture::Capture(GLuint framebuffer, int width, int height, int channels) {
+    if (!isCapturing_) {
+        return;
+    }
+
+    auto consume = [this](const void* data, size_t size, uint64_t tag) { Consume(data, size, tag); };
+
+    // The buffers are reallocated when the window is resized
+    const size_t size = static_cast<size_t>(width) * height * channels;
+    if (size != readbackSize_) {
+        readback_.Flush(consume);
+        if (!readback_.Init(CaptureReadbackCount, size)) {
+            Stop();
+            return;
+        }
+        readbackSize_ = size;
+    }
+    width_ = width;
+    height_ = height;
+    channels_ = channels;
+
+    readback_.Poll(consume);
+
+    const GLenum format = (channels == 1) ? GL_RED : GL_RGB;
+    if (readback_.Request(framebuffer, width, height, format, GL_UNSIGNED_BYTE, nextIndex_)) {
+        nextIndex_++;
+    }
+    else {
+        dropped_++;
+    }
+}
+
+void FrameCapture::Consume(const void* data, size_t size, uint64_t tag) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.size() >= queueSize_) {
+        dropped_++;
+        return;
+    }
+
+    Frame frame;
+    if (!free_.empty()) {
+        frame = std::move(free_.back());
+        free_.pop_back();
+    }
+    lock.unlock();
+
+    // Copying out of the mapping is fast, the buffer has to be unmapped on this thread
+    frame.index = tag;
+    frame.width = width_;
+    frame.height = height_;
+    frame.channels = channels_;
+    frame.pixels.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+    lock.lock();
+    queue_.push_back(std::move(frame));
+    lock.unlock();
+    hasFrames_.notify_one();
+}
+
+void FrameCapture::WriterLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        hasFrames_.wait(lock, [this] { return stopWriter_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;
+        }
+
+        Frame frame = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        std::ostringstream name;
+        name << "frame_" << std::setw(6) << std::setfill('0') << frame.index
+            << GetImageExtension(format_, frame.channels);
+        if (WriteImage(directory_ / name.str(), format_, frame.width, frame.height, frame.channels,
+                frame.pixels.data())) {
+            written_++;
+        }
+
+        lock.lock();
+        free_.push_back(std::move(frame));
+    }
+}
+
+void FrameCapture::JoinWriter() {
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+FrameCapture::Stats FrameCapture::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{ written_, dropped_, queue_.size() };
+}
+
+} // namespace GraphicsUtils
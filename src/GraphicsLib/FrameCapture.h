@@ -0,0 +1,77 @@
+#pragma once
+
+namespace GraphicsUtils {
+
+    // Captures a framebuffer every frame into numbered image files.
+    // Frames are read back through AsyncReadback and encoded by a writer thread,
+    // so the render loop never waits for the disk. When the bounded queue is full
+    // the frame is dropped instead.
+    class FrameCapture {
+    public:
+        struct Stats {
+            uint64_t written{ 0 };
+            uint64_t dropped{ 0 };
+            size_t queued{ 0 };
+        };
+
+        static constexpr size_t DefaultQueueSize = 8;
+
+    public:
+        FrameCapture() = default;
+        ~FrameCapture();
+
+        FrameCapture(FrameCapture const&) = delete;
+        FrameCapture& operator=(FrameCapture const&) = delete;
+
+        // Files are named frame_000000 and so on in the directory, which is created if needed
+        bool Start(const std::filesystem::path& directory, ImageFormat format, size_t queueSize = DefaultQueueSize);
+
+        // Frames already queued are still written in the background
+        void Stop();
+
+        bool IsCapturing() const;
+
+        // Capture color attachment 0 of the framebuffer, 0 for the window back buffer.
+        // Channels are 1 for grayscale or 3 for RGB.
+        void Capture(GLuint framebuffer, int width, int height, int channels);
+
+        Stats GetStats() const;
+
+    private:
+        struct Frame {
+            uint64_t index{ 0 };
+            int width{ 0 };
+            int height{ 0 };
+            int channels{ 0 };
+            std::vector<uint8_t> pixels;
+        };
+
+        void Consume(const void* data, size_t size, uint64_t tag);
+        void WriterLoop();
+        void JoinWriter();
+
+    private:
+        AsyncReadback readback_;
+        size_t readbackSize_{ 0 };
+        int width_{ 0 };
+        int height_{ 0 };
+        int channels_{ 0 };
+
+        std::filesystem::path directory_;
+        ImageFormat format_{ ImageFormat::Png };
+        size_t queueSize_{ DefaultQueueSize };
+        uint64_t nextIndex_{ 0 };
+        bool isCapturing_{ false };
+
+        std::thread writer_;
+        mutable std::mutex mutex_;
+        std::condition_variable hasFrames_;
+        std::deque<Frame> queue_; // Guarded by mutex_
+        std::vector<Frame> free_; // Guarded by mutex_, frames to reuse
+        bool stopWriter_{ false };  // Guarded by mutex_
+
+        std::atomic<uint64_t> written_{ 0 };
+        uint64_t dropped_{ 0 };
+    };
+
+}
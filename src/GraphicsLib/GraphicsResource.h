@@ -8,6 +8,7 @@ namespace GraphicsUtils {
 
         unique_any() = default;
 
+        // Derived handles call reset() in their own destructors, here the virtual close() no longer reaches them
         virtual ~unique_any() {
             reset();
         }
@@ -85,22 +86,42 @@ namespace GraphicsUtils {
     };
 
     struct unique_texture : public unique_any {
-        void close();
+        unique_texture() = default;
+        unique_texture(unique_texture&&) noexcept = default;
+        ~unique_texture() override { reset(); }
+
+        void close() override;
     };
 
     struct unique_framebuffer : public unique_any {
-        void close();
+        unique_framebuffer() = default;
+        unique_framebuffer(unique_framebuffer&&) noexcept = default;
+        ~unique_framebuffer() override { reset(); }
+
+        void close() override;
     };
 
     struct unique_program : public unique_any {
-        void close();
+        unique_program() = default;
+        unique_program(unique_program&&) noexcept = default;
+        ~unique_program() override { reset(); }
+
+        void close() override;
     };
 
     struct unique_vertex_array : public unique_any {
-        void close();
+        unique_vertex_array() = default;
+        unique_vertex_array(unique_vertex_array&&) noexcept = default;
+        ~unique_vertex_array() override { reset(); }
+
+        void close() override;
     };
 
     struct unique_buffer : public unique_any {
-        void close();
+        unique_buffer() = default;
+        unique_buffer(unique_buffer&&) noexcept = default;
+        ~unique_buffer() override { reset(); }
+
+        void close() override;
     };
 }
@@ -0,0 +1,140 @@
+#include "stdafx.h"
+#include "ImageFile.h"
+
+// Stored deflate blocks are limited to 64K
+constexpr size_t MaxStoredBlock = 65535;
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void AppendPngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    AppendBigEndian(out, Crc32(out.data() + typeOffset, out.size() - typeOffset));
+}
+
+std::vector<uint8_t> EncodePng(int width, int height, int channels, const uint8_t* pixels) {
+    const size_t rowSize = static_cast<size_t>(width) * channels;
+
+    // Scanlines with filter type 0, top down
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = height - 1; y >= 0; y--) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + rowSize * y, pixels + rowSize * (y + 1));
+    }
+
+    // Zlib stream of stored deflate blocks
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    zlib.reserve(raw.size() + raw.size() / MaxStoredBlock * 5 + 16);
+
+    uint32_t adlerA = 1, adlerB = 0;
+    for (size_t offset = 0; offset < raw.size() || offset == 0; offset += MaxStoredBlock) {
+        const size_t size = std::min(MaxStoredBlock, raw.size() - offset);
+        const bool isLast = offset + size >= raw.size();
+
+        zlib.push_back(isLast ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(size));
+        zlib.push_back(static_cast<uint8_t>(size >> 8));
+        zlib.push_back(static_cast<uint8_t>(~size));
+        zlib.push_back(static_cast<uint8_t>(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+        for (size_t i = offset; i < offset + size; i++) {
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        if (isLast) {
+            break;
+        }
+    }
+    AppendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+    std::vector<uint8_t> header;
+    AppendBigEndian(header, static_cast<uint32_t>(width));
+    AppendBigEndian(header, static_cast<uint32_t>(height));
+    header.push_back(8);                         // Bit depth
+    header.push_back(channels == 1 ? 0 : 2);     // Grayscale or RGB
+    header.push_back(0);                         // Deflate
+    header.push_back(0);                         // Adaptive filtering
+    header.push_back(0);                         // No interlace
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    AppendPngChunk(png, "IHDR", header);
+    AppendPngChunk(png, "IDAT", zlib);
+    AppendPngChunk(png, "IEND", {});
+    return png;
+}
+
+
+namespace GraphicsUtils {
+
+std::string GetImageExtension(ImageFormat format, int channels) {
+    if (format == ImageFormat::Png) {
+        return ".png";
+    }
+    return (channels == 1) ? ".pgm" : ".ppm";
+}
+
+bool WriteImage(const std::filesystem::path& path, ImageFormat format, int width, int height, int channels,
+        const uint8_t* pixels) {
+    if (channels != 1 && channels != 3) {
+        LOGE << "Unsupported number of image channels " << channels;
+        return false;
+    }
+
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+        LOGE << "Unable to create image " << path.string();
+        return false;
+    }
+
+    if (format == ImageFormat::Png) {
+        std::vector<uint8_t> png = EncodePng(width, height, channels, pixels);
+        out.write(reinterpret_cast<const char*>(png.data()), png.size());
+    }
+    else {
+        out << (channels == 1 ? "P5" : "P6") << "\n" << width << " " << height << "\n255\n";
+
+        const size_t rowSize = static_cast<size_t>(width) * channels;
+        for (int y = height - 1; y >= 0; y--) {
+            out.write(reinterpret_cast<const char*>(pixels + rowSize * y), rowSize);
+        }
+    }
+
+    if (!out) {
+        LOGE << "Unable to write image " << path.string();
+        return false;
+    }
+    return true;
+}
+
+} // namespace GraphicsUtils
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace GraphicsUtils {
+
+    enum class ImageFormat {
+        Pnm, // Binary PPM for RGB and PGM for grayscale images
+        Png, // Uncompressed PNG, cheap to encode
+    };
+
+    // Extension of the format for the number of channels, with the dot
+    std::string GetImageExtension(ImageFormat format, int channels);
+
+    // Pixels are 8-bit grayscale (1 channel) or RGB (3 channels) rows without padding.
+    // Rows go bottom up as OpenGL reads them, the file is written top down.
+    bool WriteImage(const std::filesystem::path& path, ImageFormat format, int width, int height, int channels,
+        const uint8_t* pixels);
+
+}
@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "GraphicsResource.h"
+#include "TexturePool.h"
+#include "RenderTargetRing.h"
+
+
+namespace GraphicsUtils {
+
+RenderTargetRing::~RenderTargetRing() {
+    Release();
+}
+
+bool RenderTargetRing::Init(TexturePool& pool, size_t count, GLsizei width, GLsizei height,
+        GLenum internalFormat, GLenum filter, GLenum wrap) {
+    Release();
+
+    if (count < 2) {
+        LOGE << "Render target ring requires at least 2 buffers";
+        return false;
+    }
+
+    pool_ = &pool;
+
+    textures_.reserve(count);
+    framebuffers_.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        GLuint texture = pool_->Acquire(width, height, internalFormat);
+        if (!texture) {
+            LOGE << "Failed to init texture of render target " << i;
+            Release();
+            return false;
+        }
+        textures_.push_back(texture);
+
+        glBindTexture(GL_TEXTURE_2D, texture); LOGOPENGLERROR();
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter); LOGOPENGLERROR();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter); LOGOPENGLERROR();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap); LOGOPENGLERROR();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap); LOGOPENGLERROR();
+
+        glGenFramebuffers(1, framebuffers_[i].put()); LOGOPENGLERROR();
+        if (!framebuffers_[i]) {
+            LOGE << "Failed to init framebuffer of render target " << i;
+            Release();
+            return false;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffers_[i])); LOGOPENGLERROR();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+            texture, 0); LOGOPENGLERROR();
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER); LOGOPENGLERROR();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0); LOGOPENGLERROR();
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            LOGE << "Framebuffer of render target " << i << " is incomplete : " << status;
+            Release();
+            return false;
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+    head_ = 0;
+    historySize_ = 1;
+
+    return true;
+}
+
+void RenderTargetRing::Release() {
+    for (GLuint t : textures_) {
+        pool_->Recycle(t);
+    }
+
+    framebuffers_.clear();
+    textures_.clear();
+
+    head_ = 0;
+    historySize_ = 0;
+}
+
+void RenderTargetRing::Advance() {
+    head_ = SlotIndex(textures_.size() - 1);
+    if (historySize_ < textures_.size()) {
+        historySize_++;
+    }
+}
+
+void RenderTargetRing::ResetHistory() {
+    historySize_ = 1;
+}
+
+GLuint RenderTargetRing::GetTexture(size_t age) const {
+    if (age >= historySize_) {
+        return 0;
+    }
+    return textures_[SlotIndex(age)];
+}
+
+GLuint RenderTargetRing::GetFramebuffer(size_t age) const {
+    if (age >= historySize_) {
+        return 0;
+    }
+    return static_cast<GLuint>(framebuffers_[SlotIndex(age)]);
+}
+
+GLuint RenderTargetRing::GetNextFramebuffer() const {
+    return static_cast<GLuint>(framebuffers_[SlotIndex(textures_.size() - 1)]);
+}
+
+GLuint RenderTargetRing::GetNextTexture() const {
+    return textures_[SlotIndex(textures_.size() - 1)];
+}
+
+size_t RenderTargetRing::GetCount() const {
+    return textures_.size();
+}
+
+size_t RenderTargetRing::GetHistorySize() const {
+    return historySize_;
+}
+
+size_t RenderTargetRing::SlotIndex(size_t age) const {
+    // Ages go backwards from the head, so age count-1 is the slot right after it
+    return (head_ + textures_.size() - (age % textures_.size())) % textures_.size();
+}
+
+} // namespace GraphicsUtils
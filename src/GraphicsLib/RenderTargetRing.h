@@ -0,0 +1,52 @@
+#pragma once
+
+namespace GraphicsUtils {
+
+    // Ring of textures with a framebuffer prebuilt for each of them.
+    // The head is the latest rendered texture, the slot after it is the
+    // render target for the next pass. Advancing the ring never reattaches
+    // textures, and the older slots keep the previous passes resident.
+    class RenderTargetRing {
+    public:
+        RenderTargetRing() = default;
+        ~RenderTargetRing();
+
+        // Textures are taken from the pool and returned there on Release
+        bool Init(TexturePool& pool, size_t count, GLsizei width, GLsizei height,
+            GLenum internalFormat, GLenum filter, GLenum wrap);
+        void Release();
+
+        // Make the render target of the next pass the new head
+        void Advance();
+
+        // Forget the history, e.g. after rendering the initial state
+        void ResetHistory();
+
+        // Texture rendered age passes ago, 0 is the latest one
+        GLuint GetTexture(size_t age = 0) const;
+
+        // Framebuffer of the texture rendered age passes ago, e.g. for reading it back
+        GLuint GetFramebuffer(size_t age = 0) const;
+
+        GLuint GetNextFramebuffer() const;
+        GLuint GetNextTexture() const;
+
+        size_t GetCount() const;
+
+        // Number of passes available for GetTexture, including the latest one
+        size_t GetHistorySize() const;
+
+    private:
+        size_t SlotIndex(size_t age) const;
+
+    private:
+        TexturePool* pool_{ nullptr };
+
+        std::vector<GLuint> textures_;
+        std::vector<unique_framebuffer> framebuffers_;
+
+        size_t head_{ 0 };
+        size_t historySize_{ 0 };
+    };
+
+}
@@ -2,17 +2,27 @@
 #include "GraphicsLogger.h"
 #include "Shader.h"
 
+const uint32_t ProgramCacheMagic = 0x42504c47; // "GLPB"
+const uint32_t ProgramCacheVersion = 1;
+
+struct ProgramCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+static std::filesystem::path ProgramCacheDir;
+
 std::string LoadShaderFile(const std::string& filename) {
     std::ifstream in(filename, std::ios::in);
     if (!in) {
         return "";
     }
 
-    std::string line;
     std::stringstream str;
-    while (std::getline(in, line)) {
-        str << line << std::endl;
-    }
+    str << in.rdbuf();
 
     return str.str();
 }
@@ -59,6 +69,143 @@ void ReleaseProgram(GLuint program, GLuint vertex, GLuint fragment) {
     }
 }
 
+bool IsProgramCacheAvailable() {
+    if (ProgramCacheDir.empty() || !GLAD_GL_VERSION_4_1) {
+        return false;
+    }
+
+    GLint formats{ 0 };
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats); LOGOPENGLERROR();
+    return (formats > 0);
+}
+
+uint64_t HashProgramSources(const std::string& vertex_shader, const std::string& fragment_shader) {
+    // FNV-1a over the sources and the driver identification, as binaries
+    // are only valid for the same driver build
+    uint64_t hash = 14695981039346656037ull;
+    auto hashString = [&hash](const char* str) {
+        for (; *str; str++) {
+            hash ^= static_cast<unsigned char>(*str);
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xff; // Separator that doesn't occur in text
+        hash *= 1099511628211ull;
+    };
+
+    hashString(vertex_shader.c_str());
+    hashString(fragment_shader.c_str());
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const GLubyte* str = glGetString(name); LOGOPENGLERROR();
+        hashString(str ? reinterpret_cast<const char*>(str) : "");
+    }
+
+    return hash;
+}
+
+std::filesystem::path GetProgramCachePath(uint64_t key) {
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return ProgramCacheDir / name.str();
+}
+
+GLuint LoadProgramBinary(uint64_t key) {
+    auto path = GetProgramCachePath(key);
+
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+
+    ProgramCacheHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != ProgramCacheMagic || header.version != ProgramCacheVersion ||
+        header.key != key || header.length == 0) {
+        LOGW << "Ignoring malformed program cache entry " << path.string();
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!in.read(binary.data(), binary.size())) {
+        LOGW << "Ignoring truncated program cache entry " << path.string();
+        return 0;
+    }
+
+    GLuint sProgram = glCreateProgram(); LOGOPENGLERROR();
+    if (!sProgram) {
+        return 0;
+    }
+
+    glProgramBinary(sProgram, header.format, binary.data(), header.length); LOGOPENGLERROR();
+
+    GLint result{ 0 };
+    glGetProgramiv(sProgram, GL_LINK_STATUS, &result); LOGOPENGLERROR();
+    if (!result) {
+        // Driver update or different GPU, recompile and overwrite the entry
+        LOGI << "Cached program binary was rejected by the driver";
+        glDeleteProgram(sProgram); LOGOPENGLERROR();
+        return 0;
+    }
+
+    return sProgram;
+}
+
+void SaveProgramBinary(GLuint program, uint64_t key) {
+    GLint length{ 0 };
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length); LOGOPENGLERROR();
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format{ 0 };
+    glGetProgramBinary(program, length, nullptr, &format, binary.data()); LOGOPENGLERROR();
+
+    std::error_code ec;
+    std::filesystem::create_directories(ProgramCacheDir, ec);
+    if (ec) {
+        LOGW << "Unable to create program cache directory " << ProgramCacheDir.string() << " : " << ec.message();
+        return;
+    }
+
+    ProgramCacheHeader header{ ProgramCacheMagic, ProgramCacheVersion, key,
+        static_cast<uint32_t>(format), static_cast<uint32_t>(length) };
+
+    // Write to a temporary file first so that an interrupted write never leaves a truncated entry
+    auto path = GetProgramCachePath(key);
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(binary.data(), binary.size());
+        if (!out) {
+            LOGW << "Unable to write program cache entry " << tmpPath.string();
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        LOGW << "Unable to store program cache entry " << path.string() << " : " << ec.message();
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+void Shader::SetProgramCacheDirectory(const std::filesystem::path& cache_dir) {
+    ProgramCacheDir = cache_dir;
+
+    if (ProgramCacheDir.empty()) {
+        LOGI << "Program binary cache : disabled";
+    }
+    else if (!IsProgramCacheAvailable()) {
+        LOGI << "Program binary cache : not supported by the driver";
+    }
+    else {
+        LOGI << "Program binary cache : " << ProgramCacheDir.string();
+    }
+}
+
 GLuint Shader::CreateProgram(const std::string& vertex_shader, const std::string& fragment_shader) {
     LOGI << "Shader Files: " << vertex_shader << " " << fragment_shader;
 
@@ -88,6 +235,16 @@ GLuint Shader::CreateProgramFromSource(const std::string& vertex_shader, const s
     const GLchar* vertexSource = vertex_shader.c_str();
     const GLchar* fragmentSource = fragment_shader.c_str();
 
+    const bool useCache = IsProgramCacheAvailable();
+    const uint64_t cacheKey = useCache ? HashProgramSources(vertex_shader, fragment_shader) : 0;
+    if (useCache) {
+        sProgram = LoadProgramBinary(cacheKey);
+        if (sProgram) {
+            LOGD << "Program binary loaded from cache";
+            return sProgram;
+        }
+    }
+
     vShader = glCreateShader(GL_VERTEX_SHADER); LOGOPENGLERROR();
     if (!vShader) {
         LOGE << "Unable to Create Vertex Shader";
@@ -125,6 +282,10 @@ GLuint Shader::CreateProgramFromSource(const std::string& vertex_shader, const s
     glAttachShader(sProgram, vShader); LOGOPENGLERROR();
     glAttachShader(sProgram, fShader); LOGOPENGLERROR();
 
+    if (useCache) {
+        glProgramParameteri(sProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); LOGOPENGLERROR();
+    }
+
     glLinkProgram(sProgram); LOGOPENGLERROR();
 
     glGetProgramiv(sProgram, GL_LINK_STATUS, &result); LOGOPENGLERROR();
@@ -136,6 +297,10 @@ GLuint Shader::CreateProgramFromSource(const std::string& vertex_shader, const s
     glDeleteShader(vShader); LOGOPENGLERROR();
     glDeleteShader(fShader); LOGOPENGLERROR();
 
+    if (useCache) {
+        SaveProgramBinary(sProgram, cacheKey);
+    }
+
     return sProgram;
 
 error:
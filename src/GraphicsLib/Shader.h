@@ -3,4 +3,8 @@
 namespace Shader {
     GLuint CreateProgram(const std::string& vertex_shader, const std::string& fragment_shader);
     GLuint CreateProgramFromSource(const std::string& vertex_shader, const std::string& fragment_shader);
+
+    // Store linked program binaries in the directory and reuse them on the next start.
+    // Requires a current OpenGL context. Empty path disables the cache.
+    void SetProgramCacheDirectory(const std::filesystem::path& cache_dir);
 }
@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include "GraphicsLogger.h"
+#include "TexturePool.h"
+
+struct TextureFormatInfo {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    size_t pixelSize;
+};
+
+// Sized formats supported by the pool, with the matching formats for glTexImage2D
+static const std::vector<TextureFormatInfo> TextureFormats = {
+    {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1},
+    {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2},
+    {GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3},
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, 4},
+    {GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT, 8},
+    {GL_R32F, GL_RED, GL_FLOAT, 4},
+};
+
+const TextureFormatInfo* FindTextureFormat(GLenum internalFormat) {
+    for (const auto& f : TextureFormats) {
+        if (f.internalFormat == internalFormat) {
+            return &f;
+        }
+    }
+    return nullptr;
+}
+
+
+namespace GraphicsUtils {
+
+TexturePool::~TexturePool() {
+    Trim();
+
+    if (!inUse_.empty()) {
+        LOGW << "Texture pool is destroyed with " << inUse_.size() << " textures in use";
+    }
+}
+
+GLuint TexturePool::Acquire(GLsizei width, GLsizei height, GLenum internalFormat) {
+    TextureKey key{ width, height, internalFormat };
+
+    GLuint texture = 0;
+
+    auto it = idle_.find(key);
+    if (it != idle_.end() && !it->second.empty()) {
+        texture = it->second.back();
+        it->second.pop_back();
+
+        stats_.reused++;
+        stats_.idle--;
+    }
+    else {
+        texture = Allocate(key);
+        if (!texture) {
+            return 0;
+        }
+    }
+
+    inUse_.emplace(texture, key);
+    stats_.inUse++;
+
+    return texture;
+}
+
+void TexturePool::Recycle(GLuint texture) {
+    auto it = inUse_.find(texture);
+    if (it == inUse_.end()) {
+        LOGW << "Texture " << texture << " doesn't belong to the pool";
+        return;
+    }
+
+    idle_[it->second].push_back(texture);
+    inUse_.erase(it);
+
+    stats_.inUse--;
+    stats_.idle++;
+}
+
+void TexturePool::Trim() {
+    for (auto& i : idle_) {
+        const auto* formatInfo = FindTextureFormat(i.first.internalFormat);
+        for (GLuint t : i.second) {
+            glDeleteTextures(1, &t); LOGOPENGLERROR();
+            stats_.bytes -= static_cast<size_t>(i.first.width) * i.first.height * formatInfo->pixelSize;
+        }
+    }
+
+    idle_.clear();
+    stats_.idle = 0;
+}
+
+const TexturePool::Stats& TexturePool::GetStats() const {
+    return stats_;
+}
+
+GLuint TexturePool::Allocate(const TextureKey& key) {
+    const auto* formatInfo = FindTextureFormat(key.internalFormat);
+    if (!formatInfo) {
+        LOGE << "Texture format " << key.internalFormat << " is not supported by the pool";
+        return 0;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture); LOGOPENGLERROR();
+    if (!texture) {
+        LOGE << "Failed to create texture";
+        return 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture); LOGOPENGLERROR();
+
+    if (GLAD_GL_VERSION_4_2) {
+        glTexStorage2D(GL_TEXTURE_2D, 1, key.internalFormat, key.width, key.height); LOGOPENGLERROR();
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, 0, key.internalFormat, key.width, key.height,
+            0, formatInfo->format, formatInfo->type, nullptr); LOGOPENGLERROR();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0); LOGOPENGLERROR();
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0); LOGOPENGLERROR();
+
+    stats_.allocated++;
+    stats_.bytes += static_cast<size_t>(key.width) * key.height * formatInfo->pixelSize;
+
+    LOGD << "Allocated texture " << key.width << "x" << key.height << " format " << key.internalFormat;
+
+    return texture;
+}
+
+} // namespace GraphicsUtils
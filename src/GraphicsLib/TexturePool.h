@@ -0,0 +1,56 @@
+#pragma once
+
+namespace GraphicsUtils {
+
+    // Pool of 2D textures with a single mip level, reused by size and format.
+    // Textures have immutable storage when glTexStorage2D is available.
+    class TexturePool {
+    public:
+        struct Stats {
+            size_t allocated{ 0 };  // Textures created since the start
+            size_t reused{ 0 };     // Requests served from idle textures
+            size_t inUse{ 0 };
+            size_t idle{ 0 };
+            size_t bytes{ 0 };      // Estimated memory of all textures of the pool
+        };
+
+    public:
+        TexturePool() = default;
+        ~TexturePool();
+
+        TexturePool(TexturePool const&) = delete;
+        TexturePool& operator=(TexturePool const&) = delete;
+
+        // Sized internal format is required, e.g. GL_R8 or GL_RGBA8. Returns 0 on failure
+        GLuint Acquire(GLsizei width, GLsizei height, GLenum internalFormat);
+
+        // Return the texture for reuse, the contents are kept undefined
+        void Recycle(GLuint texture);
+
+        // Free all idle textures
+        void Trim();
+
+        const Stats& GetStats() const;
+
+    private:
+        struct TextureKey {
+            GLsizei width;
+            GLsizei height;
+            GLenum internalFormat;
+
+            bool operator<(const TextureKey& other) const {
+                return std::tie(width, height, internalFormat) <
+                    std::tie(other.width, other.height, other.internalFormat);
+            }
+        };
+
+        GLuint Allocate(const TextureKey& key);
+
+    private:
+        std::map<TextureKey, std::vector<GLuint>> idle_;
+        std::map<GLuint, TextureKey> inUse_;
+
+        Stats stats_;
+    };
+
+}
@@ -5,6 +5,21 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <filesystem>
+#include <iomanip>
+#include <cstdint>
+#include <functional>
+#include <chrono>
+#include <limits>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
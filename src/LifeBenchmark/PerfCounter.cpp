@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "PerfCounter.h"
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+PerfCounter::~PerfCounter() {
+    Close();
+}
+
+#ifdef __linux__
+
+bool PerfCounter::Open(Event event) {
+    Close();
+
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    if (event == Event::TlbMisses) {
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+    else {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    }
+
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    return fd_ >= 0;
+}
+
+void PerfCounter::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    fd_ = -1;
+}
+
+void PerfCounter::Start() {
+    if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+uint64_t PerfCounter::Stop() {
+    uint64_t count = 0;
+    if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+            count = 0;
+        }
+    }
+    return count;
+}
+
+#else
+
+bool PerfCounter::Open(Event /*event*/) {
+    return false;
+}
+
+void PerfCounter::Close() {
+}
+
+void PerfCounter::Start() {
+}
+
+uint64_t PerfCounter::Stop() {
+    return 0;
+}
+
+#endif
+
+bool PerfCounter::IsOpen() const {
+    return fd_ >= 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Hardware event count of the process, including the worker threads started after Start.
+// Uses perf_event_open on Linux, where kernel.perf_event_paranoid may forbid it; the counter is
+// then not open and the benchmark leaves its column empty.
+class PerfCounter {
+public:
+    enum class Event {
+        TlbMisses,   // Data TLB misses of loads
+        CacheMisses, // Last level cache misses
+    };
+
+public:
+    PerfCounter() = default;
+    ~PerfCounter();
+
+    PerfCounter(PerfCounter const&) = delete;
+    PerfCounter& operator=(PerfCounter const&) = delete;
+
+    bool Open(Event event);
+    void Close();
+    bool IsOpen() const;
+
+    void Start();
+
+    // Events since Start, threads count once they have exited
+    uint64_t Stop();
+
+private:
+    int fd_{ -1 };
+};
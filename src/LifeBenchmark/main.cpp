@@ -0,0 +1,277 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "GridMemory.h"
+#include "Parallel.h"
+#include "RandomGenerator.h"
+#include "LifeEngine.h"
+#include "PaddedEngine.h"
+#include "BlockEngine.h"
+#include "PerfCounter.h"
+
+using CellularAutomata::GridMemoryPolicy;
+using CellularAutomata::HugePages;
+
+const std::string SizesArg = "--sizes";
+const std::string MemoryArg = "--memory";
+const std::string LayoutsArg = "--layouts";
+const std::string GenerationsArg = "--generations";
+const std::string ThreadsArg = "--threads";
+
+const std::filesystem::path TransparentHugePagesPath = "/sys/kernel/mm/transparent_hugepage/enabled";
+
+constexpr int WarmupGenerations = 2;
+
+struct MemoryConfig {
+    std::string name;
+    GridMemoryPolicy policy;
+};
+
+// Memory layout of the grid, each stepped by its own engine
+enum class GridLayout {
+    Rows,   // Bit-packed rows wrapped around in the kernel, LifeEngine
+    Padded, // Rows with ghost cells of the other side, PaddedEngine
+    Blocks, // 8x8 blocks of one word, BlockEngine
+};
+
+const std::vector<std::pair<std::string, GridLayout>> GridLayoutNames = {
+    { "rows", GridLayout::Rows },
+    { "padded", GridLayout::Padded },
+    { "blocks", GridLayout::Blocks },
+};
+
+struct Measurement {
+    double seconds{ 0.0 };
+    uint64_t tlbMisses{ 0 };
+    uint64_t cacheMisses{ 0 };
+};
+
+void PrintUsage() {
+    std::printf(
+        "Measure the CPU engines on square tori of several sizes, grid memory policies and layouts\n"
+        "\n"
+        "LifeBenchmark [options]\n"
+        "  --sizes LIST           Sides of the tori, 1024,4096,16384 by default\n"
+        "  --memory LIST          Memory of the grids, each of default, thp, hugetlb, numa or\n"
+        "                         numa+thp, numa+hugetlb; all that apply by default\n"
+        "  --layouts LIST         Layouts of the grids, each of rows, padded or blocks; all by default.\n"
+        "                         Speedups are relative to rows when it is measured first\n"
+        "  --generations N        Generations timed for each case, 50 by default\n"
+        "  --threads N            Worker threads, one per core by default\n");
+}
+
+std::vector<std::string> SplitList(const std::string& list, char separator) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, separator)) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool ParseMemoryConfig(const std::string& name, MemoryConfig& config) {
+    config = MemoryConfig{ name, GridMemoryPolicy() };
+    for (const auto& part : SplitList(name, '+')) {
+        if (part == "thp") {
+            config.policy.hugePages = HugePages::Transparent;
+        }
+        else if (part == "hugetlb") {
+            config.policy.hugePages = HugePages::Explicit;
+        }
+        else if (part == "numa") {
+            config.policy.numaBands = true;
+        }
+        else if (part != "default") {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParseGridLayout(const std::string& name, GridLayout& layout) {
+    for (const auto& [layoutName, value] : GridLayoutNames) {
+        if (layoutName == name) {
+            layout = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string ReadFirstLine(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line.empty() ? "unknown" : line;
+}
+
+Measurement MeasureSteps(const std::function<void()>& step, int generations, PerfCounter& tlb, PerfCounter& cache) {
+    for (int i = 0; i < WarmupGenerations; i++) {
+        step();
+    }
+
+    tlb.Start();
+    cache.Start();
+    const auto startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < generations; i++) {
+        step();
+    }
+    Measurement m;
+    m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    m.tlbMisses = tlb.Stop();
+    m.cacheMisses = cache.Stop();
+    return m;
+}
+
+// Events per million cells and generation, or n/a when the counter is unavailable
+std::string FormatEvents(const PerfCounter& counter, uint64_t events, double cellGenerations) {
+    if (!counter.IsOpen()) {
+        return "n/a";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f", events / cellGenerations * 1e6);
+    return text;
+}
+
+
+/*****************************************************************************
+ * Main program
+ ****************************************************************************/
+
+int main(int argc, const char* argv[]) {
+    plog::ConsoleAppender<plog::TxtFormatter> logger;
+    plog::init(plog::info, &logger);
+
+    std::vector<int> sizes = { 1024, 4096, 16384 };
+    std::vector<MemoryConfig> configs;
+    std::vector<GridLayout> layouts;
+    int generations = 50;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (argv[i] == SizesArg && hasValue) {
+            sizes.clear();
+            for (const auto& size : SplitList(argv[++i], ',')) {
+                sizes.push_back(std::max(std::atoi(size.c_str()), 1));
+            }
+        }
+        else if (argv[i] == MemoryArg && hasValue) {
+            for (const auto& name : SplitList(argv[++i], ',')) {
+                MemoryConfig config;
+                if (!ParseMemoryConfig(name, config)) {
+                    LOGE << "Invalid memory policy " << name;
+                    return EXIT_FAILURE;
+                }
+                configs.push_back(config);
+            }
+        }
+        else if (argv[i] == LayoutsArg && hasValue) {
+            for (const auto& name : SplitList(argv[++i], ',')) {
+                GridLayout layout;
+                if (!ParseGridLayout(name, layout)) {
+                    LOGE << "Invalid grid layout " << name;
+                    return EXIT_FAILURE;
+                }
+                layouts.push_back(layout);
+            }
+        }
+        else if (argv[i] == GenerationsArg && hasValue) {
+            generations = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (argv[i] == ThreadsArg && hasValue) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    const unsigned nodes = CellularAutomata::GetNumaNodeCount();
+    if (configs.empty()) {
+        std::vector<std::string> names = { "default", "thp", "hugetlb" };
+        if (nodes > 1) {
+            names.insert(names.end(), { "numa", "numa+thp" });
+        }
+        for (const auto& name : names) {
+            configs.emplace_back();
+            ParseMemoryConfig(name, configs.back());
+        }
+    }
+
+    if (layouts.empty()) {
+        for (const auto& [name, layout] : GridLayoutNames) {
+            layouts.push_back(layout);
+        }
+    }
+
+    PerfCounter tlb, cache;
+    tlb.Open(PerfCounter::Event::TlbMisses);
+    cache.Open(PerfCounter::Event::CacheMisses);
+
+    LOGI << "Worker threads: " << (threads ? threads : CellularAutomata::GetWorkerCount())
+        << ", NUMA nodes: " << nodes << ", transparent huge pages: " << ReadFirstLine(TransparentHugePagesPath);
+    if (!tlb.IsOpen() || !cache.IsOpen()) {
+        LOGW << "Hardware counters are unavailable, see kernel.perf_event_paranoid";
+    }
+
+    std::printf("%8s  %-14s %-8s %10s %10s %8s %16s %16s\n",
+        "Size", "Memory", "Layout", "Gens/s", "Cells/ns", "Speedup", "TLB miss/Mcell", "LLC miss/Mcell");
+    for (int size : sizes) {
+        const double cellGenerations = static_cast<double>(size) * size * generations;
+
+        for (const auto& config : configs) {
+            // The grids take the memory of the policy when they are allocated
+            CellularAutomata::SetGridMemoryPolicy(config.policy);
+
+            CellularAutomata::BitGrid grid(size, size);
+            CellularAutomata::GenerateFirstGeneration(grid,
+                { CellularAutomata::FirstGenerationType::UniformRandom, 1, 0.5f }, threads);
+
+            double rowsSeconds = 0.0;
+            for (GridLayout layout : layouts) {
+                Measurement m;
+                if (layout == GridLayout::Blocks) {
+                    if (!CellularAutomata::BlockEngine::IsSupportedSize(size, size)) {
+                        LOGW << "Skipping blocks for size " << size << ", not a multiple of "
+                            << CellularAutomata::BlockEngine::BlockSize;
+                        continue;
+                    }
+                    CellularAutomata::BlockEngine engine;
+                    engine.Load(grid, 0);
+                    m = MeasureSteps([&] { engine.Step(threads); }, generations, tlb, cache);
+                }
+                else if (layout == GridLayout::Padded) {
+                    CellularAutomata::PaddedEngine engine;
+                    engine.Load(grid, 0);
+                    m = MeasureSteps([&] { engine.Step(threads); }, generations, tlb, cache);
+                }
+                else {
+                    CellularAutomata::LifeEngine engine;
+                    engine.Load(grid, 0);
+                    m = MeasureSteps([&] { engine.Step(threads); }, generations, tlb, cache);
+                    rowsSeconds = m.seconds;
+                }
+
+                char speedup[16] = "-";
+                if (rowsSeconds > 0.0) {
+                    std::snprintf(speedup, sizeof(speedup), "%.2fx", rowsSeconds / m.seconds);
+                }
+
+                std::printf("%8d  %-14s %-8s %10.1f %10.2f %8s %16s %16s\n", size, config.name.c_str(),
+                    GridLayoutNames[static_cast<size_t>(layout)].first.c_str(),
+                    generations / m.seconds, cellGenerations / m.seconds * 1e-9, speedup,
+                    FormatEvents(tlb, m.tlbMisses, cellGenerations).c_str(),
+                    FormatEvents(cache, m.cacheMisses, cellGenerations).c_str());
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    CellularAutomata::SetGridMemoryPolicy(GridMemoryPolicy());
+    return EXIT_SUCCESS;
+}
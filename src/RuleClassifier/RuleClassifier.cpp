@@ -0,0 +1,193 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "EnsembleEngine.h"
+#include "PeriodDetector.h"
+#include "RuleClassifier.h"
+
+using CellularAutomata::BitGrid;
+using CellularAutomata::EnsembleEngine;
+
+// Universes stepped by a worker at once, small enough for the cache of a core
+constexpr size_t BatchUniverses = 1024;
+
+// Weight of the latest generation in the activity average
+constexpr double ActivitySmoothing = 1.0 / 16.0;
+
+constexpr double UniverseCells = EnsembleEngine::UniverseSize * EnsembleEngine::UniverseSize;
+
+const char* GetRuleBehaviourName(RuleBehaviour behaviour) {
+    switch (behaviour) {
+    case RuleBehaviour::Dies: return "dies";
+    case RuleBehaviour::Stabilises: return "stabilises";
+    case RuleBehaviour::Explodes: return "explodes";
+    case RuleBehaviour::Chaotic: return "chaotic";
+    }
+    return "";
+}
+
+// Shannon entropy of the 2x2 blocks of the universe, divided by the 4 bits of a block
+double GetBlockEntropy(const EnsembleEngine& engine, size_t universe) {
+    constexpr int size = EnsembleEngine::UniverseSize;
+
+    std::array<int, 16> histogram{};
+    for (int y = 0; y < size; y += 2) {
+        const BitGrid::Word low = engine.GetRow(universe, y);
+        const BitGrid::Word high = engine.GetRow(universe, y + 1);
+        for (int x = 0; x < size; x += 2) {
+            const int block = static_cast<int>(((low >> x) & 3) | (((high >> x) & 3) << 2));
+            histogram[block]++;
+        }
+    }
+
+    constexpr double blocks = (size / 2) * (size / 2);
+    double entropy = 0.0;
+    for (int n : histogram) {
+        if (n > 0) {
+            const double p = n / blocks;
+            entropy -= p * std::log2(p);
+        }
+    }
+    return entropy / 4.0;
+}
+
+
+RuleClassifier::RuleClassifier(const ClassifierParams& params)
+    : params_(params) {
+    params_.seeds = std::clamp(params_.seeds, 1, static_cast<int>(BatchUniverses));
+    params_.maxPeriod = std::max(params_.maxPeriod, 1u);
+}
+
+void RuleClassifier::Run(const std::vector<CellularAutomata::AutomatonRules>& rules, const Consumer& consume) {
+    rulesDone_ = 0;
+    universeGenerations_ = 0;
+
+    // Same soups for every rule
+    EnsembleEngine soups;
+    soups.Resize(static_cast<size_t>(params_.seeds));
+    soups.Randomize(params_.seed, params_.density);
+    soups_.resize(soups.GetCount());
+    for (size_t s = 0; s < soups_.size(); s++) {
+        soups.Store(s, soups_[s]);
+    }
+
+    const size_t rulesPerBatch = BatchUniverses / static_cast<size_t>(params_.seeds);
+    const size_t batchCount = (rules.size() + rulesPerBatch - 1) / rulesPerBatch;
+
+    // Batches finish out of order, summaries are passed on once all the previous ones are done
+    std::vector<RuleSummary> summaries(rules.size());
+    std::vector<bool> done(batchCount, false);
+    size_t nextBatch = 0;
+    std::mutex mutex;
+    std::atomic<size_t> takenBatches{ 0 };
+
+    const unsigned threads = params_.threads ? params_.threads : CellularAutomata::GetWorkerCount();
+
+    CellularAutomata::ParallelFor(threads, [&](size_t, size_t) {
+        for (size_t b = takenBatches++; b < batchCount; b = takenBatches++) {
+            const size_t first = b * rulesPerBatch;
+            const size_t count = std::min(rulesPerBatch, rules.size() - first);
+            ClassifyBatch(rules.data() + first, first, count, summaries);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            done[b] = true;
+            for (; nextBatch < batchCount && done[nextBatch]; nextBatch++) {
+                const size_t begin = nextBatch * rulesPerBatch;
+                const size_t end = std::min(begin + rulesPerBatch, rules.size());
+                for (size_t i = begin; i < end; i++) {
+                    consume(summaries[i]);
+                }
+            }
+        }
+    }, threads);
+}
+
+RuleClassifier::Progress RuleClassifier::GetProgress() const {
+    return Progress{ rulesDone_.load(), universeGenerations_.load() };
+}
+
+void RuleClassifier::ClassifyBatch(const CellularAutomata::AutomatonRules* rules, size_t first, size_t count,
+        std::vector<RuleSummary>& summaries) {
+    const size_t seeds = static_cast<size_t>(params_.seeds);
+    const size_t universes = count * seeds;
+
+    // Soup s of every rule starts from the same cells
+    EnsembleEngine engine;
+    engine.Resize(universes);
+    for (size_t u = 0; u < universes; u++) {
+        engine.SetRules(u, rules[u / seeds]);
+        engine.Load(u, soups_[u % seeds]);
+    }
+
+    CellularAutomata::EnsemblePeriodTracker tracker;
+    tracker.Reset(universes, params_.maxPeriod);
+    tracker.Observe(engine);
+
+    std::vector<double> activity(universes, 0.0);
+
+    // Nothing changes any more once every soup is periodic
+    uint64_t steps = 0;
+    while (engine.GetGeneration() < static_cast<uint64_t>(params_.generations) && tracker.GetEvolvingCount() > 0) {
+        engine.Step(1);
+        tracker.Observe(engine);
+        steps++;
+
+        for (size_t u = 0; u < universes; u++) {
+            const auto& stats = engine.GetStats(u);
+            const double changes = static_cast<double>(stats.births + stats.deaths) / UniverseCells;
+            activity[u] += (changes - activity[u]) * ActivitySmoothing;
+        }
+    }
+    universeGenerations_ += steps * universes;
+
+    for (size_t r = 0; r < count; r++) {
+        RuleSummary& summary = summaries[first + r];
+        summary = RuleSummary();
+        summary.index = first + r;
+        summary.rules = rules[r];
+
+        int stableCount = 0;
+        for (size_t s = 0; s < seeds; s++) {
+            const size_t u = r * seeds + s;
+            const double density = engine.GetStats(u).population / UniverseCells;
+
+            RuleBehaviour behaviour = RuleBehaviour::Chaotic;
+            if (engine.GetStats(u).population == 0) {
+                behaviour = RuleBehaviour::Dies;
+            }
+            else if (tracker.GetPeriod(u)) {
+                behaviour = RuleBehaviour::Stabilises;
+                summary.stableGeneration += static_cast<double>(tracker.GetStableGeneration(u));
+                summary.maxPeriod = std::max(summary.maxPeriod, tracker.GetPeriod(u));
+                stableCount++;
+            }
+            else if (density >= params_.density) {
+                behaviour = RuleBehaviour::Explodes;
+            }
+            summary.counts[static_cast<int>(behaviour)]++;
+
+            summary.density += density;
+            summary.entropy += GetBlockEntropy(engine, u);
+            summary.activity += activity[u];
+        }
+
+        summary.density /= static_cast<double>(seeds);
+        summary.entropy /= static_cast<double>(seeds);
+        summary.activity /= static_cast<double>(seeds);
+        if (stableCount > 0) {
+            summary.stableGeneration /= stableCount;
+        }
+
+        // Most frequent behaviour, ties go to the livelier one
+        int best = 0;
+        for (int b = 1; b < RuleBehaviourCount; b++) {
+            if (summary.counts[b] >= summary.counts[best]) {
+                best = b;
+            }
+        }
+        summary.behaviour = static_cast<RuleBehaviour>(best);
+    }
+
+    rulesDone_ += count;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Long-run behaviour of a rule from random soups
+enum class RuleBehaviour {
+    Dies = 0,       // Every cell dies
+    Stabilises = 1, // Still or periodic with a period up to the limit
+    Explodes = 2,   // Keeps evolving at the density of the soup or above, e.g. white noise
+    Chaotic = 3,    // Keeps evolving below the density of the soup
+};
+
+constexpr int RuleBehaviourCount = 4;
+
+const char* GetRuleBehaviourName(RuleBehaviour behaviour);
+
+struct ClassifierParams {
+    int seeds{ 16 };            // Soups per rule
+    int generations{ 1000 };    // Soups still evolving after that are explodes or chaotic
+    uint32_t maxPeriod{ 16 };
+    float density{ 0.375f };    // Of the soups
+    uint32_t seed{ 1 };         // Soup s of every rule starts from the seed + s
+    unsigned threads{ 0 };      // Zero is a thread per core
+};
+
+struct RuleSummary {
+    size_t index{ 0 };          // Position in the list of classified rules
+    CellularAutomata::AutomatonRules rules{ 0 };
+    RuleBehaviour behaviour{ RuleBehaviour::Dies };
+    std::array<int, RuleBehaviourCount> counts{};
+
+    // Means over the soups at the last generation
+    double density{ 0.0 };
+    double entropy{ 0.0 };      // Of 2x2 blocks, 0 for uniform cells and 1 for noise
+    double activity{ 0.0 };     // Births and deaths per cell and generation, averaged over recent ones
+    double stableGeneration{ 0.0 }; // Of the soups that stabilised
+
+    uint32_t maxPeriod{ 0 };
+};
+
+// Runs many soups of many rules in ensembles of 64x64 universes. Batches of rules
+// are spread over worker threads, each one steps its ensemble on its own.
+class RuleClassifier {
+public:
+    using Consumer = std::function<void(const RuleSummary& summary)>;
+
+    struct Progress {
+        size_t rules{ 0 };
+        uint64_t universeGenerations{ 0 };
+    };
+
+public:
+    explicit RuleClassifier(const ClassifierParams& params);
+
+    // Summaries are passed to the consumer one at a time in the order of the rules
+    void Run(const std::vector<CellularAutomata::AutomatonRules>& rules, const Consumer& consume);
+
+    // May be called from another thread while running
+    Progress GetProgress() const;
+
+private:
+    void ClassifyBatch(const CellularAutomata::AutomatonRules* rules, size_t first, size_t count,
+        std::vector<RuleSummary>& summaries);
+
+private:
+    ClassifierParams params_;
+    std::vector<CellularAutomata::BitGrid> soups_;
+
+    std::atomic<size_t> rulesDone_{ 0 };
+    std::atomic<uint64_t> universeGenerations_{ 0 };
+};
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Rules.h"
+#include "RuleClassifier.h"
+
+const std::string OutputArg = "--output";
+const std::string RulesArg = "--rules";
+const std::string FromArg = "--from";
+const std::string ToArg = "--to";
+const std::string NoB0Arg = "--no-b0";
+const std::string SeedsArg = "--seeds";
+const std::string GenerationsArg = "--generations";
+const std::string MaxPeriodArg = "--max-period";
+const std::string DensityArg = "--density";
+const std::string SeedArg = "--seed";
+const std::string ThreadsArg = "--threads";
+
+// Birth conditions in bits 0-8 of the rule code, survival ones in bits 9-17
+constexpr uint32_t RuleSpaceSize = 1u << 18;
+constexpr int SurviveShift = 9;
+
+constexpr double ProgressInterval = 10.0;
+
+void PrintUsage() {
+    std::printf(
+        "Classify B/S rules by running random soups of each one\n"
+        "\n"
+        "RuleClassifier [options]\n"
+        "  --output FILE        CSV file, rules.csv by default\n"
+        "  --rules LIST         Comma separated rules, e.g. B3/S23,B36/S23, instead of the rule space\n"
+        "  --from CODE          First rule code of the range, birth | survive << 9\n"
+        "  --to CODE            Rule code after the last one, 2^18 by default\n"
+        "  --no-b0              Skip rules with birth on 0 neighbours\n"
+        "  --seeds N            Soups per rule, 16 by default\n"
+        "  --generations N      Generations per soup, 1000 by default\n"
+        "  --max-period N       Longest period of stabilised soups, 16 by default\n"
+        "  --density D          Density of the soups, 0.375 by default\n"
+        "  --seed N             Soup s starts from the seed + s, 1 by default\n"
+        "  --threads N          Worker threads, one per core by default\n");
+}
+
+bool ParseRuleList(const std::string& list, std::vector<CellularAutomata::AutomatonRules>& rules) {
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        CellularAutomata::AutomatonRules r{ 0 };
+        if (!CellularAutomata::ParseRuleString(item, r)) {
+            LOGE << "Invalid rule " << item;
+            return false;
+        }
+        rules.push_back(r);
+    }
+    return true;
+}
+
+void WriteCsvHeader(std::ostream& out) {
+    out << "rule,birth,survive,class";
+    for (int b = 0; b < RuleBehaviourCount; b++) {
+        out << "," << GetRuleBehaviourName(static_cast<RuleBehaviour>(b));
+    }
+    out << ",density,entropy,activity,stable_generation,max_period\n";
+}
+
+void WriteCsvRow(std::ostream& out, const RuleSummary& s) {
+    char metrics[128];
+    std::snprintf(metrics, sizeof(metrics), "%.5f,%.5f,%.5f,%.1f,%u",
+        s.density, s.entropy, s.activity, s.stableGeneration, s.maxPeriod);
+
+    out << CellularAutomata::FormatRuleString(s.rules) << "," << s.rules.birth << "," << s.rules.survive << ","
+        << GetRuleBehaviourName(s.behaviour);
+    for (int n : s.counts) {
+        out << "," << n;
+    }
+    out << "," << metrics << "\n";
+}
+
+
+/*****************************************************************************
+ * Main program
+ ****************************************************************************/
+
+int main(int argc, const char* argv[]) {
+    plog::ConsoleAppender<plog::TxtFormatter> logger;
+    plog::init(plog::info, &logger);
+
+    std::filesystem::path outputPath = "rules.csv";
+    std::vector<CellularAutomata::AutomatonRules> rules;
+    uint32_t from = 0;
+    uint32_t to = RuleSpaceSize;
+    bool skipB0 = false;
+    ClassifierParams params;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (argv[i] == NoB0Arg) {
+            skipB0 = true;
+        }
+        else if (argv[i] == OutputArg && hasValue) {
+            outputPath = argv[++i];
+        }
+        else if (argv[i] == RulesArg && hasValue) {
+            if (!ParseRuleList(argv[++i], rules)) {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i] == FromArg && hasValue) {
+            from = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (argv[i] == ToArg && hasValue) {
+            to = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (argv[i] == SeedsArg && hasValue) {
+            params.seeds = std::atoi(argv[++i]);
+        }
+        else if (argv[i] == GenerationsArg && hasValue) {
+            params.generations = std::atoi(argv[++i]);
+        }
+        else if (argv[i] == MaxPeriodArg && hasValue) {
+            params.maxPeriod = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argv[i] == DensityArg && hasValue) {
+            params.density = std::strtof(argv[++i], nullptr);
+        }
+        else if (argv[i] == SeedArg && hasValue) {
+            params.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (argv[i] == ThreadsArg && hasValue) {
+            params.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (rules.empty()) {
+        for (uint32_t code = from; code < std::min(to, RuleSpaceSize); code++) {
+            const int birth = static_cast<int>(code & ((1u << SurviveShift) - 1));
+            if (skipB0 && (birth & 1)) {
+                continue;
+            }
+            rules.push_back(CellularAutomata::AutomatonRules{ 0, birth, static_cast<int>(code >> SurviveShift) });
+        }
+    }
+    if (rules.empty()) {
+        LOGE << "No rules to classify";
+        return EXIT_FAILURE;
+    }
+
+    // Written next to the output and renamed when complete, so an interrupted run leaves no partial file
+    std::filesystem::path tempPath = outputPath;
+    tempPath += ".tmp";
+    std::ofstream out(tempPath, std::ios::trunc);
+    if (!out) {
+        LOGE << "Unable to create " << tempPath.string();
+        return EXIT_FAILURE;
+    }
+    WriteCsvHeader(out);
+
+    LOGI << "Classifying " << rules.size() << " rules with " << params.seeds << " soups of " << params.generations
+        << " generations";
+
+    RuleClassifier classifier(params);
+    const auto startTime = std::chrono::steady_clock::now();
+    auto lastReport = startTime;
+
+    classifier.Run(rules, [&](const RuleSummary& summary) {
+        WriteCsvRow(out, summary);
+
+        const auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastReport).count() >= ProgressInterval) {
+            lastReport = now;
+
+            const auto progress = classifier.GetProgress();
+            const double seconds = std::chrono::duration<double>(now - startTime).count();
+            const double rulesPerSec = (summary.index + 1) / seconds;
+            LOGI << summary.index + 1 << " / " << rules.size() << " rules, " << rulesPerSec << " rules/s, "
+                << progress.universeGenerations / seconds / 1e6 << " M universe gens/s, "
+                << (rules.size() - summary.index - 1) / rulesPerSec / 60.0 << " min left";
+        }
+    });
+
+    out.close();
+    if (!out) {
+        LOGE << "Failed to write " << tempPath.string();
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, outputPath, ec);
+    if (ec) {
+        LOGE << "Unable to rename " << tempPath.string() << " to " << outputPath.string() << " : " << ec.message();
+        return EXIT_FAILURE;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    LOGI << rules.size() << " rules classified in " << seconds << " s, written to " << outputPath.string();
+
+    return EXIT_SUCCESS;
+}
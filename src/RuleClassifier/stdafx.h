@@ -0,0 +1,25 @@
+#pragma once
+
+#include <plog/Log.h>
+#include <plog/Init.h>
+#include <plog/Formatters/TxtFormatter.h>
+#include <plog/Appenders/ConsoleAppender.h>
+
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sstream>
@@ -0,0 +1,227 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "LifeEngine.h"
+#include "ObjectIdentifier.h"
+
+using CellularAutomata::BitGrid;
+
+using ObjectCells = std::vector<std::pair<int, int>>;
+
+// Rows of a strip of the extended Wechsler format, and the digits of the columns
+constexpr int WechslerStripRows = 5;
+const char WechslerDigits[] = "0123456789abcdefghijklmnopqrstuv";
+const char WechslerRunDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// Sort the cells and move the corner of their bounding box to the origin, returns the old corner
+std::pair<int, int> NormalizeObjectCells(ObjectCells& cells) {
+    std::pair<int, int> corner{ 0, 0 };
+    if (cells.empty()) {
+        return corner;
+    }
+
+    corner = cells.front();
+    for (const auto& c : cells) {
+        corner.first = std::min(corner.first, c.first);
+        corner.second = std::min(corner.second, c.second);
+    }
+    for (auto& c : cells) {
+        c.first -= corner.first;
+        c.second -= corner.second;
+    }
+
+    // Row by row, as the strips are encoded
+    std::sort(cells.begin(), cells.end(), [](const auto& a, const auto& b) {
+        return (a.second != b.second) ? a.second < b.second : a.first < b.first;
+    });
+    return corner;
+}
+
+// Strips of five rows, a digit per column, 'z' between the strips. Trailing zeros of a strip are
+// dropped and runs of zeros are shortened to w (2), x (3) and y followed by the count - 4.
+std::string EncodeWechsler(const ObjectCells& normalized) {
+    int width = 0;
+    int height = 0;
+    for (const auto& c : normalized) {
+        width = std::max(width, c.first + 1);
+        height = std::max(height, c.second + 1);
+    }
+
+    const int strips = (height + WechslerStripRows - 1) / WechslerStripRows;
+    std::vector<std::vector<int>> columns(strips, std::vector<int>(width, 0));
+    for (const auto& c : normalized) {
+        columns[c.second / WechslerStripRows][c.first] |= 1 << (c.second % WechslerStripRows);
+    }
+
+    std::string code;
+    for (int s = 0; s < strips; s++) {
+        if (s > 0) {
+            code += 'z';
+        }
+
+        int end = width;
+        while (end > 0 && columns[s][end - 1] == 0) {
+            end--;
+        }
+
+        int zeros = 0;
+        auto flushZeros = [&code, &zeros]() {
+            while (zeros >= 4) {
+                const int run = std::min(zeros - 4, 35);
+                code += 'y';
+                code += WechslerRunDigits[run];
+                zeros -= run + 4;
+            }
+            if (zeros == 3) {
+                code += 'x';
+            }
+            else if (zeros == 2) {
+                code += 'w';
+            }
+            else if (zeros == 1) {
+                code += '0';
+            }
+            zeros = 0;
+        };
+
+        for (int x = 0; x < end; x++) {
+            if (columns[s][x] == 0) {
+                zeros++;
+                continue;
+            }
+            flushZeros();
+            code += WechslerDigits[columns[s][x]];
+        }
+    }
+    return code;
+}
+
+// Shortest code, then the first one in the alphabetical order, over the phases and orientations
+std::string GetCanonicalCode(const std::vector<ObjectCells>& phases) {
+    std::string best;
+    for (const auto& phase : phases) {
+        for (int t = 0; t < 8; t++) {
+            ObjectCells cells = phase;
+            for (auto& c : cells) {
+                int x = (t & 1) ? -c.first : c.first;
+                int y = (t & 2) ? -c.second : c.second;
+                c = (t & 4) ? std::make_pair(y, x) : std::make_pair(x, y);
+            }
+            NormalizeObjectCells(cells);
+
+            std::string code = EncodeWechsler(cells);
+            if (best.empty() || code.size() < best.size() || (code.size() == best.size() && code < best)) {
+                best = code;
+            }
+        }
+    }
+    return best;
+}
+
+ObjectCells GetAliveCells(const BitGrid& grid) {
+    ObjectCells cells;
+    for (int y = 0; y < grid.GetHeight(); y++) {
+        const BitGrid::Word* row = grid.GetRow(y);
+        for (size_t j = 0; j < grid.GetWordsPerRow(); j++) {
+            for (BitGrid::Word w = row[j]; w; w &= w - 1) {
+                const int bit = static_cast<int>(std::bitset<64>((w & (0 - w)) - 1).count());
+                cells.emplace_back(static_cast<int>(j) * BitGrid::WordBits + bit, y);
+            }
+        }
+    }
+    return cells;
+}
+
+const char* GetObjectKindName(ObjectKind kind) {
+    switch (kind) {
+    case ObjectKind::StillLife: return "still life";
+    case ObjectKind::Oscillator: return "oscillator";
+    case ObjectKind::Spaceship: return "spaceship";
+    case ObjectKind::Unidentified: return "unidentified";
+    }
+    return "";
+}
+
+
+ObjectIdentifier::ObjectIdentifier(const CellularAutomata::AutomatonRules& rules, uint32_t maxPeriod)
+    : rules_(rules)
+    , maxPeriod_(std::max(maxPeriod, 1u)) {
+}
+
+const ObjectInfo& ObjectIdentifier::Identify(const Cells& cells) {
+    Cells normalized = cells;
+    NormalizeObjectCells(normalized);
+
+    std::string key = EncodeWechsler(normalized);
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        it = cache_.emplace(std::move(key), Evaluate(normalized)).first;
+    }
+    return it->second;
+}
+
+size_t ObjectIdentifier::GetCacheSize() const {
+    return cache_.size();
+}
+
+ObjectInfo ObjectIdentifier::Evaluate(const Cells& normalized) {
+    int width = 0;
+    int height = 0;
+    for (const auto& c : normalized) {
+        width = std::max(width, c.first + 1);
+        height = std::max(height, c.second + 1);
+    }
+
+    // Nothing travels faster than a cell per generation
+    const int margin = static_cast<int>(maxPeriod_) + 2;
+    const int size = (std::max(width, height) + 2 * margin + BitGrid::WordBits - 1) / BitGrid::WordBits *
+        BitGrid::WordBits;
+
+    const int x0 = (size - width) / 2;
+    const int y0 = (size - height) / 2;
+    BitGrid grid(size, size);
+    for (const auto& c : normalized) {
+        grid.Set(x0 + c.first, y0 + c.second, true);
+    }
+
+    CellularAutomata::LifeEngine engine;
+    engine.SetRules(rules_);
+    engine.Load(grid, 0);
+
+    ObjectInfo info;
+    std::vector<Cells> phases{ normalized };
+    for (uint32_t k = 1; k <= maxPeriod_; k++) {
+        engine.Step(1);
+        if (engine.GetStats().population == 0) {
+            break;
+        }
+
+        Cells cells = GetAliveCells(engine.GetGrid());
+        const auto corner = NormalizeObjectCells(cells);
+        if (cells == normalized) {
+            info.period = k;
+            info.dx = corner.first - x0;
+            info.dy = corner.second - y0;
+            break;
+        }
+        phases.push_back(std::move(cells));
+    }
+
+    if (info.period == 0) {
+        info.kind = ObjectKind::Unidentified;
+        info.code = "zz_" + GetCanonicalCode({ normalized });
+    }
+    else if (info.dx != 0 || info.dy != 0) {
+        info.kind = ObjectKind::Spaceship;
+        info.code = "xq" + std::to_string(info.period) + "_" + GetCanonicalCode(phases);
+    }
+    else if (info.period > 1) {
+        info.kind = ObjectKind::Oscillator;
+        info.code = "xp" + std::to_string(info.period) + "_" + GetCanonicalCode(phases);
+    }
+    else {
+        info.kind = ObjectKind::StillLife;
+        info.code = "xs" + std::to_string(normalized.size()) + "_" + GetCanonicalCode(phases);
+    }
+    return info;
+}
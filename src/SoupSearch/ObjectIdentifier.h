@@ -0,0 +1,43 @@
+#pragma once
+
+enum class ObjectKind {
+    StillLife,
+    Oscillator,
+    Spaceship,
+    Unidentified, // Didn't repeat in isolation within the period limit, e.g. a piece of a larger object
+};
+
+const char* GetObjectKindName(ObjectKind kind);
+
+struct ObjectInfo {
+    // apgcode-style name, xs<population>_, xp<period>_ or xq<period>_ followed by the extended
+    // Wechsler code of the smallest phase and orientation, the same for every phase and orientation
+    std::string code;
+    ObjectKind kind{ ObjectKind::Unidentified };
+    uint32_t period{ 0 };
+    int dx{ 0 };
+    int dy{ 0 };
+};
+
+// Identifies isolated objects by running them alone on a torus large enough to
+// never wrap within the period limit. Results are cached by the shape of the object.
+class ObjectIdentifier {
+public:
+    ObjectIdentifier(const CellularAutomata::AutomatonRules& rules, uint32_t maxPeriod);
+
+    // Cells are relative to any origin, an object may not be larger than half of its torus
+    const ObjectInfo& Identify(const std::vector<std::pair<int, int>>& cells);
+
+    size_t GetCacheSize() const;
+
+private:
+    using Cells = std::vector<std::pair<int, int>>;
+
+    ObjectInfo Evaluate(const Cells& cells);
+
+private:
+    CellularAutomata::AutomatonRules rules_;
+    uint32_t maxPeriod_;
+
+    std::unordered_map<std::string, ObjectInfo> cache_;
+};
@@ -0,0 +1,215 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Parallel.h"
+#include "RandomGenerator.h"
+#include "LifeEngine.h"
+#include "Components.h"
+#include "ObjectIdentifier.h"
+#include "SoupSearch.h"
+
+using CellularAutomata::BitGrid;
+
+// Soups run by a worker between the merges of its census
+constexpr uint64_t SoupsPerChunk = 64;
+
+// The population is checked for a period every few generations only
+constexpr int PopulationCheckInterval = 16;
+
+// Smallest period of the population history up to the limit. The last 2 * maxPeriod
+// values must repeat, so the history holds 3 * maxPeriod values with the latest at head - 1.
+uint32_t FindPopulationPeriod(const std::vector<uint64_t>& history, size_t head, uint32_t maxPeriod) {
+    const size_t size = history.size();
+    auto at = [&](size_t age) { return history[(head + size - 1 - age) % size]; };
+
+    for (uint32_t p = 1; p <= maxPeriod; p++) {
+        bool repeats = true;
+        for (size_t i = 0; i < 2 * static_cast<size_t>(maxPeriod) && repeats; i++) {
+            repeats = (at(i) == at(i + p));
+        }
+        if (repeats) {
+            return p;
+        }
+    }
+    return 0;
+}
+
+
+SoupSearch::SoupSearch(const SearchParams& params)
+    : params_(params) {
+    params_.universeSize = std::max((params_.universeSize + BitGrid::WordBits - 1) / BitGrid::WordBits, 1) *
+        BitGrid::WordBits;
+    params_.maxPeriod = std::max(params_.maxPeriod, 1u);
+}
+
+void SoupSearch::Run(const Reporter& report, double reportInterval) {
+    const unsigned threads = params_.threads ? params_.threads : CellularAutomata::GetWorkerCount();
+    const auto startTime = std::chrono::steady_clock::now();
+    auto lastReport = startTime;
+
+    census_.clear();
+    progress_ = Progress();
+    progress_.threads = threads;
+
+    std::atomic<uint64_t> nextChunk{ 0 };
+    const uint64_t chunks = (params_.soups + SoupsPerChunk - 1) / SoupsPerChunk;
+
+    CellularAutomata::ParallelFor(threads, [&](size_t, size_t) {
+        CellularAutomata::LifeEngine engine;
+        engine.SetRules(params_.rules);
+        ObjectIdentifier identifier(params_.rules, params_.maxPeriod);
+
+        for (uint64_t c = nextChunk++; c < chunks; c = nextChunk++) {
+            Census census;
+            uint64_t generations = 0;
+            uint64_t objects = 0;
+            uint64_t unstabilised = 0;
+
+            const uint64_t begin = c * SoupsPerChunk;
+            const uint64_t end = std::min(begin + SoupsPerChunk, params_.soups);
+            for (uint64_t i = begin; i < end; i++) {
+                if (!RunSoup(params_.firstSoup + i, engine, identifier, census, generations, objects)) {
+                    unstabilised++;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            Merge(census);
+            progress_.soups += end - begin;
+            progress_.unstabilised += unstabilised;
+            progress_.objects += objects;
+            progress_.generations += generations;
+
+            const auto now = std::chrono::steady_clock::now();
+            progress_.seconds = std::chrono::duration<double>(now - startTime).count();
+            if (std::chrono::duration<double>(now - lastReport).count() >= reportInterval) {
+                lastReport = now;
+                report(progress_);
+            }
+        }
+    }, threads);
+
+    progress_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+const std::map<std::string, CensusEntry>& SoupSearch::GetCensus() const {
+    return census_;
+}
+
+SoupSearch::Progress SoupSearch::GetProgress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progress_;
+}
+
+void SoupSearch::GenerateSoup(uint32_t seed, uint64_t index, BitGrid& grid) {
+    const int x0 = (grid.GetWidth() - SoupSize) / 2;
+    const int y0 = (grid.GetHeight() - SoupSize) / 2;
+
+    // Each Philox output holds two rows of the soup
+    for (uint32_t i = 0; i < SoupSize / 4; i++) {
+        const auto bits = CellularAutomata::Philox2x32(static_cast<uint32_t>(index),
+            (static_cast<uint32_t>(index >> 32) << 3) | i, seed);
+        for (int half = 0; half < 2; half++) {
+            for (int r = 0; r < 2; r++) {
+                const uint32_t row = (bits[half] >> (SoupSize * r)) & 0xffff;
+                const int y = y0 + static_cast<int>(i) * 4 + half * 2 + r;
+                grid.OrBits(x0, y, row, SoupSize);
+            }
+        }
+    }
+}
+
+bool SoupSearch::RunSoup(uint64_t index, CellularAutomata::LifeEngine& engine, ObjectIdentifier& identifier,
+        Census& census, uint64_t& generations, uint64_t& objects) {
+    const int size = params_.universeSize;
+    const uint32_t maxPeriod = params_.maxPeriod;
+
+    BitGrid grid(size, size);
+    GenerateSoup(params_.seed, index, grid);
+    engine.Load(grid, 0);
+
+    std::vector<uint64_t> history(3 * static_cast<size_t>(maxPeriod), 0);
+    size_t head = 0;
+    uint32_t period = 0;
+    for (int g = 1; g <= params_.maxGenerations && !period; g++) {
+        engine.Step(1);
+        history[head] = engine.GetStats().population;
+        head = (head + 1) % history.size();
+
+        if (g >= static_cast<int>(history.size()) && g % PopulationCheckInterval == 0) {
+            period = FindPopulationPeriod(history, head, maxPeriod);
+        }
+    }
+    generations += engine.GetGeneration();
+
+    if (!period) {
+        return false;
+    }
+
+    // Cells ever alive during a cycle, so that the phases of an object are one group
+    BitGrid mask = engine.GetGrid();
+    for (uint32_t i = 0; i < period; i++) {
+        engine.Step(1);
+        const BitGrid& cells = engine.GetGrid();
+        for (size_t w = 0; w < mask.GetDataSize(); w++) {
+            mask.GetData()[w] |= cells.GetData()[w];
+        }
+    }
+    generations += period;
+
+    std::vector<uint32_t> labels;
+    const size_t count = CellularAutomata::LabelComponents(mask, labels);
+    if (count == 0) {
+        return true;
+    }
+
+    // Cells of every object relative to its first cell, unwrapped around the torus
+    std::vector<std::vector<std::pair<int, int>>> objectCells(count);
+    std::vector<std::pair<int, int>> origins(count);
+    const BitGrid& cells = engine.GetGrid();
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const uint32_t label = labels[static_cast<size_t>(y) * size + x];
+            if (!label) {
+                continue;
+            }
+            auto& object = objectCells[label - 1];
+            if (object.empty()) {
+                origins[label - 1] = { x, y };
+            }
+            if (cells.Get(x, y)) {
+                const auto& o = origins[label - 1];
+                const int dx = (x - o.first + size + size / 2) % size - size / 2;
+                const int dy = (y - o.second + size + size / 2) % size - size / 2;
+                object.emplace_back(dx, dy);
+            }
+        }
+    }
+
+    for (const auto& object : objectCells) {
+        if (object.empty()) {
+            continue;
+        }
+        const ObjectInfo& info = identifier.Identify(object);
+
+        CensusEntry& entry = census[info.code];
+        if (entry.count == 0 || index < entry.firstSoup) {
+            entry.firstSoup = index;
+        }
+        entry.count++;
+        entry.kind = info.kind;
+        objects++;
+    }
+    return true;
+}
+
+void SoupSearch::Merge(const Census& census) {
+    for (const auto& [code, entry] : census) {
+        CensusEntry& total = census_[code];
+        if (total.count == 0 || entry.firstSoup < total.firstSoup) {
+            total.firstSoup = entry.firstSoup;
+        }
+        total.count += entry.count;
+        total.kind = entry.kind;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+struct SearchParams {
+    CellularAutomata::AutomatonRules rules{ 0, 8, 12 }; // B3/S23
+    uint32_t seed{ 1 };             // Soup n is generated from the seed and n
+    uint64_t firstSoup{ 0 };
+    uint64_t soups{ 1000000 };
+    int universeSize{ 128 };        // Torus the soups evolve in, a multiple of 64
+    int maxGenerations{ 30000 };    // Soups that don't stabilise by then are counted, not censused
+    uint32_t maxPeriod{ 30 };       // Of the ash and of the objects
+    unsigned threads{ 0 };          // Zero is a thread per core
+};
+
+struct CensusEntry {
+    uint64_t count{ 0 };
+    uint64_t firstSoup{ 0 };        // Soup that produced the object first
+    ObjectKind kind{ ObjectKind::Unidentified };
+};
+
+// Runs 16x16 random soups until the population repeats with a period up to the limit,
+// splits the ash into connected objects and counts them by their canonical codes.
+// Soups are spread over worker threads, each one keeps its own census and merges it periodically.
+class SoupSearch {
+public:
+    static constexpr int SoupSize = 16;
+
+    struct Progress {
+        uint64_t soups{ 0 };
+        uint64_t unstabilised{ 0 };
+        uint64_t objects{ 0 };
+        uint64_t generations{ 0 };
+        double seconds{ 0.0 };
+        unsigned threads{ 1 };
+    };
+
+    using Reporter = std::function<void(const Progress& progress)>;
+
+public:
+    explicit SoupSearch(const SearchParams& params);
+
+    // The reporter is called from a worker thread at most once per interval
+    void Run(const Reporter& report, double reportInterval);
+
+    const std::map<std::string, CensusEntry>& GetCensus() const;
+    Progress GetProgress() const;
+
+    // Cells of the soup, row by row, as placed in the middle of the universe
+    static void GenerateSoup(uint32_t seed, uint64_t index, CellularAutomata::BitGrid& grid);
+
+private:
+    using Census = std::map<std::string, CensusEntry>;
+
+    // Returns false if the soup didn't stabilise
+    bool RunSoup(uint64_t index, CellularAutomata::LifeEngine& engine, ObjectIdentifier& identifier,
+        Census& census, uint64_t& generations, uint64_t& objects);
+
+    void Merge(const Census& census);
+
+private:
+    SearchParams params_;
+
+    mutable std::mutex mutex_;
+    Census census_;
+    Progress progress_;
+};
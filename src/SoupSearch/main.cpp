@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Rules.h"
+#include "LifeEngine.h"
+#include "ObjectIdentifier.h"
+#include "SoupSearch.h"
+
+const std::string OutputArg = "--output";
+const std::string RuleArg = "--rule";
+const std::string SoupsArg = "--soups";
+const std::string FirstSoupArg = "--first-soup";
+const std::string SeedArg = "--seed";
+const std::string SizeArg = "--size";
+const std::string MaxGenerationsArg = "--max-generations";
+const std::string MaxPeriodArg = "--max-period";
+const std::string ThreadsArg = "--threads";
+
+constexpr double ProgressInterval = 10.0;
+
+// Objects listed in the log at the end
+constexpr size_t SummaryObjectCount = 10;
+
+void PrintUsage() {
+    std::printf(
+        "Run random 16x16 soups and count the objects they leave\n"
+        "\n"
+        "SoupSearch [options]\n"
+        "  --output FILE          CSV file, census.csv by default\n"
+        "  --rule RULE            Rule of the soups, B3/S23 by default\n"
+        "  --soups N              Soups to run, 1000000 by default\n"
+        "  --first-soup N         Index of the first soup, 0 by default\n"
+        "  --seed N               Seed of the soups, 1 by default\n"
+        "  --size N               Side of the torus the soups evolve in, 128 by default\n"
+        "  --max-generations N    Soups not stable by then are skipped, 30000 by default\n"
+        "  --max-period N         Longest period of the ash and its objects, 30 by default\n"
+        "  --threads N            Worker threads, one per core by default\n");
+}
+
+void LogProgress(const SoupSearch::Progress& p) {
+    const double soupsPerSec = p.seconds > 0.0 ? p.soups / p.seconds : 0.0;
+    LOGI << p.soups << " soups, " << soupsPerSec << " soups/s, " << soupsPerSec / p.threads << " soups/s/core, "
+        << p.objects << " objects, " << p.unstabilised << " unstabilised, "
+        << (p.soups ? p.generations / p.soups : 0) << " gens/soup";
+}
+
+
+/*****************************************************************************
+ * Main program
+ ****************************************************************************/
+
+int main(int argc, const char* argv[]) {
+    plog::ConsoleAppender<plog::TxtFormatter> logger;
+    plog::init(plog::info, &logger);
+
+    std::filesystem::path outputPath = "census.csv";
+    SearchParams params;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (argv[i] == OutputArg && hasValue) {
+            outputPath = argv[++i];
+        }
+        else if (argv[i] == RuleArg && hasValue) {
+            const std::string rule = argv[++i];
+            if (!CellularAutomata::ParseRuleString(rule, params.rules)) {
+                LOGE << "Invalid rule " << rule;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i] == SoupsArg && hasValue) {
+            params.soups = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i] == FirstSoupArg && hasValue) {
+            params.firstSoup = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i] == SeedArg && hasValue) {
+            params.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (argv[i] == SizeArg && hasValue) {
+            params.universeSize = std::atoi(argv[++i]);
+        }
+        else if (argv[i] == MaxGenerationsArg && hasValue) {
+            params.maxGenerations = std::atoi(argv[++i]);
+        }
+        else if (argv[i] == MaxPeriodArg && hasValue) {
+            params.maxPeriod = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argv[i] == ThreadsArg && hasValue) {
+            params.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (params.universeSize < 2 * SoupSearch::SoupSize) {
+        LOGE << "The universe must be at least " << 2 * SoupSearch::SoupSize << " cells wide";
+        return EXIT_FAILURE;
+    }
+
+    LOGI << "Running " << params.soups << " soups of " << CellularAutomata::FormatRuleString(params.rules)
+        << " on a " << params.universeSize << "x" << params.universeSize << " torus";
+
+    SoupSearch search(params);
+    search.Run(LogProgress, ProgressInterval);
+    LogProgress(search.GetProgress());
+
+    std::vector<std::pair<std::string, CensusEntry>> census(search.GetCensus().begin(), search.GetCensus().end());
+    std::stable_sort(census.begin(), census.end(), [](const auto& a, const auto& b) {
+        return a.second.count > b.second.count;
+    });
+
+    // Written next to the output and renamed when complete, so an interrupted run leaves no partial file
+    std::filesystem::path tempPath = outputPath;
+    tempPath += ".tmp";
+    std::ofstream out(tempPath, std::ios::trunc);
+    if (!out) {
+        LOGE << "Unable to create " << tempPath.string();
+        return EXIT_FAILURE;
+    }
+
+    out << "code,count,kind,first_soup\n";
+    for (const auto& [code, entry] : census) {
+        out << code << "," << entry.count << "," << GetObjectKindName(entry.kind) << "," << entry.firstSoup << "\n";
+    }
+
+    out.close();
+    if (!out) {
+        LOGE << "Failed to write " << tempPath.string();
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, outputPath, ec);
+    if (ec) {
+        LOGE << "Unable to rename " << tempPath.string() << " to " << outputPath.string() << " : " << ec.message();
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < std::min(census.size(), SummaryObjectCount); i++) {
+        LOGI << census[i].first << " " << census[i].second.count;
+    }
+    LOGI << census.size() << " distinct objects written to " << outputPath.string();
+
+    return EXIT_SUCCESS;
+}
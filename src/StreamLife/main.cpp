@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include "CellularAutomata.h"
+#include "BitGrid.h"
+#include "Rules.h"
+#include "StreamEngine.h"
+
+const std::string CreateArg = "--create";
+const std::string RuleArg = "--rule";
+const std::string SeedArg = "--seed";
+const std::string DensityArg = "--density";
+const std::string GenerationsArg = "--generations";
+const std::string BandArg = "--band-mb";
+const std::string ThreadsArg = "--threads";
+
+constexpr double MB = 1024.0 * 1024.0;
+
+void PrintUsage() {
+    std::printf(
+        "Step a grid stored in a file, for grids larger than the memory\n"
+        "\n"
+        "StreamLife FILE [options]\n"
+        "  --create WxH           Create the file with a new grid first\n"
+        "  --rule RULE            Rule of a new grid, B3/S23 by default\n"
+        "  --seed N               Seed of a new grid, 1 by default\n"
+        "  --density D            Fraction of alive cells of a new grid, 0 for empty, 0.5 by default\n"
+        "  --generations N        Generations to step, 1 by default\n"
+        "  --band-mb N            Memory of a band of rows, 64 by default\n"
+        "  --threads N            Worker threads, one per core by default\n");
+}
+
+bool ParseSize(const std::string& str, int& width, int& height) {
+    char* end = nullptr;
+    const long w = std::strtol(str.c_str(), &end, 10);
+    if (*end != 'x') {
+        return false;
+    }
+    const long h = std::strtol(end + 1, &end, 10);
+    if (*end != '\0' || w <= 0 || h <= 0 || w > std::numeric_limits<int>::max() || h > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    return true;
+}
+
+
+/*****************************************************************************
+ * Main program
+ ****************************************************************************/
+
+int main(int argc, const char* argv[]) {
+    plog::ConsoleAppender<plog::TxtFormatter> logger;
+    plog::init(plog::info, &logger);
+
+    if (argc < 2) {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    const std::filesystem::path path = argv[1];
+    bool create = false;
+    int width = 0, height = 0;
+    CellularAutomata::AutomatonRules rules{ 0, 8, 12 }; // B3/S23
+    CellularAutomata::FirstGenerationParams params{ CellularAutomata::FirstGenerationType::UniformRandom, 1, 0.5f };
+    uint64_t generations = 1;
+    size_t bandBytes = CellularAutomata::StreamEngine::DefaultBandBytes;
+    unsigned threads = 0;
+
+    for (int i = 2; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (argv[i] == CreateArg && hasValue) {
+            if (!ParseSize(argv[++i], width, height)) {
+                LOGE << "Invalid grid size " << argv[i];
+                return EXIT_FAILURE;
+            }
+            create = true;
+        }
+        else if (argv[i] == RuleArg && hasValue) {
+            const std::string rule = argv[++i];
+            if (!CellularAutomata::ParseRuleString(rule, rules)) {
+                LOGE << "Invalid rule " << rule;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i] == SeedArg && hasValue) {
+            params.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (argv[i] == DensityArg && hasValue) {
+            params.density = std::strtof(argv[++i], nullptr);
+        }
+        else if (argv[i] == GenerationsArg && hasValue) {
+            generations = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i] == BandArg && hasValue) {
+            bandBytes = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024 * 1024;
+        }
+        else if (argv[i] == ThreadsArg && hasValue) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (create) {
+        if (params.density <= 0.0f) {
+            params.type = CellularAutomata::FirstGenerationType::Empty;
+        }
+
+        LOGI << "Creating a " << width << "x" << height << " grid of " << CellularAutomata::FormatRuleString(rules)
+            << " in " << path.string();
+        const auto startTime = std::chrono::steady_clock::now();
+        if (!CellularAutomata::StreamEngine::Create(path, width, height, rules, params, threads)) {
+            return EXIT_FAILURE;
+        }
+        const std::chrono::duration<double> createTime = std::chrono::steady_clock::now() - startTime;
+        LOGI << "Created in " << createTime.count() << " s";
+    }
+
+    CellularAutomata::StreamEngine engine;
+    if (!engine.Open(path, bandBytes)) {
+        return EXIT_FAILURE;
+    }
+
+    const double gridMB = static_cast<double>(engine.GetHeight()) *
+        ((engine.GetWidth() + CellularAutomata::BitGrid::WordBits - 1) / CellularAutomata::BitGrid::WordBits) *
+        sizeof(CellularAutomata::BitGrid::Word) / MB;
+    LOGI << engine.GetWidth() << "x" << engine.GetHeight() << " grid of " << CellularAutomata::FormatRuleString(engine.GetRules())
+        << " at generation " << engine.GetGeneration() << ", " << gridMB << " MB in bands of " << engine.GetBandRows() << " rows";
+
+    for (uint64_t g = 0; g < generations; g++) {
+        if (!engine.Step(threads)) {
+            return EXIT_FAILURE;
+        }
+
+        const auto& stats = engine.GetStats();
+        const auto& io = engine.GetIoStats();
+        const double seconds = std::max(io.seconds, 1e-9);
+        LOGI << "Gen. " << engine.GetGeneration() << ": population " << stats.population
+            << ", " << io.seconds << " s, streamed " << (io.bytesRead + io.bytesWritten) / MB / seconds << " MB/s"
+            << ", storage read " << io.storageRead / MB / seconds << " MB/s"
+            << ", written " << io.storageWritten / MB / seconds << " MB/s";
+    }
+
+    return EXIT_SUCCESS;
+}